@@ -0,0 +1,195 @@
+//	File:			batch.cpp
+//	Description:	The implementation of batch mode (see batch.h). Directories are walked with the Windows find
+//					functions or POSIX readdir, depending on the platform.
+
+#include "batch.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <mutex>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+static const char ENCODED_EXTENSION[] = ".huf";
+
+static bool hasEncodedExtension(const string &path)
+{
+	size_t length = sizeof(ENCODED_EXTENSION) - 1;
+	return path.size() > length && path.compare(path.size() - length, length, ENCODED_EXTENSION) == 0;
+}
+
+static uint64_t fileSize(const string &path)
+{
+	/*	The size of a file from its directory entry, without opening it (0 if it can't be found). */
+#if defined(_WIN32)
+	struct _stat64 info;
+	if (_stat64(path.c_str(), &info) != 0) return 0;
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0) return 0;
+#endif
+	return uint64_t(info.st_size);
+}
+
+static void walkDirectory(const string &directory, vector<string> &paths)
+{
+	/*	Adds the path of every file under the directory (and its subdirectories) to paths.
+	*/
+#if defined(_WIN32)
+	WIN32_FIND_DATAA entry;
+	HANDLE find_handle = FindFirstFileA((directory + "\\*").c_str(), &entry);
+	if (find_handle == INVALID_HANDLE_VALUE) return;
+	do
+	{
+		string name = entry.cFileName;
+		if (name == "." || name == "..") continue;
+		string path = directory + "\\" + name;
+		if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) walkDirectory(path, paths);
+		else paths.push_back(path);
+	} while (FindNextFileA(find_handle, &entry));
+	FindClose(find_handle);
+#else
+	DIR* directory_handle = opendir(directory.c_str());
+	if (directory_handle == NULL) return;
+	while (dirent* entry = readdir(directory_handle))
+	{
+		string name = entry->d_name;
+		if (name == "." || name == "..") continue;
+		string path = directory + "/" + name;
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0) continue;
+		if (S_ISDIR(info.st_mode)) walkDirectory(path, paths);
+		else if (S_ISREG(info.st_mode)) paths.push_back(path);
+	}
+	closedir(directory_handle);
+#endif
+}
+
+bool listBatchFiles(const string &source, BatchCommand command, vector<string> &paths)
+{
+	/*	A directory gives every file under it: the .huf files to decode them, or every other file to
+		encode them (so running the same batch again doesn't encode its own output). Anything else is
+		read as a list file, with one path per line, used just as it is.
+	*/
+	struct stat info;
+	if (stat(source.c_str(), &info) != 0) return false;
+	if ((info.st_mode & S_IFMT) == S_IFDIR)
+	{
+		vector<string> found;
+		walkDirectory(source, found);
+		for (const string &path : found)
+		{
+			if (hasEncodedExtension(path) == (command == BATCH_DECODE)) paths.push_back(path);
+		}
+		sort(paths.begin(), paths.end());
+		return true;
+	}
+
+	ifstream list(source);
+	if (!list) return false;
+	string line;
+	while (getline(list, line))
+	{
+		if (!line.empty() && line.back() == '\r') line.pop_back();	// Allow lists with Windows line endings.
+		if (!line.empty()) paths.push_back(line);
+	}
+	return true;
+}
+
+string batchOutputPath(const string &input_path, BatchCommand command)
+{
+	/*	Unlike a single file, the extension of the input is kept, so files that only differ
+		by extension (such as app.log and app.txt) don't write to the same output.
+	*/
+	if (command != BATCH_DECODE) return input_path + ENCODED_EXTENSION;
+	if (hasEncodedExtension(input_path)) return input_path.substr(0, input_path.size() - (sizeof(ENCODED_EXTENSION) - 1));
+	return input_path + ".out";
+}
+
+BatchReport runBatch(BatchCommand command, const vector<string> &paths, const HuffmanOptions &options, const string &tree_path)
+{
+	/*	Gives the files to options.threads workers (one per hardware thread by default), which take the
+		next file as they finish the last. Each worker's Huffman works on one thread, since the files
+		themselves are spread between the threads. A file that fails is reported on cerr and counted,
+		and the rest of the batch carries on.
+	*/
+	auto begin = chrono::steady_clock::now();
+	if (command == BATCH_TRAIN)							// Training makes one output from every file, so there is nothing to fail file by file.
+	{
+		Huffman trainer;
+		trainer.setOptions(options);
+		trainer.MakeTreeBuilder(paths, tree_path);
+		BatchReport report;
+		report.files = paths.size();
+		for (const string &path : paths) report.bytes_in += fileSize(path);
+		report.bytes_out = fileSize(tree_path);
+		report.stats = trainer.stats();
+		report.seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+		return report;
+	}
+
+	unsigned int thread_count = options.threads > 0 ? options.threads : defaultThreadCount();
+	HuffmanOptions worker_options = options;
+	worker_options.threads = 1;
+
+	unique_ptr<HuffmanCode> shared_tree;
+	if (command == BATCH_ENCODE_WITH_TREE)
+	{
+		Huffman tree_reader;
+		shared_tree.reset(new HuffmanCode(tree_reader.readTreeFile(tree_path)));
+	}
+
+	vector<unique_ptr<Huffman>> workers;
+	for (unsigned int i = 0; i < thread_count; i++)
+	{
+		workers.emplace_back(new Huffman());
+		workers.back()->setOptions(worker_options);
+	}
+	vector<BatchReport> worker_reports(thread_count);
+	vector<pair<size_t, string>> errors;				// Kept until the end, so the messages of different threads aren't mixed together.
+	mutex errors_lock;
+
+	parallelForWorkers(paths.size(), thread_count, [&](unsigned int worker, size_t i)
+	{
+		Huffman &huffman = *workers[worker];
+		BatchReport &report = worker_reports[worker];
+		string output_path = batchOutputPath(paths[i], command);
+		report.files++;
+		try
+		{
+			if (command == BATCH_ENCODE) huffman.EncodeFile(paths[i], output_path);
+			else if (command == BATCH_DECODE) huffman.DecodeFile(paths[i], output_path);
+			else huffman.EncodeFileWithTree(paths[i], *shared_tree, output_path);
+			report.bytes_in += fileSize(paths[i]);
+			report.bytes_out += fileSize(output_path);
+		}
+		catch (const HuffmanError &error)
+		{
+			lock_guard<mutex> lock(errors_lock);
+			errors.emplace_back(i, error.what());
+			report.failed++;
+		}
+	});
+
+	BatchReport total;
+	for (const BatchReport &report : worker_reports)
+	{
+		total.files += report.files;
+		total.failed += report.failed;
+		total.bytes_in += report.bytes_in;
+		total.bytes_out += report.bytes_out;
+	}
+	for (const unique_ptr<Huffman> &worker : workers) total.stats.add(worker->stats());
+	sort(errors.begin(), errors.end());					// Report the failures in the order of the list.
+	for (const pair<size_t, string> &error : errors) cerr << paths[error.first] << ": " << error.second << endl;
+	total.seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	return total;
+}
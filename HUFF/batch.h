@@ -0,0 +1,37 @@
+//	File:			batch.h
+//	Description:	Batch mode: encoding or decoding many files in one process. The files are shared between a pool
+//					of worker threads, and each worker keeps its own Huffman from file to file, so the trees and
+//					buffers are reused rather than made again for every file. A shared tree (from an .htree file)
+//					is read once and used by every worker. With -t, the files are samples that one shared tree is
+//					trained from instead.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "huffman.h"
+using namespace std;
+
+enum BatchCommand
+{
+	BATCH_ENCODE,									// -e: each file with its own tree, into the file name with .huf added.
+	BATCH_DECODE,									// -d: each file into its name with .huf taken off (or .out added).
+	BATCH_ENCODE_WITH_TREE,							// -et: each file with the shared tree, into the file name with .huf added.
+	BATCH_TRAIN										// -t: one tree (and its cached tables) for all of the files, into the tree file given.
+};
+
+struct BatchReport
+{
+	/*	The totals of a batch, for the throughput report. */
+
+	size_t files = 0;								// The number of files worked on (including those that failed).
+	size_t failed = 0;								// The number of files that could not be encoded or decoded.
+	uint64_t bytes_in = 0;
+	uint64_t bytes_out = 0;
+	double seconds = 0;
+	HuffmanStats stats;								// The counters of every worker added together (with the stats option).
+};
+
+bool listBatchFiles(const string &source, BatchCommand command, vector<string> &paths);	// Reads the paths from a list file (one per line), or finds the files under a directory. Returns false if it can't be read.
+string batchOutputPath(const string &input_path, BatchCommand command);				// The path a file's output is written to.
+BatchReport runBatch(BatchCommand command, const vector<string> &paths, const HuffmanOptions &options, const string &tree_path);	// Encodes, decodes or trains from every file. Throws a HuffmanError if the tree file can't be used (or made).
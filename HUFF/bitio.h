@@ -0,0 +1,146 @@
+//	File:			bitio.h
+//	Description:	Helpers for moving bits in and out of the encoded files. Contains the byte order helpers used by
+//					the decoder, and the BitWriter that the encoder packs codes into.
+//					Everything here is inline, as it sits in the innermost encoding and decoding loops.
+
+#pragma once
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include "fileio.h"
+using namespace std;
+
+static inline uint64_t loadBigEndian64(const unsigned char* bytes)
+{
+	/*	Loads 8 bytes as a big endian (first byte most significant) 64-bit value.
+		Compilers turn this into a single load and byte swap.
+	*/
+	uint64_t value;
+	memcpy(&value, bytes, 8);
+#if defined(_MSC_VER)
+	return _byteswap_uint64(value);
+#else
+	return __builtin_bswap64(value);
+#endif
+}
+
+static inline void storeBigEndian64(unsigned char* bytes, uint64_t value)
+{
+	/*	Stores a 64-bit value as 8 big endian bytes (most significant byte first).
+	*/
+#if defined(_MSC_VER)
+	value = _byteswap_uint64(value);
+#else
+	value = __builtin_bswap64(value);
+#endif
+	memcpy(bytes, &value, 8);
+}
+
+static inline void storeLittleEndian32(unsigned char* bytes, uint32_t value)
+{
+	/*	Stores a 32-bit value as 4 little endian bytes (used by the file headers).
+	*/
+	for (int i = 0; i < 4; i++) bytes[i] = (unsigned char)(value >> (8 * i));
+}
+
+static inline void storeLittleEndian64(unsigned char* bytes, uint64_t value)
+{
+	/*	Stores a 64-bit value as 8 little endian bytes (used by the file headers).
+	*/
+	for (int i = 0; i < 8; i++) bytes[i] = (unsigned char)(value >> (8 * i));
+}
+
+static inline uint32_t loadLittleEndian32(const unsigned char* bytes)
+{
+	/*	Loads 4 little endian bytes as a 32-bit value.
+	*/
+	uint32_t value = 0;
+	for (int i = 3; i >= 0; i--) value = (value << 8) | bytes[i];
+	return value;
+}
+
+static inline uint64_t loadLittleEndian64(const unsigned char* bytes)
+{
+	/*	Loads 8 little endian bytes as a 64-bit value.
+	*/
+	uint64_t value = 0;
+	for (int i = 7; i >= 0; i--) value = (value << 8) | bytes[i];
+	return value;
+}
+
+class BitWriter
+{
+	/*	Packs codes into bytes, most significant bit first, and writes them to a ByteSink in large blocks.
+		Bits are collected in a 64-bit accumulator. After each code is added, the accumulator is stored as a
+		whole 8 byte word and the output pointer moves forward by the number of complete bytes, so at most
+		7 bits are ever left waiting. The partially filled byte is simply stored again by the next code.
+	*/
+public:
+	static const unsigned int MAX_CODE_LENGTH = 56;		// The longest code putBits accepts at once.
+
+	BitWriter(ByteSink &sink, size_t block_size) : output_sink(sink), block(block_size + 8)
+	{
+		output = block.data();
+		output_limit = block.data() + block_size;		// The 8 extra bytes let a word be stored at the end of the block.
+	}
+
+	inline void putBits(uint64_t bits, unsigned int length)
+	{
+		/*	Adds a code of 1 to MAX_CODE_LENGTH bits (right aligned in bits) to the output.
+		*/
+		bit_buffer = (bit_buffer << length) | bits;
+		bit_count += length;
+		storeBigEndian64(output, bit_buffer << (64 - bit_count));	// Store the waiting bits, left aligned, as a whole word.
+		output += bit_count >> 3;						// Move past the complete bytes.
+		bit_count &= 7;
+		if (output >= output_limit) flushBlock();
+	}
+
+	uint64_t bitsWritten() const
+	{
+		/*	The number of bits added so far (including any padding).
+		*/
+		return (flushed_bytes + uint64_t(output - block.data())) * 8 + bit_count;
+	}
+
+	unsigned int pendingBits() const
+	{
+		/*	The number of bits waiting in the last, incomplete byte (0-7).
+		*/
+		return bit_count;
+	}
+
+	void finish()
+	{
+		/*	Writes out everything still in the block. An incomplete last byte is written with 0 bits after it.
+		*/
+		if (bit_count > 0)
+		{
+			output++;									// The incomplete byte was already stored by putBits.
+			bit_count = 0;
+		}
+		flushBlock();
+	}
+
+private:
+	ByteSink &output_sink;								// Where the packed bytes are written to.
+	vector<unsigned char> block;						// The block that packed bytes are collected in before they are written.
+	unsigned char* output;								// The next byte of the block to be written.
+	unsigned char* output_limit;						// Once output passes this point, the block is written.
+	uint64_t bit_buffer = 0;							// The accumulator. Only the lowest bit_count bits have not been written as whole bytes.
+	unsigned int bit_count = 0;							// The number of bits in the accumulator not yet moved past.
+	uint64_t flushed_bytes = 0;							// The number of bytes already written to the sink.
+
+	void flushBlock()
+	{
+		/*	Writes all of the complete bytes in the block, and moves the incomplete byte (if any) to the front.
+		*/
+		size_t complete_bytes = output - block.data();
+		output_sink.write(block.data(), complete_bytes);
+		flushed_bytes += complete_bytes;
+		block[0] = block[complete_bytes];					// Keep the incomplete byte, it is stored again by the next code.
+		output = block.data();
+	}
+};
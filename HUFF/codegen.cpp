@@ -0,0 +1,207 @@
+//	File:			codegen.cpp
+//	Description:	The code generator for frozen trees (HUFF -g). It writes a C++ header holding one tree's codes and
+//					decode table as constexpr arrays, with an encoder and decoder written for that tree: the encoder
+//					merges as many codes as always fit in one BitWriter::putBits, and the decoder makes as many table
+//					lookups as one refill of its bit buffer always covers, with the steps written out one by one. A
+//					program that always uses the same tree can include the header, and has nothing to parse or build.
+
+#include "huffman.h"
+#include <sstream>
+#include <cctype>
+#include <algorithm>
+
+static string identifierFor(const string &path)
+{
+	/*	Makes a C++ identifier from the name of a file (without its directory or extension),
+		for the namespace of the generated code.
+	*/
+	size_t name_start = path.find_last_of("/\\");
+	string name = path.substr(name_start == string::npos ? 0 : name_start + 1);
+	name = name.substr(0, name.find('.'));
+	for (char &c : name)
+	{
+		if (!isalnum((unsigned char)c)) c = '_';
+	}
+	if (name.empty() || isdigit((unsigned char)name[0])) name = "tree_" + name;
+	return name;
+}
+
+static void writeArray(ostringstream &text, const string &declaration, const vector<uint64_t> &values, bool hexadecimal, const string &comment)
+{
+	/*	Writes a constexpr array of the values, 16 to a line (8 for hexadecimal), indented for the namespace.
+	*/
+	size_t per_line = hexadecimal ? 8 : 16;
+	text << "\tconstexpr " << declaration << " = {";
+	if (!comment.empty()) text << "\t// " << comment;
+	text << "\n";
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		if (i % per_line == 0) text << "\t\t";
+		if (hexadecimal) text << "0x" << hex << values[i] << dec;
+		else text << values[i];
+		if (i + 1 < values.size()) text << (i % per_line == per_line - 1 ? ",\n" : ", ");
+	}
+	text << "\n\t};\n";
+}
+
+string HuffmanTree::codeHeader(const string &name, const string &file_name, const string &tree_path) const
+{
+	/*	Writes the header for this tree, whose code and decode tables must already be built. Every
+		number the loops depend on (the group size, the steps per refill, whether there are long codes
+		or subtables) is worked out here, so the generated code only has what this tree needs.
+	*/
+	unsigned int longest = 0;
+	for (int i = 0; i < 256; i++)
+	{
+		if (code_table[i].length > longest) longest = code_table[i].length;
+	}
+	unsigned int group = longest <= ENCODE_PAIR_LENGTH ? BitWriter::MAX_CODE_LENGTH / longest : 1;	// The codes of group bytes always fit in one putBits.
+	if (group > 8) group = 8;
+	unsigned int steps = 56 / DECODE_TABLE_BITS;					// A refill leaves at least 56 bits, and a primary entry uses at most DECODE_TABLE_BITS.
+	bool long_codes = longest > BitWriter::MAX_CODE_LENGTH;
+	bool subtables = decode_table.size() > (size_t(1) << DECODE_TABLE_BITS);
+
+	vector<unsigned char> header(headerSize());
+	writeHeader(header.data());
+	vector<uint64_t> header_values(header.begin(), header.end()), codes(256), lengths(256), padding(8, 0), table(decode_table.begin(), decode_table.end());
+	for (int i = 0; i < 256; i++)
+	{
+		codes[i] = code_table[i].length <= BitWriter::MAX_CODE_LENGTH ? code_table[i].bits : 0;
+		lengths[i] = code_table[i].length;
+	}
+	for (unsigned int used = 1; used < 8; used++)					// The same padding as padFinalByte.
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			if (code_table[i].length > 8 - used)
+			{
+				padding[used] = codePrefix((unsigned char)(i), 8 - used);
+				break;
+			}
+		}
+	}
+	vector<uint64_t> children;
+	for (uint16_t n = 256; n < node_count; n++)
+	{
+		children.push_back(nodes[n].LCH);
+		children.push_back(nodes[n].RCH);
+	}
+
+	ostringstream text;
+	text << "//\tFile:\t\t\t" << file_name << "\n";
+	text << "//\tDescription:\tA codec for the tree in " << tree_path << ", generated by HUFF -g. Its tables are constexpr and its\n";
+	text << "//\t\t\t\t\tloops are written for this tree's codes, so there is nothing to build before it is used. encode and\n";
+	text << "//\t\t\t\t\tdecode match HuffmanCode's, and a .huf file is TREE_HEADER followed by encode's bits. Generate it\n";
+	text << "//\t\t\t\t\tagain whenever the tree file changes.\n\n";
+	text << "#pragma once\n#include <vector>\n#include <cstdint>\n#include \"bitio.h\"\n\n";
+	text << "namespace " << name << "\n{\n";
+	text << "\tconstexpr size_t TREE_HEADER_SIZE = " << header.size() << ";\n";
+	text << "\tconstexpr unsigned int LONGEST_CODE = " << longest << ";\n";
+	writeArray(text, "unsigned char TREE_HEADER[TREE_HEADER_SIZE]", header_values, false, "The header of the tree file, which also starts every .huf file encoded with the tree.");
+	writeArray(text, "uint64_t CODES[256]", codes, true, long_codes ? "The bits of each byte value's code, right aligned (0 for codes longer than 56 bits, which are in LONG_CODES)." : "The bits of each byte value's code, right aligned.");
+	writeArray(text, "unsigned char LENGTHS[256]", lengths, false, "");
+	if (long_codes)
+	{
+		vector<uint64_t> long_words(256 * 4, 0);
+		for (int i = 0; i < 256; i++)
+		{
+			if (code_table[i].length > BitWriter::MAX_CODE_LENGTH) copy(&long_code_table[i * 4], &long_code_table[i * 4] + 4, &long_words[i * 4]);
+		}
+		writeArray(text, "uint64_t LONG_CODES[256 * 4]", long_words, true, "Codes longer than 56 bits, left aligned in 4 words each.");
+	}
+	writeArray(text, "uint64_t PADDING[8]", padding, true, "The bits that fill out the last byte once 1 to 7 of its bits are used.");
+	writeArray(text, "uint32_t DECODE_TABLE[" + to_string(decode_table.size()) + "]", table, true,
+		"The " + to_string(DECODE_TABLE_BITS) + " bit primary table" + (subtables ? ", then the subtables of longer codes" : "") + " (laid out as in HuffmanTree::buildDecodeTable).");
+	text << "\tconstexpr uint16_t ROOT = " << root_node << ";\n";
+	writeArray(text, "uint16_t CHILDREN[" + to_string(node_count - 256) + "][2]", children, false, "The left and right child of each node after the 256 leaves, for the last few codes.");
+
+	text << "\n\tinline void encode(const unsigned char* data, size_t size, vector<unsigned char> &output)\n\t{\n";
+	text << "\t\t/*\tAdds the codes of the bytes to the end of output, padding the last byte.";
+	if (group > 1) text << " The codes of " << group << " bytes\n\t\t\talways fit in one putBits, so they are merged first.";
+	text << "\n\t\t*/\n";
+	text << "\t\tVectorSink sink(output);\n\t\tBitWriter writer(sink, 64 << 10);\n\t\tsize_t i = 0;\n";
+	if (group > 1)
+	{
+		string bits = "CODES[data[i]]", length = "LENGTHS[data[i]]";
+		for (unsigned int g = 1; g < group; g++)
+		{
+			string byte = "data[i + " + to_string(g) + "]";
+			bits = "(" + bits + " << LENGTHS[" + byte + "] | CODES[" + byte + "])";
+			length += " + LENGTHS[" + byte + "]";
+		}
+		text << "\t\tfor (; i + " << group << " <= size; i += " << group << ") writer.putBits(" << bits << ", " << length << ");\n";
+	}
+	if (long_codes)
+	{
+		text << "\t\tfor (; i < size; i++)\n\t\t{\n";
+		text << "\t\t\tunsigned int length = LENGTHS[data[i]];\n";
+		text << "\t\t\tif (length <= BitWriter::MAX_CODE_LENGTH)\n\t\t\t{\n\t\t\t\twriter.putBits(CODES[data[i]], length);\n\t\t\t\tcontinue;\n\t\t\t}\n";
+		text << "\t\t\tconst uint64_t* words = &LONG_CODES[size_t(data[i]) * 4];\t// 32 bits at a time, as HuffmanTree::putLongCode does.\n";
+		text << "\t\t\tfor (unsigned int position = 0; position < length; position += 32)\n\t\t\t{\n";
+		text << "\t\t\t\tuint64_t chunk = (words[position / 64] >> (32 - position % 64)) & 0xFFFFFFFF;\n";
+		text << "\t\t\t\tunsigned int chunk_length = length - position < 32 ? length - position : 32;\n";
+		text << "\t\t\t\twriter.putBits(chunk >> (32 - chunk_length), chunk_length);\n\t\t\t}\n\t\t}\n";
+	}
+	else text << "\t\tfor (; i < size; i++) writer.putBits(CODES[data[i]], LENGTHS[data[i]]);\n";
+	text << "\t\tif (writer.pendingBits() != 0) writer.putBits(PADDING[writer.pendingBits()], 8 - writer.pendingBits());\n";
+	text << "\t\twriter.finish();\n\t}\n";
+
+	string consume = "\t\t\tbit_buffer <<= (entry >> 16) & 0xFF;\n\t\t\tbit_count -= (entry >> 16) & 0xFF;\n";
+	string refill = "bit_buffer |= loadBigEndian64(input) >> bit_count;\n\t\t\tinput += (63 - bit_count) >> 3;\n\t\t\tbit_count |= 56;\n";
+	text << "\n\tinline void decode(const unsigned char* encoded, size_t size, vector<unsigned char> &output)\n\t{\n";
+	text << "\t\t/*\tAdds the bytes decoded from encode's bits to the end of output, dropping the padding. Each refill\n";
+	text << "\t\t\tof the bit buffer is followed by " << steps << " lookups of the primary table, which is as many as it always covers.\n";
+	if (subtables) text << "\t\t\tA longer code goes on through the subtables, and refills again after it.\n";
+	text << "\t\t\tThe last bytes of input are decoded by walking the tree, as HuffmanTree::decodeBits does.\n\t\t*/\n";
+	text << "\t\tconst size_t BLOCK_SIZE = 64 << 10;\n";
+	text << "\t\tconst unsigned char* input = encoded;\n";
+	text << "\t\tconst unsigned char* input_limit = size > " << DECODE_SAFE_BYTES << " ? encoded + size - " << DECODE_SAFE_BYTES << " : encoded;\n";
+	text << "\t\tunsigned char block[BLOCK_SIZE + " << 2 * steps << "];\n\t\tunsigned char* next = block;\n";
+	text << "\t\tuint64_t bit_buffer = 0;\n\t\tunsigned int bit_count = 0;\n";
+	text << "\t\twhile (input < input_limit)\n\t\t{\n";
+	text << "\t\t\tif (next - block >= ptrdiff_t(BLOCK_SIZE))\n\t\t\t{\n\t\t\t\toutput.insert(output.end(), block, next);\n\t\t\t\tnext = block;\n\t\t\t}\n";
+	text << "\t\t\t" << refill << "\t\t\tuint32_t entry;\n";
+	for (unsigned int step = 0; step < steps; step++)
+	{
+		text << "\n\t\t\tentry = DECODE_TABLE[bit_buffer >> " << 64 - DECODE_TABLE_BITS << "];\n";
+		if (subtables)
+		{
+			text << "\t\t\tif (((entry >> 24) & 3) == 0)\n\t\t\t{\n";
+			text << "\t\t\t\tdo\n\t\t\t\t{\n";
+			text << "\t\t\t\t\tbit_buffer <<= (entry >> 16) & 0xFF;\n\t\t\t\t\tbit_count -= (entry >> 16) & 0xFF;\n";
+			text << "\t\t\t\t\tif (bit_count < 32)\n\t\t\t\t\t{\n\t\t\t\t\t\tbit_buffer |= loadBigEndian64(input) >> bit_count;\n\t\t\t\t\t\tinput += (63 - bit_count) >> 3;\n\t\t\t\t\t\tbit_count |= 56;\n\t\t\t\t\t}\n";
+			text << "\t\t\t\t\tentry = DECODE_TABLE[" << (size_t(1) << DECODE_TABLE_BITS) << " + (entry & 0xFFFF) + (bit_buffer >> (64 - ((entry >> 26) & 0xF)))];\n";
+			text << "\t\t\t\t} while (((entry >> 24) & 3) == 0);\n";
+			text << "\t\t\t\t*next++ = (unsigned char)(entry);\n";
+			text << "\t\t\t\tbit_buffer <<= (entry >> 16) & 0xFF;\n\t\t\t\tbit_count -= (entry >> 16) & 0xFF;\n";
+			text << "\t\t\t\tcontinue;\t\t\t\t\t\t\t\t\t\t// The buffer may be short of the next steps' bits.\n\t\t\t}\n";
+		}
+		text << "\t\t\tnext[0] = (unsigned char)(entry);\n\t\t\tnext[1] = (unsigned char)(entry >> 8);\n\t\t\tnext += (entry >> 24) & 3;\n" << consume;
+	}
+	text << "\t\t}\n\n";
+	text << "\t\tsize_t bit_position = size_t(input - encoded) * 8 - bit_count;\n";
+	text << "\t\tuint16_t node = ROOT;\n";
+	text << "\t\tfor (size_t end_position = size * 8; bit_position < end_position; bit_position++)\n\t\t{\n";
+	text << "\t\t\tnode = CHILDREN[node - 256][(encoded[bit_position >> 3] >> (7 - (bit_position & 7))) & 1];\n";
+	text << "\t\t\tif (node >= 256) continue;\n";
+	text << "\t\t\t*next++ = (unsigned char)(node);\n\t\t\tnode = ROOT;\n";
+	text << "\t\t\tif (next - block >= ptrdiff_t(BLOCK_SIZE))\n\t\t\t{\n\t\t\t\toutput.insert(output.end(), block, next);\n\t\t\t\tnext = block;\n\t\t\t}\n\t\t}\n";
+	text << "\t\toutput.insert(output.end(), block, next);\n\t}\n}\n";
+	return text.str();
+}
+
+void Huffman::MakeCodeHeader(string TreeFile, string outputFile)
+{
+	/*	Loads a tree file (or its cached tables) and writes the header of a codec specialized for its
+		tree, in a namespace named after the header file. Throws a HuffmanError if the tree file can't
+		be read or isn't valid, or the header can't be written.
+	*/
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	HuffmanCode code = readTreeFile(TreeFile);
+	size_t name_start = outputFile.find_last_of("/\\");
+	string text = code.tree->codeHeader(identifierFor(outputFile), outputFile.substr(name_start == string::npos ? 0 : name_start + 1), TreeFile);
+	OutputFile file_output;
+	openOutput(file_output, outputFile);
+	file_output.write((const unsigned char*)(text.data()), text.size());
+	closeOutput(file_output, outputFile);
+}
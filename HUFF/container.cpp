@@ -0,0 +1,700 @@
+//	File:			container.cpp
+//	Description:	The Huffman methods that encode and decode the block container format described in container.h.
+//					Blocks are handled in batches: every block in a batch is encoded (or decoded) on its own thread
+//					into its own buffer, then the buffers are written out in order.
+
+#include "huffman.h"
+#include "crc32c.h"
+
+bool Huffman::isContainer(InputFile &file_input)
+{
+	/*	Checks if the file starts with the container's magic number. The bytes are only
+		peeked at, so a legacy file can still be read from the start (even from a pipe).
+	*/
+	unsigned char magic[4];
+	if (file_input.peek(magic, 4) < 4) return false;
+	return memcmp(magic, CONTAINER_MAGIC, 4) == 0;
+}
+
+static size_t blockHeaderSize(unsigned char flags)
+{
+	/*	The size of every block header of a file with the given container flags. */
+	return flags & CONTAINER_FLAG_CHECKSUM ? BLOCK_HEADER_SIZE + BLOCK_CHECKSUM_SIZE : BLOCK_HEADER_SIZE;
+}
+
+static bool hasTreeHeader(unsigned char block_type)
+{
+	/*	Whether a block's payload starts with a tree header. */
+	return block_type == BLOCK_HUFFMAN || block_type == BLOCK_STREAMS;
+}
+
+static bool reusesTree(unsigned char block_type)
+{
+	/*	Whether a block is coded with the tree of the last block before it with a tree header. */
+	return block_type == BLOCK_REUSE || block_type == BLOCK_REUSE_STREAMS;
+}
+
+static void splitStreams(size_t size, size_t part_sizes[HuffmanTree::INTERLEAVED_STREAMS])
+{
+	/*	Splits a block of size bytes into the parts that are encoded as separate streams. Every
+		part but the last is rounded up, so the last part is the smallest (and may be empty).
+	*/
+	size_t part_size = (size + HuffmanTree::INTERLEAVED_STREAMS - 1) / HuffmanTree::INTERLEAVED_STREAMS;
+	for (size_t i = 0; i < HuffmanTree::INTERLEAVED_STREAMS; i++)
+	{
+		part_sizes[i] = size < part_size ? size : part_size;
+		size -= part_sizes[i];
+	}
+}
+
+void Huffman::reserveBlockTrees(size_t count)
+{
+	/*	Adds block trees until there are count of them (plus the carried_tree). Trees are only ever added,
+		so once the largest batch has been seen, blocks are coded with no allocation for their trees.
+	*/
+	while (block_trees.size() < count) block_trees.emplace_back(new HuffmanTree());
+	while (block_models.size() < count) block_models.emplace_back(new ContextModel());
+	if (!carried_tree) carried_tree.reset(new HuffmanTree());
+}
+
+void Huffman::buildBlockTree(HuffmanTree &tree, const unsigned char* data, size_t size, const vector<unsigned char>* tree_header, uint64_t counts[256])
+{
+	/*	Makes the tree (and code table) for one block of input: its own tree made from its own byte
+		counts, unless a tree header is given to use instead. The counts are kept in counts (which must
+		start at zero) when they are given, since the adaptive option needs them to choose a block type.
+		This runs on a worker thread, so everything it uses (including the tree) belongs to the block.
+	*/
+	uint64_t block_counts[256] = { 0 };
+	if (counts == NULL) counts = block_counts;
+	if (tree_header != NULL)
+	{
+		PhaseTimer timer(stats_counters.get(), PHASE_TREE);
+		tree.readHeader(tree_header->data(), tree_header->size());	// The header was already checked when it was read.
+	}
+	if (tree_header == NULL || counts != block_counts)
+	{
+		PhaseTimer timer(stats_counters.get(), PHASE_FREQUENCY);
+		countBytes(data, size, counts);					// Blocks are already spread between threads, so each is counted on one.
+	}
+	if (tree_header == NULL)
+	{
+		tree.setWeights(counts);
+		createTree(tree);
+	}
+	PhaseTimer timer(stats_counters.get(), PHASE_CODE_TABLES);
+	tree.createCodeTable();
+}
+
+unsigned char Huffman::chooseBlockType(const HuffmanTree &tree, const HuffmanTree* previous_tree, const ContextModel* model, const uint64_t counts[256], size_t size)
+{
+	/*	Picks the smallest way to store a block: with its own tree, with the tree of the last block
+		that had one (previous_tree, if there is one), with its context model (model, if there is one),
+		or (with the adaptive option) as it is. The encoded sizes come from the code lengths and the
+		block's counts, so nothing is encoded to find them. Ties go to the option with less work:
+		storing the bytes, then reusing a tree (which has no header to write), then a single tree.
+	*/
+	bool interleaved = options.interleaved;
+	uint64_t stream_overhead = interleaved ? STREAM_TABLE_SIZE + HuffmanTree::INTERLEAVED_STREAMS : 1;	// The table, and the padding of each stream.
+	uint64_t best_size = tree.headerSize() + stream_overhead + tree.encodedBits(counts) / 8;
+	unsigned char block_type = interleaved ? BLOCK_STREAMS : BLOCK_HUFFMAN;
+	if (previous_tree != NULL)
+	{
+		uint64_t reuse_size = stream_overhead + previous_tree->encodedBits(counts) / 8;
+		if (reuse_size <= best_size)
+		{
+			best_size = reuse_size;
+			block_type = interleaved ? BLOCK_REUSE_STREAMS : BLOCK_REUSE;
+		}
+	}
+	if (model != NULL && model->helps() && model->encodedSize() < best_size)
+	{
+		best_size = model->encodedSize();
+		block_type = BLOCK_CONTEXT;
+	}
+	if (options.adaptive && size <= best_size) block_type = BLOCK_STORED;
+	return block_type;
+}
+
+uint64_t Huffman::estimateBlock(HuffmanTree &tree, ContextModel &model, const unsigned char* data, size_t size)
+{
+	/*	Makes a block's tree (and context model, with the context option) and picks its type, as EncodeContainer_
+		would for a block with no earlier tree, then adds up the size of that type from the code lengths and the
+		counts: each stream's bits are rounded up to a whole byte, so an interleaved block's parts are counted
+		on their own. Like buildBlockTree, this runs on a worker thread, with a tree and model of the block's own.
+	*/
+	uint64_t counts[256] = { 0 };
+	buildBlockTree(tree, data, size, NULL, counts);
+	if (options.context)
+	{
+		PhaseTimer timer(stats_counters.get(), PHASE_TREE);
+		model.build(data, size, contextCodeLength());
+	}
+	unsigned char block_type = chooseBlockType(tree, NULL, options.context ? &model : NULL, counts, size);
+	uint64_t block_size = blockHeaderSize(options.checksum ? CONTAINER_FLAG_CHECKSUM : 0);
+	if (block_type == BLOCK_STORED) return block_size + size;
+	if (block_type == BLOCK_CONTEXT) return block_size + model.encodedSize();
+	block_size += tree.headerSize();
+	if (block_type == BLOCK_HUFFMAN) return block_size + (tree.encodedBits(counts) + 7) / 8;
+
+	size_t part_sizes[HuffmanTree::INTERLEAVED_STREAMS];
+	splitStreams(size, part_sizes);
+	block_size += STREAM_TABLE_SIZE;
+	for (size_t i = 0; i < HuffmanTree::INTERLEAVED_STREAMS; i++)
+	{
+		uint64_t part_counts[256] = { 0 };
+		countBytes(data, part_sizes[i], part_counts);
+		block_size += (tree.encodedBits(part_counts) + 7) / 8;
+		data += part_sizes[i];
+	}
+	return block_size;
+}
+
+uint64_t Huffman::containerOverhead(uint64_t block_count) const
+{
+	/*	The file header, the end block, an index entry for each block, and the trailer. */
+	return CONTAINER_HEADER_SIZE + blockHeaderSize(options.checksum ? CONTAINER_FLAG_CHECKSUM : 0) + block_count * INDEX_ENTRY_SIZE + TRAILER_SIZE;
+}
+
+unsigned int Huffman::contextCodeLength() const
+{
+	/*	The code length limit of the options, if there is one, as long as it is below the context models' own. */
+	return options.max_code_length != 0 && options.max_code_length < ContextModel::MAXIMUM_CODE_LENGTH ? options.max_code_length : ContextModel::MAXIMUM_CODE_LENGTH;
+}
+
+void Huffman::encodeBlock(const HuffmanTree &tree, const ContextModel &model, unsigned char block_type, const unsigned char* data, size_t size, vector<unsigned char> &block_output)
+{
+	/*	Encodes one block of input into block_output as the given type of block, including its block
+		header (and the tree's header, for the types that have one). The tree must have its code table,
+		and a BLOCK_CONTEXT block's model must have been built from the block.
+		Stored blocks are copied, so no bits are packed for them at all. With the checksum option, the
+		bytes are checksummed and encoded CHECKSUM_PIECE_SIZE at a time, so the checksum doesn't need a
+		pass of its own over the block: each piece is still in cache when it is encoded.
+		This runs on a worker thread, so it writes nothing but the block's own output.
+	*/
+	PhaseTimer timer(stats_counters.get(), PHASE_CODING);
+	size_t header_size = blockHeaderSize(options.checksum ? CONTAINER_FLAG_CHECKSUM : 0);
+	block_output.clear();
+	block_output.resize(header_size);						// Leave room for the block header until the payload size is known.
+	uint32_t checksum = 0;									// The checksum of the bytes encoded so far.
+	auto encodePart = [&](const unsigned char* part, size_t part_size, BitWriter* writer)
+	{
+		size_t piece_size = options.checksum ? CHECKSUM_PIECE_SIZE : part_size;
+		for (size_t done = 0; done < part_size; done += piece_size)
+		{
+			size_t piece = min(piece_size, part_size - done);
+			if (options.checksum) checksum = crc32c(checksum, part + done, piece);
+			if (block_type == BLOCK_STORED) block_output.insert(block_output.end(), part + done, part + done + piece);
+			else if (block_type == BLOCK_CONTEXT) model.encodeBytes(part + done, piece, *writer, done > 0 ? part[done - 1] : 0);
+			else tree.encodeBytes(part + done, piece, *writer);
+		}
+	};
+	if (block_type == BLOCK_STORED)
+	{
+		encodePart(data, size, nullptr);
+	}
+	else
+	{
+		if (block_type == BLOCK_HUFFMAN || block_type == BLOCK_STREAMS)
+		{
+			block_output.resize(header_size + tree.headerSize());
+			tree.writeHeader(&block_output[header_size]);
+		}
+		else if (block_type == BLOCK_CONTEXT)
+		{
+			block_output.resize(header_size + model.headerSize());
+			model.writeHeader(&block_output[header_size]);
+		}
+
+		VectorSink sink(block_output);
+		BitWriter writer(sink, size < ENCODE_BLOCK_SIZE ? size + 64 : ENCODE_BLOCK_SIZE);	// A small block doesn't need a whole output block.
+		if (block_type == BLOCK_STREAMS || block_type == BLOCK_REUSE_STREAMS)
+		{
+			size_t table_offset = block_output.size();
+			block_output.resize(table_offset + STREAM_TABLE_SIZE);		// Leave room for the stream sizes too.
+			size_t part_sizes[HuffmanTree::INTERLEAVED_STREAMS];
+			splitStreams(size, part_sizes);
+			for (size_t i = 0; i < HuffmanTree::INTERLEAVED_STREAMS; i++)
+			{
+				size_t stream_start = block_output.size();
+				uint64_t stream_start_bits = writer.bitsWritten();
+				encodePart(data, part_sizes[i], &writer);
+				if (stats_counters) stats_counters->addCoded(part_sizes[i], writer.bitsWritten() - stream_start_bits);
+				tree.padFinalByte(writer);
+				writer.finish();							// Each stream ends on a byte, so the writer can go on to the next.
+				data += part_sizes[i];
+				if (i < 3) storeLittleEndian32(&block_output[table_offset + i * 4], uint32_t(block_output.size() - stream_start));
+			}
+		}
+		else if (block_type == BLOCK_CONTEXT)
+		{
+			encodePart(data, size, &writer);
+			if (stats_counters) stats_counters->addCoded(size, writer.bitsWritten());
+			writer.finish();							// The decoder stops after the block's bytes, so the padding needn't be special.
+		}
+		else
+		{
+			encodePart(data, size, &writer);
+			if (stats_counters) stats_counters->addCoded(size, writer.bitsWritten());
+			tree.padFinalByte(writer);
+			writer.finish();
+		}
+	}
+
+	block_output[0] = block_type;
+	if (options.checksum) storeLittleEndian32(&block_output[BLOCK_HEADER_SIZE], checksum);
+	storeLittleEndian32(&block_output[1], uint32_t(size));
+	storeLittleEndian32(&block_output[5], uint32_t(block_output.size() - header_size));
+}
+
+bool Huffman::decodeBlock(const HuffmanTree &tree, ContextModel &model, unsigned char block_type, const unsigned char* payload, size_t payload_size, size_t decoded_size, vector<unsigned char> &block_output, uint32_t* checksum)
+{
+	/*	Decodes one block's payload (after any tree header) into block_output, with a tree that
+		already has its decode table. A BLOCK_CONTEXT payload is read into the model instead.
+		Returns false if the payload doesn't decode to the number of bytes its header promised.
+		When checksum isn't null, it is set to the checksum of the decoded bytes. A single stream's
+		are checksummed as the decoder writes them out, while they are still in cache. The other
+		decoders write straight into block_output, so their bytes are checksummed after, in a pass
+		of their own.
+		This runs on a worker thread, so it leaves the reporting of errors to the caller.
+	*/
+	PhaseTimer timer(stats_counters.get(), PHASE_CODING);
+	if (block_type != BLOCK_STORED && stats_counters) stats_counters->addCoded(decoded_size, uint64_t(payload_size) * 8);
+	if (block_type == BLOCK_STORED)
+	{
+		block_output.assign(payload, payload + payload_size);
+		if (checksum) *checksum = crc32c(0, payload, payload_size);
+		return payload_size == decoded_size;
+	}
+
+	if (block_type == BLOCK_CONTEXT)
+	{
+		if (!model.readHeader(payload, payload_size)) return false;
+		block_output.resize(decoded_size);
+		if (!model.decode(payload + model.headerSize(), payload_size - model.headerSize(), block_output.data(), decoded_size)) return false;
+		if (checksum) *checksum = crc32c(0, block_output.data(), block_output.size());
+		return true;
+	}
+
+	if (block_type == BLOCK_STREAMS || block_type == BLOCK_REUSE_STREAMS)
+	{
+		if (payload_size < STREAM_TABLE_SIZE) return false;
+		byte_span streams[HuffmanTree::INTERLEAVED_STREAMS];
+		size_t part_sizes[HuffmanTree::INTERLEAVED_STREAMS];
+		splitStreams(decoded_size, part_sizes);
+		const unsigned char* stream_data = payload + STREAM_TABLE_SIZE;
+		size_t remaining = payload_size - STREAM_TABLE_SIZE;
+		for (size_t i = 0; i < HuffmanTree::INTERLEAVED_STREAMS; i++)
+		{
+			size_t stream_size = i < 3 ? loadLittleEndian32(payload + i * 4) : remaining;
+			if (stream_size > remaining) return false;
+			streams[i] = byte_span{ stream_data, stream_size };
+			stream_data += stream_size;
+			remaining -= stream_size;
+		}
+		block_output.resize(decoded_size);
+		if (!tree.decodeStreams(streams, block_output.data(), part_sizes)) return false;
+		if (checksum) *checksum = crc32c(0, block_output.data(), block_output.size());
+		return true;
+	}
+
+	block_output.clear();
+	block_output.reserve(decoded_size);
+	VectorSink sink(block_output);
+	ChecksumSink checksum_sink(sink);
+	ByteSink &output = checksum ? static_cast<ByteSink&>(checksum_sink) : sink;
+	tree.decodeBits(payload, payload_size, 0, true, output);
+	if (checksum) *checksum = checksum_sink.checksumWritten();
+	return block_output.size() == decoded_size;
+}
+
+void Huffman::EncodeContainer_(InputFile &file_input, ByteSink &file_output, const vector<unsigned char>* tree_header)
+{
+	/*	Encodes the input file into the block container format. The input is cut into blocks of
+		options.block_size bytes, and thread_count * 2 blocks at a time are encoded at the same time.
+		The encoded blocks are written in order, followed by the end block, the block index, and the trailer.
+		With the adaptive option, every block's tree is made first, then the type of each block is
+		chosen in order (since reusing a tree depends on the blocks before), then the blocks are encoded.
+		The last tree written in a batch is kept in carried_tree, for the blocks of the next batch.
+		With the checksum option, every block header (even the end block's) has room for a checksum.
+		With the context option (and no tree given), every block's context model is built along with its
+		tree, and the block is coded with the model if that is smaller.
+	*/
+	unsigned char header[CONTAINER_HEADER_SIZE] = { 0 };
+	memcpy(header, CONTAINER_MAGIC, 4);
+	header[4] = CONTAINER_VERSION;
+	header[5] = options.checksum ? CONTAINER_FLAG_CHECKSUM : 0;
+	storeLittleEndian32(header + 8, uint32_t(options.block_size));
+	file_output.write(header, CONTAINER_HEADER_SIZE);
+	uint64_t output_offset = CONTAINER_HEADER_SIZE;
+
+	size_t batch_size = size_t(thread_count) * 2;
+	vector<vector<unsigned char>> input_buffers(batch_size);	// Used only when the input isn't mapped.
+	vector<vector<unsigned char>> block_outputs(batch_size);
+	vector<byte_span> blocks(batch_size);
+	bool context = options.context && tree_header == NULL;
+	unsigned int context_length = contextCodeLength();
+	vector<uint64_t> block_counts(options.adaptive || context ? batch_size * 256 : 0);
+	vector<unsigned char> block_types(batch_size);
+	vector<const HuffmanTree*> code_trees(batch_size);		// The tree each block is encoded with (its own, or an earlier one).
+	vector<unsigned char> index;
+	reserveBlockTrees(batch_size);
+	bool have_previous = false;								// Whether a tree has been written that later blocks can reuse.
+	unsigned char new_tree_type = options.interleaved ? BLOCK_STREAMS : BLOCK_HUFFMAN;
+	bool end_of_file = false;
+	while (!end_of_file)
+	{
+		size_t block_count = 0;
+		while (block_count < batch_size)				// Gather the next batch of blocks.
+		{
+			size_t size = file_input.nextBlock(blocks[block_count], options.block_size, input_buffers[block_count]);
+			if (size > 0) block_count++;
+			if (size < options.block_size)
+			{
+				end_of_file = true;
+				break;
+			}
+		}
+
+		if (!options.adaptive)
+		{
+			if (context) fill(block_counts.begin(), block_counts.end(), 0);
+			parallelFor(block_count, thread_count, [&](size_t i)
+			{
+				unsigned char block_type = new_tree_type;
+				if (!context) buildBlockTree(*block_trees[i], blocks[i].data, blocks[i].size, tree_header, NULL);
+				else
+				{
+					buildBlockTree(*block_trees[i], blocks[i].data, blocks[i].size, tree_header, &block_counts[i * 256]);
+					PhaseTimer timer(stats_counters.get(), PHASE_TREE);
+					block_models[i]->build(blocks[i].data, blocks[i].size, context_length);
+					block_type = chooseBlockType(*block_trees[i], NULL, block_models[i].get(), &block_counts[i * 256], blocks[i].size);
+				}
+				encodeBlock(*block_trees[i], *block_models[i], block_type, blocks[i].data, blocks[i].size, block_outputs[i]);
+			});
+		}
+		else
+		{
+			fill(block_counts.begin(), block_counts.end(), 0);
+			parallelFor(block_count, thread_count, [&](size_t i)
+			{
+				buildBlockTree(*block_trees[i], blocks[i].data, blocks[i].size, tree_header, &block_counts[i * 256]);
+				if (!context) return;
+				PhaseTimer timer(stats_counters.get(), PHASE_TREE);
+				block_models[i]->build(blocks[i].data, blocks[i].size, context_length);
+			});
+
+			const HuffmanTree* previous_tree = have_previous ? carried_tree.get() : NULL;
+			size_t last_new_tree = batch_size;				// The block of this batch with the last new tree (none yet).
+			for (size_t i = 0; i < block_count; i++)
+			{
+				block_types[i] = chooseBlockType(*block_trees[i], previous_tree, context ? block_models[i].get() : NULL, &block_counts[i * 256], blocks[i].size);
+				code_trees[i] = block_trees[i].get();
+				if (reusesTree(block_types[i])) code_trees[i] = previous_tree;
+				else if (hasTreeHeader(block_types[i]))
+				{
+					previous_tree = block_trees[i].get();
+					last_new_tree = i;
+				}
+			}
+
+			parallelFor(block_count, thread_count, [&](size_t i)
+			{
+				encodeBlock(*code_trees[i], *block_models[i], block_types[i], blocks[i].data, blocks[i].size, block_outputs[i]);
+			});
+
+			if (last_new_tree < batch_size)				// Keep the last new tree for the next batch, swapping in a spare tree for it.
+			{
+				swap(carried_tree, block_trees[last_new_tree]);
+				have_previous = true;
+			}
+		}
+
+		for (size_t i = 0; i < block_count; i++)		// Write the batch in order, remembering where each block went.
+		{
+			unsigned char entry[INDEX_ENTRY_SIZE];
+			storeLittleEndian64(entry, output_offset);
+			storeLittleEndian32(entry + 8, uint32_t(blocks[i].size));
+			storeLittleEndian32(entry + 12, uint32_t(block_outputs[i].size()));
+			index.insert(index.end(), entry, entry + INDEX_ENTRY_SIZE);
+
+			file_output.write(block_outputs[i].data(), block_outputs[i].size());
+			output_offset += block_outputs[i].size();
+		}
+	}
+
+	unsigned char end_block[BLOCK_HEADER_SIZE + BLOCK_CHECKSUM_SIZE] = { BLOCK_END };
+	file_output.write(end_block, blockHeaderSize(header[5]));
+	output_offset += blockHeaderSize(header[5]);
+
+	if (!index.empty()) file_output.write(index.data(), index.size());
+	unsigned char trailer[TRAILER_SIZE];
+	storeLittleEndian64(trailer, output_offset);
+	storeLittleEndian32(trailer + 8, uint32_t(index.size() / INDEX_ENTRY_SIZE));
+	memcpy(trailer + 12, TRAILER_MAGIC, 4);
+	file_output.write(trailer, TRAILER_SIZE);
+}
+
+void Huffman::DecodeContainer_(InputFile &file_input, ByteSink &file_output)
+{
+	/*	Decodes a block container file. The block headers are read one after another (so the
+		index isn't needed, and the file doesn't have to be seekable), thread_count * 2 blocks
+		at a time. The blocks of a batch are decoded at the same time, then written in order.
+		Blocks that reuse an earlier tree are decoded once the trees of the batch have been built,
+		and the last tree of a batch is kept in carried_tree for the blocks of the next batch.
+		When the file has checksums, each block's is checked on its thread, as it is decoded (see decodeBlock).
+	*/
+	unsigned char header[CONTAINER_HEADER_SIZE];
+	if (file_input.read(header, CONTAINER_HEADER_SIZE) < CONTAINER_HEADER_SIZE || header[4] != CONTAINER_VERSION || (header[5] & ~CONTAINER_FLAGS) != 0)
+	{
+		throw HuffmanError("The block container header could not be read. The file may be damaged, or from a newer version.");
+	}
+	bool checksummed = (header[5] & CONTAINER_FLAG_CHECKSUM) != 0;
+	size_t header_size = blockHeaderSize(header[5]);
+
+	size_t batch_size = size_t(thread_count) * 2;
+	vector<vector<unsigned char>> input_buffers(batch_size);	// Used only when the input isn't mapped.
+	vector<vector<unsigned char>> block_outputs(batch_size);
+	vector<byte_span> payloads(batch_size);
+	vector<unsigned char> block_types(batch_size);
+	vector<size_t> decoded_sizes(batch_size);
+	vector<const HuffmanTree*> code_trees(batch_size);		// The tree each block is decoded with (its own, or the one it reuses).
+	vector<char> block_valid(batch_size);
+	vector<uint32_t> checksums(batch_size);					// The checksum in each block's header.
+	vector<char> checksum_valid(batch_size);
+	reserveBlockTrees(batch_size);
+	bool have_previous = false;								// Whether a tree has been read that later blocks can reuse.
+	uint64_t block_number = 0;								// The number of blocks written, for the error of a block whose checksum is wrong.
+	auto decodeAndCheck = [&](size_t i, const unsigned char* payload, size_t payload_size)
+	{
+		uint32_t checksum = 0;
+		block_valid[i] = decodeBlock(*code_trees[i], *block_models[i], block_types[i], payload, payload_size, decoded_sizes[i], block_outputs[i], checksummed ? &checksum : nullptr);
+		checksum_valid[i] = !checksummed || !block_valid[i] || checksum == checksums[i];
+	};
+	bool end_of_blocks = false;
+	while (!end_of_blocks)
+	{
+		size_t block_count = 0;
+		size_t last_new_tree = batch_size;				// The block of this batch with the last tree header (none yet).
+		bool reuses_tree = false;
+		while (block_count < batch_size)				// Read the headers and payloads of the next batch.
+		{
+			unsigned char block_header[BLOCK_HEADER_SIZE + BLOCK_CHECKSUM_SIZE];
+			if (file_input.read(block_header, header_size) < header_size)
+			{
+				throw HuffmanError("The file ended before its last block. The file may be damaged or incomplete.");
+			}
+			unsigned char block_type = block_header[0];
+			if (block_type == BLOCK_END)
+			{
+				end_of_blocks = true;
+				break;
+			}
+			size_t decoded_size = loadLittleEndian32(block_header + 1);
+			size_t payload_size = loadLittleEndian32(block_header + 5);
+			if (block_type > BLOCK_CONTEXT || decoded_size > MAXIMUM_BLOCK_SIZE)
+			{
+				throw HuffmanError("Found a block that could not be read. The file may be damaged, or from a newer version.");
+			}
+			if (file_input.nextBlock(payloads[block_count], payload_size, input_buffers[block_count]) < payload_size)
+			{
+				throw HuffmanError("The file ended before its last block. The file may be damaged or incomplete.");
+			}
+
+			code_trees[block_count] = block_trees[block_count].get();
+			if (hasTreeHeader(block_type)) last_new_tree = block_count;
+			else if (reusesTree(block_type))				// Find the tree this block reuses, in this batch or the last.
+			{
+				if (last_new_tree < batch_size) code_trees[block_count] = block_trees[last_new_tree].get();
+				else if (have_previous) code_trees[block_count] = carried_tree.get();
+				else throw HuffmanError("Found a block that reuses a tree before any tree. The file may be damaged.");
+				reuses_tree = true;
+			}
+			block_types[block_count] = block_type;
+			decoded_sizes[block_count] = decoded_size;
+			if (checksummed) checksums[block_count] = loadLittleEndian32(block_header + BLOCK_HEADER_SIZE);
+			block_count++;
+		}
+
+		parallelFor(block_count, thread_count, [&](size_t i)	// Read each tree header, and decode every block that doesn't reuse a tree.
+		{
+			const unsigned char* payload = payloads[i].data;
+			size_t payload_size = payloads[i].size;
+			if (hasTreeHeader(block_types[i]))
+			{
+				HuffmanTree &tree = *block_trees[i];
+				{
+					PhaseTimer timer(stats_counters.get(), PHASE_TREE);
+					block_valid[i] = tree.readHeader(payload, payload_size);
+				}
+				if (!block_valid[i]) return;
+				PhaseTimer timer(stats_counters.get(), PHASE_CODE_TABLES);
+				tree.buildDecodeTable();
+				payload += tree.headerSize();
+				payload_size -= tree.headerSize();
+				code_trees[i] = &tree;
+			}
+			else if (reusesTree(block_types[i])) return;	// Waits until the tree it reuses has been read.
+			decodeAndCheck(i, payload, payload_size);
+		});
+
+		if (reuses_tree)
+		{
+			for (size_t i = 0; i < block_count; i++)	// A block whose tree is missing can't be decoded, nor can those that reuse it.
+			{
+				if (hasTreeHeader(block_types[i]) && !block_valid[i])
+				{
+					throw HuffmanError("Could not decode a block of the file. Make sure it is in the correct format.");
+				}
+			}
+			parallelFor(block_count, thread_count, [&](size_t i)
+			{
+				if (!reusesTree(block_types[i])) return;
+				decodeAndCheck(i, payloads[i].data, payloads[i].size);
+			});
+		}
+
+		for (size_t i = 0; i < block_count; i++)
+		{
+			if (!block_valid[i])
+			{
+				throw HuffmanError("Could not decode a block of the file. Make sure it is in the correct format.");
+			}
+			if (!checksum_valid[i])
+			{
+				throw HuffmanError("The checksum of block " + to_string(block_number + i) + " doesn't match its decoded bytes. The file is damaged.");
+			}
+			file_output.write(block_outputs[i].data(), block_outputs[i].size());
+		}
+		block_number += block_count;
+
+		if (last_new_tree < batch_size)					// Keep the last tree for the next batch, swapping in a spare tree for it.
+		{
+			swap(carried_tree, block_trees[last_new_tree]);
+			have_previous = true;
+		}
+	}
+}
+
+uint64_t Huffman::DecodeContainerRange_(InputFile &file_input, ByteSink &file_output, uint64_t offset, uint64_t length)
+{
+	/*	Decodes the bytes from offset to offset + length of a block container file's decoded bytes (or to
+		its end). The block index at the end of the file gives the place and decoded size of every block,
+		so only the blocks holding part of the range are read and decoded. If the first of them reuses an
+		earlier tree, the blocks before it are looked back through (reading only their block headers) for
+		the last one with a tree header. Every block that is decoded has its checksum checked, if the file has them.
+		Returns the number of bytes read, for stats().
+	*/
+	uint64_t file_size = file_input.size();
+	unsigned char header[CONTAINER_HEADER_SIZE];
+	if (file_input.read(header, CONTAINER_HEADER_SIZE) < CONTAINER_HEADER_SIZE || header[4] != CONTAINER_VERSION || (header[5] & ~CONTAINER_FLAGS) != 0)
+	{
+		throw HuffmanError("The block container header could not be read. The file may be damaged, or from a newer version.");
+	}
+	bool checksummed = (header[5] & CONTAINER_FLAG_CHECKSUM) != 0;
+	size_t header_size = blockHeaderSize(header[5]);
+	unsigned char trailer[TRAILER_SIZE];
+	if (file_size >= CONTAINER_HEADER_SIZE + BLOCK_HEADER_SIZE + TRAILER_SIZE) file_input.seek(file_size - TRAILER_SIZE);
+	if (file_size < CONTAINER_HEADER_SIZE + BLOCK_HEADER_SIZE + TRAILER_SIZE || file_input.read(trailer, TRAILER_SIZE) < TRAILER_SIZE || memcmp(trailer + 12, TRAILER_MAGIC, 4) != 0)
+	{
+		throw HuffmanError("The block index of the file could not be read. The file may be damaged or incomplete.");
+	}
+	uint64_t index_offset = loadLittleEndian64(trailer);
+	size_t block_count = loadLittleEndian32(trailer + 8);
+	if (index_offset > file_size || (file_size - index_offset - TRAILER_SIZE) / INDEX_ENTRY_SIZE != block_count || (file_size - index_offset - TRAILER_SIZE) % INDEX_ENTRY_SIZE != 0)
+	{
+		throw HuffmanError("The block index of the file could not be read. The file may be damaged or incomplete.");
+	}
+	vector<unsigned char> index(block_count * INDEX_ENTRY_SIZE);
+	file_input.seek(index_offset);
+	file_input.read(index.data(), index.size());
+	uint64_t bytes_read = CONTAINER_HEADER_SIZE + TRAILER_SIZE + index.size();
+
+	HuffmanTree &tree = file_tree;
+	bool have_tree = false;									// Whether tree is the one the next block reusing a tree needs.
+	vector<unsigned char> block_input;						// Used only when the input isn't mapped.
+	vector<unsigned char> block_output;
+	uint64_t end = length < UINT64_MAX - offset ? offset + length : UINT64_MAX;
+	uint64_t block_start = 0;								// The decoded offset of the block.
+	for (size_t i = 0; i < block_count && block_start < end; i++)
+	{
+		const unsigned char* entry = &index[i * INDEX_ENTRY_SIZE];
+		uint64_t block_offset = loadLittleEndian64(entry);
+		size_t decoded_size = loadLittleEndian32(entry + 8);
+		size_t stored_size = loadLittleEndian32(entry + 12);
+		uint64_t block_end = block_start + decoded_size;
+		if (block_end <= offset)
+		{
+			block_start = block_end;
+			continue;
+		}
+
+		byte_span block = { NULL, 0 };
+		if (stored_size >= header_size && block_offset <= index_offset - stored_size)
+		{
+			file_input.seek(block_offset);
+			file_input.nextBlock(block, stored_size, block_input);
+		}
+		if (block.size < header_size || block.size != stored_size || block.data[0] == BLOCK_END || block.data[0] > BLOCK_CONTEXT ||
+			loadLittleEndian32(block.data + 1) != decoded_size || loadLittleEndian32(block.data + 5) != stored_size - header_size)
+		{
+			throw HuffmanError("Found a block that doesn't match the block index. The file may be damaged.");
+		}
+		bytes_read += block.size;
+		unsigned char block_type = block.data[0];
+		uint32_t checksum = checksummed ? loadLittleEndian32(block.data + BLOCK_HEADER_SIZE) : 0;
+		const unsigned char* payload = block.data + header_size;
+		size_t payload_size = block.size - header_size;
+
+		if (hasTreeHeader(block_type))
+		{
+			{
+				PhaseTimer timer(stats_counters.get(), PHASE_TREE);
+				if (!tree.readHeader(payload, payload_size)) throw HuffmanError("Could not decode a block of the file. Make sure it is in the correct format.");
+			}
+			PhaseTimer timer(stats_counters.get(), PHASE_CODE_TABLES);
+			tree.buildDecodeTable();
+			payload += tree.headerSize();
+			payload_size -= tree.headerSize();
+			have_tree = true;
+		}
+		else if (reusesTree(block_type) && !have_tree)
+		{
+			size_t tree_block = i;							// Look back for the last block with a tree header.
+			unsigned char tree_block_type = BLOCK_STORED;
+			while (tree_block > 0 && !hasTreeHeader(tree_block_type))
+			{
+				tree_block--;
+				file_input.seek(loadLittleEndian64(&index[tree_block * INDEX_ENTRY_SIZE]));
+				if (file_input.read(&tree_block_type, 1) < 1) break;
+				bytes_read++;
+			}
+			if (!hasTreeHeader(tree_block_type)) throw HuffmanError("Found a block that reuses a tree before any tree. The file may be damaged.");
+			vector<unsigned char> tree_header;
+			file_input.seek(loadLittleEndian64(&index[tree_block * INDEX_ENTRY_SIZE]) + header_size);
+			readTreeHeader(file_input, tree_header);
+			bytes_read += tree_header.size();
+			{
+				PhaseTimer timer(stats_counters.get(), PHASE_TREE);
+				if (!tree.readHeader(tree_header.data(), tree_header.size())) throw HuffmanError("Could not decode a block of the file. Make sure it is in the correct format.");
+			}
+			PhaseTimer timer(stats_counters.get(), PHASE_CODE_TABLES);
+			tree.buildDecodeTable();
+			have_tree = true;
+		}
+
+		uint32_t decoded_checksum = 0;
+		if (!decodeBlock(tree, file_model, block_type, payload, payload_size, decoded_size, block_output, checksummed ? &decoded_checksum : nullptr))
+		{
+			throw HuffmanError("Could not decode a block of the file. Make sure it is in the correct format.");
+		}
+		if (checksummed && decoded_checksum != checksum)
+		{
+			throw HuffmanError("The checksum of block " + to_string(i) + " doesn't match its decoded bytes. The file is damaged.");
+		}
+		size_t range_start = block_start < offset ? size_t(offset - block_start) : 0;
+		size_t range_end = end < block_end ? size_t(end - block_start) : decoded_size;
+		file_output.write(block_output.data() + range_start, range_end - range_start);
+		block_start = block_end;
+	}
+	return bytes_read;
+}
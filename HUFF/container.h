@@ -0,0 +1,65 @@
+//	File:			container.h
+//	Description:	The layout of the block container format. Instead of one tree followed by one bitstream, the input
+//					is split into blocks that are each encoded on their own (with their own tree), so blocks can be
+//					encoded and decoded at the same time on several threads, and found again through the index.
+//
+//					All numbers are little endian.
+//					File header (CONTAINER_HEADER_SIZE bytes):
+//						4	CONTAINER_MAGIC. The first byte is larger than the second, which a tree_sequence from a
+//							legacy .huf file never is, so the two formats can't be confused.
+//						1	CONTAINER_VERSION
+//						1	Flags (CONTAINER_FLAG_ values below, and 0 for the rest)
+//						2	Reserved (0)
+//						4	The block size used by the encoder (every block but the last holds this many input bytes)
+//					Blocks, one after another. Each starts with a header (BLOCK_HEADER_SIZE bytes):
+//						1	The block type (one of the BLOCK_ values below)
+//						4	The number of decoded bytes in the block
+//						4	The number of payload bytes that follow this header
+//						4	Only with CONTAINER_FLAG_CHECKSUM: the CRC-32C (see crc32c.h) of the block's decoded bytes (0 for BLOCK_END)
+//					A BLOCK_HUFFMAN payload is a tree header followed by the encoded bits, exactly as in a single
+//					stream .huf file. The header is either a 510 byte tree_sequence, or the code lengths of a
+//					canonical tree (see HuffmanTree::writeHeader). A BLOCK_STREAMS payload is a tree header, then the
+//					sizes of the first three of four streams (4 bytes each), then the streams. The block's bytes are
+//					split into four nearly equal parts (see splitStreams in container.cpp), and each part is encoded
+//					(and padded) as its own stream, so the four can be decoded together. BLOCK_REUSE and
+//					BLOCK_REUSE_STREAMS payloads are the same without the tree header: they use the tree of the last
+//					block before them that had one. A BLOCK_STORED payload is the block's bytes as they are. A BLOCK_CONTEXT
+//					payload is an order-1 context model's header, then the bytes coded with it (see context_model.h).
+//					The blocks end with an empty BLOCK_END block.
+//					Block index, one entry (INDEX_ENTRY_SIZE bytes) per block:
+//						8	The offset of the block's header from the start of the file
+//						4	The number of decoded bytes in the block
+//						4	The number of stored bytes in the block (header and payload)
+//					Trailer (TRAILER_SIZE bytes):
+//						8	The offset of the block index
+//						4	The number of blocks
+//						4	TRAILER_MAGIC
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+static const unsigned char CONTAINER_MAGIC[4] = { 0xFF, 'H', 'U', 'F' };
+static const unsigned char TRAILER_MAGIC[4] = { 'H', 'U', 'F', 'I' };
+static const unsigned char CONTAINER_VERSION = 1;
+static const unsigned char CONTAINER_FLAG_CHECKSUM = 1;	// Every block header ends with the checksum of the block's decoded bytes.
+static const unsigned char CONTAINER_FLAGS = CONTAINER_FLAG_CHECKSUM;	// Every flag this version knows. A file with any other can't be read.
+
+static const size_t CONTAINER_HEADER_SIZE = 12;
+static const size_t BLOCK_HEADER_SIZE = 9;			// Without the checksum, which adds BLOCK_CHECKSUM_SIZE to every block header when there is one.
+static const size_t BLOCK_CHECKSUM_SIZE = 4;
+static const size_t CHECKSUM_PIECE_SIZE = 16 << 10;	// How much of a block is checksummed at a time while it is encoded, so it is still in cache to encode.
+static const size_t INDEX_ENTRY_SIZE = 16;
+static const size_t TRAILER_SIZE = 16;
+
+static const unsigned char BLOCK_END = 0;			// Marks the end of the blocks.
+static const unsigned char BLOCK_HUFFMAN = 1;		// A block with its own tree header.
+static const unsigned char BLOCK_STREAMS = 2;		// A block with its own tree header, split into four streams.
+static const unsigned char BLOCK_STORED = 3;		// A block stored without encoding, for data that doesn't compress.
+static const unsigned char BLOCK_REUSE = 4;			// A block encoded with the last tree header before it.
+static const unsigned char BLOCK_REUSE_STREAMS = 5;	// A block split into four streams, with the last tree header before it.
+static const unsigned char BLOCK_CONTEXT = 6;		// A block coded with a tree for each class of previous byte. Later blocks can't reuse its trees.
+static const size_t STREAM_TABLE_SIZE = 12;			// The sizes of the first three streams of a BLOCK_STREAMS payload.
+
+static const size_t MINIMUM_BLOCK_SIZE = 4 << 10;	// The smallest block size the encoder accepts.
+static const size_t MAXIMUM_BLOCK_SIZE = 64 << 20;	// The largest block size the encoder accepts (so even 255 bit codes fit the 32-bit sizes).
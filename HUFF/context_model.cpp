@@ -0,0 +1,388 @@
+//	File:			context_model.cpp
+//	Description:	The implementation of the order-1 context model (see context_model.h). Contexts are clustered in two
+//					steps: the most common previous bytes seed MAXIMUM_CLASSES classes, and every previous byte is moved
+//					to the class that codes its bytes in the fewest bits, a few times over. Then the two classes that
+//					cost the least to merge are merged, one pair at a time, and the number of classes that left the
+//					smallest estimate (with the header each class adds) is kept.
+
+#include "context_model.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static double codeBits(double count, double total, unsigned int max_length)
+{
+	/*	The estimated length of the code of a byte counted count times out of total. A code is
+		never shorter than 1 bit, nor longer than the limit (which a byte that was never counted gets).
+	*/
+	if (count <= 0) return max_length;
+	double bits = log2(total / count);
+	return bits < 1 ? 1 : bits > max_length ? max_length : bits;
+}
+
+static double classBits(const double counts[256], unsigned int max_length)
+{
+	/*	The estimated bits of the codes of a class's bytes, from its counts. */
+	double total = 0, bits = 0;
+	for (int i = 0; i < 256; i++) total += counts[i];
+	for (int i = 0; i < 256; i++) if (counts[i] > 0) bits += counts[i] * codeBits(counts[i], total, max_length);
+	return bits;
+}
+
+void ContextModel::build(const unsigned char* data, size_t size, unsigned int max_length)
+{
+	/*	Counts every byte after the byte before it, then clusters the previous bytes into classes. If there
+		is more than one class, each gets a limited canonical tree from the counts of the bytes after its
+		previous bytes, and the exact size of the payload is worked out from the trees' code lengths.
+	*/
+	pair_counts.assign(size_t(256) * 256, 0);
+	unsigned int previous = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		pair_counts[(previous << 8) | data[i]]++;
+		previous = data[i];
+	}
+
+	class_count = clusterContexts(max_length);
+	encoded_size = 0;
+	if (class_count < 2) return;
+
+	while (class_trees.size() < class_count) class_trees.emplace_back(new HuffmanTree());
+	uint64_t bits = 0;
+	for (unsigned int c = 0; c < class_count; c++)
+	{
+		uint64_t counts[256] = { 0 };
+		for (unsigned int p = 0; p < 256; p++)
+		{
+			if (context_class[p] != c) continue;
+			for (int i = 0; i < 256; i++) counts[i] += pair_counts[(p << 8) | i];
+		}
+		HuffmanTree &tree = *class_trees[c];
+		tree.setWeights(counts);
+		tree.createLimitedTree(max_length);
+		tree.createCodeTable();
+		bits += tree.encodedBits(counts);
+	}
+	encoded_size = headerSize() + (bits + 7) / 8;
+	makeCodes();
+}
+
+unsigned int ContextModel::clusterContexts(unsigned int max_length)
+{
+	/*	Clusters the previous bytes that were counted into classes, setting context_class (every previous
+		byte that never came up goes in class 0). Each class's codes are estimated from its counts by
+		codeBits, and a previous byte's cost in a class is what its counts would take with those codes.
+		Returns the number of classes, which is 1 if no number of classes beats a single tree.
+	*/
+	memset(context_class, 0, sizeof(context_class));
+	vector<float> rows(pair_counts.begin(), pair_counts.end());	// Floats, so the costs below are worked out 8 at a time where the processor can.
+	double row_totals[256];
+	unsigned char used[256];
+	unsigned int used_count = 0;
+	for (unsigned int p = 0; p < 256; p++)
+	{
+		row_totals[p] = 0;
+		for (int i = 0; i < 256; i++) row_totals[p] += rows[(p << 8) | i];
+		if (row_totals[p] > 0) used[used_count++] = (unsigned char)(p);
+	}
+	sort(used, used + used_count, [&](unsigned char a, unsigned char b) { return row_totals[a] > row_totals[b]; });
+	unsigned int classes = used_count < MAXIMUM_CLASSES ? used_count : MAXIMUM_CLASSES;
+	if (classes < 2) return 1;
+
+	vector<double> class_counts(size_t(classes) * 256, 0);	// The counts of each class, seeded with the most common previous bytes.
+	vector<float> class_code_bits(size_t(classes) * 256);
+	unsigned char assignment[256] = { 0 };
+	for (unsigned int c = 0; c < classes; c++) copy(&rows[size_t(used[c]) << 8], &rows[size_t(used[c]) << 8] + 256, &class_counts[size_t(c) << 8]);
+	for (unsigned int pass = 0; pass < CLUSTER_PASSES; pass++)
+	{
+		for (unsigned int c = 0; c < classes; c++)
+		{
+			const double* counts = &class_counts[size_t(c) << 8];
+			double total = 0;
+			for (int i = 0; i < 256; i++) total += counts[i];
+			for (int i = 0; i < 256; i++) class_code_bits[(size_t(c) << 8) | i] = float(codeBits(counts[i], total, max_length));
+		}
+		for (unsigned int u = 0; u < used_count; u++)		// Move every previous byte to the class that codes it best.
+		{
+			const float* row = &rows[size_t(used[u]) << 8];
+			float best_bits = 0;
+			for (unsigned int c = 0; c < classes; c++)
+			{
+				const float* code_bits = &class_code_bits[size_t(c) << 8];
+				float sums[8] = { 0 };						// Separate sums, so the compiler can keep them in one vector.
+				for (int i = 0; i < 256; i += 8)
+				{
+					for (int j = 0; j < 8; j++) sums[j] += row[i + j] * code_bits[i + j];
+				}
+				float bits = ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7]));
+				if (c == 0 || bits < best_bits)
+				{
+					best_bits = bits;
+					assignment[used[u]] = (unsigned char)(c);
+				}
+			}
+		}
+		fill(class_counts.begin(), class_counts.end(), 0);
+		for (unsigned int u = 0; u < used_count; u++)
+		{
+			const float* row = &rows[size_t(used[u]) << 8];
+			double* counts = &class_counts[size_t(assignment[used[u]]) << 8];
+			for (int i = 0; i < 256; i++) counts[i] += row[i];
+		}
+	}
+
+	// Merge the cheapest pair of classes until one is left, keeping the best number of classes seen on the way.
+	// A single class is written as an order-0 tree (with its canonical header), and more add the model's header.
+	vector<double> bits(classes), merge_bits(size_t(classes) * classes);
+	vector<unsigned char> group(classes), best_group(classes);
+	vector<char> live(classes, 0);						// A seed that lost every previous byte is left out.
+	for (unsigned int u = 0; u < used_count; u++) live[assignment[used[u]]] = 1;
+	double total_bits = 0;
+	unsigned int live_count = 0;
+	for (unsigned int c = 0; c < classes; c++)
+	{
+		bits[c] = classBits(&class_counts[size_t(c) << 8], max_length);
+		group[c] = (unsigned char)(c);
+		live_count += live[c];
+		total_bits += bits[c];
+	}
+	auto mergedBits = [&](unsigned int a, unsigned int b)
+	{
+		double counts[256];
+		for (int i = 0; i < 256; i++) counts[i] = class_counts[(size_t(a) << 8) | i] + class_counts[(size_t(b) << 8) | i];
+		return classBits(counts, max_length);
+	};
+	for (unsigned int a = 0; a < classes; a++)
+	{
+		for (unsigned int b = a + 1; b < classes; b++) if (live[a] && live[b]) merge_bits[a * classes + b] = mergedBits(a, b);
+	}
+	double best_size = total_bits + 8.0 * (1 + 128 + 128 * live_count);
+	unsigned int best_count = live_count;
+	best_group = group;
+	while (live_count > 1)
+	{
+		unsigned int merge_a = 0, merge_b = 0;
+		double best_increase = 0;
+		for (unsigned int a = 0; a < classes; a++)
+		{
+			for (unsigned int b = a + 1; b < classes; b++)
+			{
+				if (!live[a] || !live[b]) continue;
+				double increase = merge_bits[a * classes + b] - bits[a] - bits[b];
+				if (merge_b == 0 || increase < best_increase)
+				{
+					best_increase = increase;
+					merge_a = a;
+					merge_b = b;
+				}
+			}
+		}
+		for (int i = 0; i < 256; i++) class_counts[(size_t(merge_a) << 8) | i] += class_counts[(size_t(merge_b) << 8) | i];
+		total_bits += best_increase;
+		bits[merge_a] = merge_bits[merge_a * classes + merge_b];
+		live[merge_b] = 0;
+		live_count--;
+		for (unsigned int c = 0; c < classes; c++) if (group[c] == merge_b) group[c] = (unsigned char)(merge_a);
+		for (unsigned int c = 0; c < classes; c++)		// Only the merged class's pairs have changed.
+		{
+			if (c == merge_a || !live[c]) continue;
+			merge_bits[min(c, merge_a) * classes + max(c, merge_a)] = mergedBits(min(c, merge_a), max(c, merge_a));
+		}
+		double size = total_bits + 8.0 * (live_count > 1 ? 1 + 128 + 128 * live_count : HuffmanTree::CANONICAL_HEADER_SIZE);
+		if (size < best_size)
+		{
+			best_size = size;
+			best_count = live_count;
+			best_group = group;
+		}
+	}
+	if (best_count < 2) return 1;
+
+	unsigned char number[MAXIMUM_CLASSES];				// Number the classes that are left from 0, in the order they are first used.
+	memset(number, 0xFF, sizeof(number));
+	unsigned int count = 0;
+	for (unsigned int u = 0; u < used_count; u++)
+	{
+		unsigned char merged_class = best_group[assignment[used[u]]];
+		if (number[merged_class] == 0xFF) number[merged_class] = (unsigned char)(count++);
+		context_class[used[u]] = number[merged_class];
+	}
+	return count;
+}
+
+void ContextModel::makeCodes()
+{
+	/*	Looks up the code of every byte after every previous byte, so encodeBytes needs one lookup per byte. */
+	codes.resize(size_t(256) * 256);
+	for (unsigned int p = 0; p < 256; p++)
+	{
+		const HuffmanTree &tree = *class_trees[context_class[p]];
+		for (unsigned int i = 0; i < 256; i++) codes[(p << 8) | i] = uint32_t(tree.codeBits((unsigned char)(i))) | (tree.codeLength((unsigned char)(i)) << 16);
+	}
+}
+
+void ContextModel::makeDecodeTable()
+{
+	/*	Fills each class's table (see decode_table for the layout of an entry). First every index that
+		starts with a byte's code (in its top bits) decodes that byte, and names the byte's own class as
+		the table for the next code. Then, where the rest of the index holds the whole next code as well,
+		as found in the table of the first byte's class, the entry decodes both.
+	*/
+	table_bits = 1;
+	for (unsigned int c = 0; c < class_count; c++)
+	{
+		for (int i = 0; i < 256; i++) table_bits = max(table_bits, class_trees[c]->codeLength((unsigned char)(i)));
+	}
+	decode_table.assign(size_t(class_count) << table_bits, 0);
+	for (unsigned int c = 0; c < class_count; c++)
+	{
+		const HuffmanTree &tree = *class_trees[c];
+		uint32_t* table = &decode_table[size_t(c) << table_bits];
+		for (unsigned int i = 0; i < 256; i++)
+		{
+			unsigned int length = tree.codeLength((unsigned char)(i));
+			size_t first = size_t(tree.codeBits((unsigned char)(i))) << (table_bits - length);
+			uint32_t entry = i | (length << 16) | (length << 22) | (uint32_t(context_class[i]) << 26);
+			fill(table + first, table + first + (size_t(1) << (table_bits - length)), entry);
+		}
+	}
+
+	size_t table_mask = (size_t(1) << table_bits) - 1;
+	vector<uint32_t> single_table(decode_table);
+	for (size_t index = 0; index < decode_table.size(); index++)
+	{
+		uint32_t entry = single_table[index];
+		unsigned int length = (entry >> 16) & 0x1F;
+		uint32_t next = single_table[(size_t(entry >> 26) << table_bits) | ((index << length) & table_mask)];
+		unsigned int next_length = (next >> 16) & 0x1F;
+		if (length + next_length > table_bits) continue;
+		decode_table[index] = (entry & 0xFF) | ((next & 0xFF) << 8) | ((length + next_length) << 16) | (1 << 21) | (length << 22) | (next & (0xFu << 26));
+	}
+}
+
+void ContextModel::writeHeader(unsigned char* header) const
+{
+	/*	Writes the model's header (see context_model.h). Each class's code lengths are taken from its
+		canonical header, without the magic number.
+	*/
+	header[0] = (unsigned char)(class_count);
+	for (int i = 0; i < 128; i++) header[1 + i] = (unsigned char)((context_class[i * 2] << 4) | context_class[i * 2 + 1]);
+	unsigned char tree_header[HuffmanTree::CANONICAL_HEADER_SIZE];
+	for (unsigned int c = 0; c < class_count; c++)
+	{
+		class_trees[c]->writeHeader(tree_header);
+		memcpy(header + 129 + c * 128, tree_header + 4, 128);
+	}
+}
+
+bool ContextModel::readHeader(const unsigned char* header, size_t size)
+{
+	/*	Reads the header written by writeHeader. Every class must have a complete code with no code longer
+		than MAXIMUM_CODE_LENGTH (which the encoder never goes past), so each is decoded with one lookup.
+	*/
+	if (size < 1 + 128 || header[0] < 2 || header[0] > MAXIMUM_CLASSES) return false;
+	class_count = header[0];
+	if (size < headerSize()) return false;
+	for (int i = 0; i < 128; i++)
+	{
+		context_class[i * 2] = header[1 + i] >> 4;
+		context_class[i * 2 + 1] = header[1 + i] & 0xF;
+	}
+	for (int i = 0; i < 256; i++) if (context_class[i] >= class_count) return false;
+
+	while (class_trees.size() < class_count) class_trees.emplace_back(new HuffmanTree());
+	unsigned char tree_header[HuffmanTree::CANONICAL_HEADER_SIZE];
+	memcpy(tree_header, CANONICAL_MAGIC, 4);
+	for (unsigned int c = 0; c < class_count; c++)
+	{
+		memcpy(tree_header + 4, header + 129 + c * 128, 128);
+		HuffmanTree &tree = *class_trees[c];
+		if (!tree.readHeader(tree_header, sizeof(tree_header))) return false;
+		tree.createCodeTable();
+		for (int i = 0; i < 256; i++)
+		{
+			if (tree.codeLength((unsigned char)(i)) < 1 || tree.codeLength((unsigned char)(i)) > MAXIMUM_CODE_LENGTH) return false;
+		}
+	}
+	makeDecodeTable();
+	return true;
+}
+
+void ContextModel::encodeBytes(const unsigned char* data, size_t size, BitWriter &writer, unsigned int previous) const
+{
+	/*	Packs the codes of 4 bytes at a time with one putBits (4 codes of at most 11 bits fit easily).
+		The previous bytes are known from the input, so the lookups don't wait on each other. A block
+		can be encoded in parts, each given the last byte of the part before (0 before the first).
+	*/
+	const uint32_t* code_table = codes.data();
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4)
+	{
+		uint32_t code0 = code_table[(previous << 8) | data[i]], code1 = code_table[(data[i] << 8) | data[i + 1]];
+		uint32_t code2 = code_table[(data[i + 1] << 8) | data[i + 2]], code3 = code_table[(data[i + 2] << 8) | data[i + 3]];
+		uint64_t group = code0 & 0xFFFF;
+		group = (group << (code1 >> 16)) | (code1 & 0xFFFF);
+		group = (group << (code2 >> 16)) | (code2 & 0xFFFF);
+		group = (group << (code3 >> 16)) | (code3 & 0xFFFF);
+		writer.putBits(group, (code0 >> 16) + (code1 >> 16) + (code2 >> 16) + (code3 >> 16));
+		previous = data[i + 3];
+	}
+	for (; i < size; i++)
+	{
+		uint32_t code = code_table[(previous << 8) | data[i]];
+		writer.putBits(code & 0xFFFF, code >> 16);
+		previous = data[i];
+	}
+}
+
+bool ContextModel::decode(const unsigned char* data, size_t size, unsigned char* output, size_t output_size) const
+{
+	/*	Looks up 5 entries for each 8 bytes loaded (5 entries of at most table_bits bits, after up to 7 bits
+		already used from the first byte, still fit in 64 bits). Each entry decodes one or two bytes, so the
+		fast loop stops with fewer than 10 to go. The rest are decoded one byte at a time, taking only the first
+		byte of an entry that has two, with the last bytes of the data copied into a buffer with room to load 8.
+	*/
+	const uint32_t* table = decode_table.data();
+	unsigned int shift = 64 - table_bits;
+	size_t table_offset = size_t(context_class[0]) << table_bits;
+	size_t bit_position = 0;
+	unsigned char* next_output = output;
+	unsigned char* output_end = output + output_size;
+	auto decodeEntry = [&](uint64_t &bits)
+	{
+		uint32_t entry = table[table_offset + size_t(bits >> shift)];
+		next_output[0] = (unsigned char)(entry);
+		next_output[1] = (unsigned char)(entry >> 8);
+		next_output += 1 + ((entry >> 21) & 1);
+		unsigned int length = (entry >> 16) & 0x1F;
+		bits <<= length;
+		bit_position += length;
+		table_offset = size_t(entry >> 26) << table_bits;
+	};
+
+	while (output_end - next_output >= 10 && (bit_position >> 3) + 8 <= size)
+	{
+		uint64_t bits = loadBigEndian64(data + (bit_position >> 3)) << (bit_position & 7);
+		decodeEntry(bits);
+		decodeEntry(bits);
+		decodeEntry(bits);
+		decodeEntry(bits);
+		decodeEntry(bits);
+	}
+
+	unsigned char tail[16] = { 0 };
+	size_t tail_start = size > 8 ? size - 8 : 0;
+	memcpy(tail, data + tail_start, size - tail_start);
+	while (next_output < output_end)
+	{
+		size_t byte_position = bit_position >> 3;
+		if (byte_position >= size) return false;
+		uint64_t bits = byte_position + 8 <= size ? loadBigEndian64(data + byte_position) : loadBigEndian64(tail + (byte_position - tail_start));
+		uint32_t entry = table[table_offset + size_t((bits << (bit_position & 7)) >> shift)];
+		unsigned char byte_value = (unsigned char)(entry);
+		*next_output++ = byte_value;
+		bit_position += (entry >> 22) & 0xF;
+		table_offset = size_t(context_class[byte_value]) << table_bits;
+	}
+	return bit_position <= size * 8 && size * 8 - bit_position < 8;
+}
@@ -0,0 +1,61 @@
+//	File:			context_model.h
+//	Description:	The order-1 context model of a BLOCK_CONTEXT block (see container.h). Instead of one tree for every
+//					byte of a block, each byte is coded with the tree of its context class: the class of the byte
+//					before it (the first byte of a block follows a 0). The 256 possible previous bytes are clustered
+//					into at most MAXIMUM_CLASSES classes whose following bytes are alike, and every class gets its own
+//					canonical code of at most MAXIMUM_CODE_LENGTH bits.
+//
+//					Each entry of the decoding table holds the decoded byte (or two, as in the order-0 decoder, with
+//					the second code found in the table of the first byte's class), its code length, and the class of
+//					the last byte, which picks the table for the next code. So switching tables costs no more than
+//					an order-0 decode: one table lookup per entry, with no lookup of the class in between.
+//
+//					The model's header (at the start of a BLOCK_CONTEXT payload):
+//						1	The number of classes (2 to MAXIMUM_CLASSES)
+//						128	The class of each previous byte value, packed two to a byte (the first in the high 4 bits)
+//						128	For each class, its code lengths, packed the same way (a canonical header without its magic)
+//					The codes follow, with no padding of their own: the block's decoded size says where they stop.
+
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "bitio.h"
+#include "huffman_tree.h"
+using namespace std;
+
+class ContextModel
+{
+public:
+	static const unsigned int MAXIMUM_CLASSES = 16;			// The most context classes (so a class fits in 4 bits).
+	static const unsigned int MAXIMUM_CODE_LENGTH = 11;		// The longest code, so every code is decoded with one lookup.
+
+	// Encoding Functions
+	void build(const unsigned char* data, size_t size, unsigned int max_length);	// Counts a block's bytes by context, clusters the contexts into classes, and makes a code (of at most max_length bits) for each class.
+	bool helps() const { return class_count > 1; }			// Whether the clustering found more than one class (with one, an order-0 tree is just as good).
+	uint64_t encodedSize() const { return encoded_size; }	// The size of the payload encodeBytes and writeHeader would make, found by build.
+	size_t headerSize() const { return 1 + 128 + size_t(class_count) * 128; }	// The size of the model's header.
+	void writeHeader(unsigned char* header) const;			// Writes the class count, the classes, and the code lengths of every class.
+	void encodeBytes(const unsigned char* data, size_t size, BitWriter &writer, unsigned int previous = 0) const;	// Packs the codes of a block's bytes (or of a part, after the byte previous) into the writer.
+
+	// Decoding Functions
+	bool readHeader(const unsigned char* header, size_t size);	// Reads a model's header and builds its decoding table. Returns false if it isn't valid.
+	bool decode(const unsigned char* data, size_t size, unsigned char* output, size_t output_size) const;	// Decodes output_size bytes from the codes after the header. Returns false if they don't fill exactly size bytes.
+
+private:
+	static const unsigned int CLUSTER_PASSES = 4;	// The passes made over the contexts, each moving every context to the class that codes it best.
+
+	unsigned int class_count = 0;
+	unsigned char context_class[256];				// The class of each previous byte value.
+	unsigned int table_bits = 0;					// The longest code of any class, which the decoding table is indexed by.
+	uint64_t encoded_size = 0;
+	vector<uint32_t> pair_counts;					// The count of each byte (the low 8 bits of the index) after each previous byte (the high 8 bits).
+	vector<unique_ptr<HuffmanTree>> class_trees;	// The tree of each class, kept between blocks so nothing is allocated again.
+	vector<uint32_t> codes;							// The code of each byte after each previous byte (indexed as pair_counts): the bits, with the length in the high 16 bits.
+	vector<uint32_t> decode_table;					// A table of 2^table_bits entries for each class. An entry holds the first byte it decodes (bits 0-7), the second (8-15),
+													// the bits it uses (16-20), whether it decodes two bytes (21), the length of the first code (22-25), and the class of the last byte (26-29).
+
+	unsigned int clusterContexts(unsigned int max_length);	// Sets context_class from the pair_counts, returning the number of classes.
+	void makeCodes();								// Makes the codes of every pair of bytes from the class trees.
+	void makeDecodeTable();							// Makes the decoding table from the class trees.
+};
@@ -0,0 +1,169 @@
+//	File:			crc32c.cpp
+//	Description:	The implementation of the CRC-32C checksum (see crc32c.h). The checksum is kept inverted (as the
+//					standard defines it) only at the edges: inside, it is the plain remainder, which is linear, so the
+//					remainders of three parts of the data can be joined by shifting the earlier ones past the later
+//					parts. Shifting by a lane is a multiplication by a fixed power of x, which is done from tables.
+//					The SSE4.2 version is compiled for SSE4.2 on its own (with a target attribute, or by MSVC as it
+//					is), and only called once the processor has been checked for it.
+
+#include "crc32c.h"
+#include "bitio.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CRC32C_X64
+#include <immintrin.h>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SSE42_FUNCTION
+#else
+#define SSE42_FUNCTION __attribute__((target("sse4.2")))
+#endif
+#endif
+
+static const uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;	// The Castagnoli polynomial, with its bits reversed.
+static const size_t CRC32C_LANE_SIZE = 4 << 10;			// The bytes of each of the three parts checked at once. Must be a power of 2.
+
+static uint32_t timesX(uint32_t value)
+{
+	/*	Multiplies a remainder by x (the bits are reversed, so x^0 is the top bit). */
+	return value & 1 ? (value >> 1) ^ CRC32C_POLYNOMIAL : value >> 1;
+}
+
+static uint32_t multiplyModP(uint32_t a, uint32_t b)
+{
+	/*	Multiplies two remainders, modulo the polynomial. */
+	uint32_t product = 0;
+	for (uint32_t bit = uint32_t(1) << 31; bit != 0; bit >>= 1)
+	{
+		if (a & bit) product ^= b;
+		b = timesX(b);
+	}
+	return product;
+}
+
+struct Crc32cTables
+{
+	/*	bytes[k][i] is the remainder of byte i followed by k zero bytes, for the table version.
+		lane_shift[k][i] is byte k of a remainder (holding i) shifted past CRC32C_LANE_SIZE zero bytes.
+	*/
+	uint32_t bytes[8][256];
+	uint32_t lane_shift[4][256];
+
+	Crc32cTables()
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t remainder = i;
+			for (int bit = 0; bit < 8; bit++) remainder = timesX(remainder);
+			bytes[0][i] = remainder;
+		}
+		for (int k = 1; k < 8; k++)
+		{
+			for (int i = 0; i < 256; i++) bytes[k][i] = (bytes[k - 1][i] >> 8) ^ bytes[0][bytes[k - 1][i] & 0xFF];
+		}
+
+		uint32_t power = uint32_t(1) << 31;				// x^0, then x^8 (one byte), then squared up to x^(8 * CRC32C_LANE_SIZE).
+		for (int bit = 0; bit < 8; bit++) power = timesX(power);
+		for (size_t n = 1; n < CRC32C_LANE_SIZE; n <<= 1) power = multiplyModP(power, power);
+		for (int k = 0; k < 4; k++)
+		{
+			for (uint32_t i = 0; i < 256; i++) lane_shift[k][i] = multiplyModP(i << (8 * k), power);
+		}
+	}
+};
+
+static const Crc32cTables tables;
+
+static uint32_t updateTable(uint32_t crc, const unsigned char* data, size_t size)
+{
+	/*	Adds data to a (not inverted) remainder 8 bytes at a time, looking up each byte
+		by how far it is from the end of the 8, then adds the bytes left one at a time.
+	*/
+	for (; size >= 8; data += 8, size -= 8)
+	{
+		uint32_t low = loadLittleEndian32(data) ^ crc, high = loadLittleEndian32(data + 4);
+		crc = tables.bytes[7][low & 0xFF] ^ tables.bytes[6][(low >> 8) & 0xFF] ^ tables.bytes[5][(low >> 16) & 0xFF] ^ tables.bytes[4][low >> 24] ^
+			tables.bytes[3][high & 0xFF] ^ tables.bytes[2][(high >> 8) & 0xFF] ^ tables.bytes[1][(high >> 16) & 0xFF] ^ tables.bytes[0][high >> 24];
+	}
+	for (; size > 0; data++, size--) crc = tables.bytes[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+#ifdef CRC32C_X64
+static bool hasSSE42()
+{
+	/*	Whether the processor has SSE4.2 (which has the crc32 instruction).
+	*/
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 20)) != 0;
+#else
+	__builtin_cpu_init();							// Needed when this runs before main, as it does for use_hardware.
+	return __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+static uint32_t shiftLane(uint32_t crc)
+{
+	/*	Shifts a remainder past CRC32C_LANE_SIZE zero bytes, one of its bytes at a time. */
+	return tables.lane_shift[0][crc & 0xFF] ^ tables.lane_shift[1][(crc >> 8) & 0xFF] ^ tables.lane_shift[2][(crc >> 16) & 0xFF] ^ tables.lane_shift[3][crc >> 24];
+}
+
+SSE42_FUNCTION static uint32_t updateSSE42(uint32_t crc, const unsigned char* data, size_t size)
+{
+	/*	Adds data to a (not inverted) remainder with the crc32 instruction. Each run of three lanes is
+		checked as three separate remainders at once (the last two starting from 0), then the first is
+		shifted past the second and joined to it, and the result shifted past the third and joined to it.
+	*/
+	uint64_t crc0 = crc;
+	for (; size >= 3 * CRC32C_LANE_SIZE; data += 3 * CRC32C_LANE_SIZE, size -= 3 * CRC32C_LANE_SIZE)
+	{
+		uint64_t crc1 = 0, crc2 = 0;
+		for (size_t i = 0; i < CRC32C_LANE_SIZE; i += 8)
+		{
+			uint64_t word0, word1, word2;
+			memcpy(&word0, data + i, 8);
+			memcpy(&word1, data + CRC32C_LANE_SIZE + i, 8);
+			memcpy(&word2, data + 2 * CRC32C_LANE_SIZE + i, 8);
+			crc0 = _mm_crc32_u64(crc0, word0);
+			crc1 = _mm_crc32_u64(crc1, word1);
+			crc2 = _mm_crc32_u64(crc2, word2);
+		}
+		crc0 = shiftLane(uint32_t(crc0)) ^ uint32_t(crc1);
+		crc0 = shiftLane(uint32_t(crc0)) ^ uint32_t(crc2);
+	}
+	for (; size >= 8; data += 8, size -= 8)
+	{
+		uint64_t word;
+		memcpy(&word, data, 8);
+		crc0 = _mm_crc32_u64(crc0, word);
+	}
+	uint32_t result = uint32_t(crc0);
+	for (; size > 0; data++, size--) result = _mm_crc32_u8(result, *data);
+	return result;
+}
+
+static const bool use_hardware = hasSSE42();
+#else
+static const bool use_hardware = false;
+#endif
+
+uint32_t crc32c(uint32_t crc, const unsigned char* data, size_t size)
+{
+#ifdef CRC32C_X64
+	if (use_hardware) return ~updateSSE42(~crc, data, size);
+#endif
+	return ~updateTable(~crc, data, size);
+}
+
+uint32_t crc32cTable(uint32_t crc, const unsigned char* data, size_t size)
+{
+	return ~updateTable(~crc, data, size);
+}
+
+bool crc32cHardware()
+{
+	return use_hardware;
+}
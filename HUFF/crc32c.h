@@ -0,0 +1,15 @@
+//	File:			crc32c.h
+//	Description:	The CRC-32C (Castagnoli) checksum that the block container format can keep for every block (see
+//					container.h). On x86-64 processors with SSE4.2 it is computed with the crc32 instruction, on three
+//					parts of the data at once (the instruction's result isn't ready for three cycles, so one part at
+//					a time would leave it idle), and the three results are joined into one. Elsewhere it is computed
+//					8 bytes at a time from tables. Both give exactly the same checksum.
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// The checksum of size bytes of data, carried on from the checksum of the bytes before them (start with 0).
+uint32_t crc32c(uint32_t crc, const unsigned char* data, size_t size);
+uint32_t crc32cTable(uint32_t crc, const unsigned char* data, size_t size);		// The same checksum, always from the tables (for benchmarks).
+bool crc32cHardware();								// Whether crc32c uses the processor's crc32 instruction.
@@ -0,0 +1,50 @@
+//	File:			encode_kernels.cpp
+//	Description:	The implementation of the encoding kernels (see encode_kernels.h).
+
+#include "encode_kernels.h"
+
+const char* const ENCODE_KERNEL_NAMES[ENCODE_KERNELS] = { "scalar", "grouped" };
+
+static EncodeKernel active_kernel = ENCODE_KERNEL_GROUPED;
+
+EncodeKernel encodeKernel()
+{
+	return active_kernel;
+}
+
+void setEncodeKernel(EncodeKernel kernel)
+{
+	active_kernel = kernel;
+}
+
+void encodeGrouped(const uint64_t packed_codes[256], unsigned int group_size, const unsigned char* data, size_t size, BitWriter &writer)
+{
+	/*	Merges the codes of each group of bytes (both pairs of a group of 4 at the same time),
+		then adds the group to the writer with a single putBits. The bytes left over at the end
+		are added one at a time.
+	*/
+	size_t i = 0;
+	if (group_size == 4)
+	{
+		for (; i + 4 <= size; i += 4)
+		{
+			uint64_t code0 = packed_codes[data[i]], code1 = packed_codes[data[i + 1]];
+			uint64_t code2 = packed_codes[data[i + 2]], code3 = packed_codes[data[i + 3]];
+			unsigned int length1 = (unsigned int)(code1 >> 32), length3 = (unsigned int)(code3 >> 32);
+			uint64_t first_pair = ((code0 & 0xFFFFFFFF) << length1) | (code1 & 0xFFFFFFFF);
+			uint64_t second_pair = ((code2 & 0xFFFFFFFF) << length3) | (code3 & 0xFFFFFFFF);
+			unsigned int second_length = (unsigned int)(code2 >> 32) + length3;
+			writer.putBits((first_pair << second_length) | second_pair, (unsigned int)(code0 >> 32) + length1 + second_length);
+		}
+	}
+	else
+	{
+		for (; i + 2 <= size; i += 2)
+		{
+			uint64_t code0 = packed_codes[data[i]], code1 = packed_codes[data[i + 1]];
+			unsigned int length1 = (unsigned int)(code1 >> 32);
+			writer.putBits(((code0 & 0xFFFFFFFF) << length1) | (code1 & 0xFFFFFFFF), (unsigned int)(code0 >> 32) + length1);
+		}
+	}
+	for (; i < size; i++) writer.putBits(packed_codes[data[i]] & 0xFFFFFFFF, (unsigned int)(packed_codes[data[i]] >> 32));
+}
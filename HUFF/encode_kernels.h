@@ -0,0 +1,33 @@
+//	File:			encode_kernels.h
+//	Description:	The kernels that pack codes into a BitWriter. When every code of a tree is short, the codes of 2 or 4
+//					bytes are merged into one before being added to the writer, so the writer's serial shift and store is
+//					paid once per group instead of once per byte. The merging doesn't depend on the writer, so it runs in
+//					parallel with it, with plain integer code on any processor. (An AVX2 version, with gathers and vector
+//					shifts, measured no faster on some processors, so it is kept in HUFFBENCH to compare against: see
+//					avx2_encode.h there.) Every kernel writes exactly the same bits.
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "bitio.h"
+
+enum EncodeKernel
+{
+	ENCODE_KERNEL_SCALAR,							// One putBits for every byte (the reference the others are checked against).
+	ENCODE_KERNEL_GROUPED,							// Groups of codes merged with integer code, on any processor.
+	ENCODE_KERNELS
+};
+
+extern const char* const ENCODE_KERNEL_NAMES[ENCODE_KERNELS];
+
+static const unsigned int ENCODE_PAIR_LENGTH = BitWriter::MAX_CODE_LENGTH / 2;		// The longest code that can be merged in pairs.
+static const unsigned int ENCODE_QUAD_LENGTH = BitWriter::MAX_CODE_LENGTH / 4;		// The longest code that can be merged in groups of 4.
+static const unsigned int PAIR_LENGTH_SHIFT = 56;									// Where the length is kept in an entry of a pair table (see HuffmanTree::buildPairTable).
+static const uint64_t PAIR_BITS_MASK = (uint64_t(1) << PAIR_LENGTH_SHIFT) - 1;		// The bits of an entry of a pair table.
+
+EncodeKernel encodeKernel();						// The kernel encodeBytes uses (the grouped one, unless changed).
+void setEncodeKernel(EncodeKernel kernel);			// Changes the kernel encodeBytes uses. Only for benchmarks, before any encoding starts.
+
+// Packs the codes of a range of bytes into the writer, in groups of group_size (2 or 4). Each entry of packed_codes is a
+// code's bits in the low 32 bits and its length in the high 32 bits, and no code may be longer than the group allows.
+void encodeGrouped(const uint64_t packed_codes[256], unsigned int group_size, const unsigned char* data, size_t size, BitWriter &writer);
@@ -0,0 +1,160 @@
+//	File:			estimate.cpp
+//	Description:	The Huffman methods that predict the size of an encoded file without encoding it. The input is cut into
+//					units (ESTIMATE_SAMPLE_SIZE bytes for a single stream, or the blocks the encoder would make), and a few of
+//					them, spread evenly over the file, are read straight from the mapped file. A single stream's tree is made
+//					from the counts of all the samples, and each sample's bits are found from its counts and the code lengths.
+//					Each sampled block is sized exactly as the encoder would store it. The ratio of the samples is taken as the
+//					file's, and how much the samples differ from that ratio gives its standard error, and so the confidence.
+
+#include "huffman.h"
+#include <cmath>
+
+HuffmanEstimate Huffman::EstimateFile(string inputFile)
+{
+	/*	A public method that opens the input file, then predicts the size EncodeFile would write
+		for it with the current options. Nothing is written.
+	*/
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	InputFile file_input;
+	openInput(file_input, inputFile);
+	HuffmanEstimate result = estimate_(file_input);
+	file_input.close();
+	return result;
+}
+
+HuffmanEstimate Huffman::estimate(byte_span input)
+{
+	/*	Predicts the size compress would make of a range of memory, as EstimateFile does for a file.
+	*/
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	InputFile memory_input;
+	memory_input.openMemory(input);
+	return estimate_(memory_input);
+}
+
+HuffmanEstimate Huffman::estimate_(InputFile &file_input)
+{
+	/*	Reads the sampled units of the input a batch at a time (only ESTIMATE_SAMPLES, or ESTIMATE_BLOCK_SAMPLES
+		blocks, of a file with more), and counts or sizes them on thread_count threads. A stream that can't seek
+		is read to its end, every block of it sized, since there is no knowing where its samples should be.
+		When every unit is read, the size is exact, except that the adaptive option may do better by reusing
+		trees, which isn't counted. Otherwise the ratio of the whole file is taken to be that of the samples
+		(the ratio estimator), with the standard error of a sample without replacement from the file's units.
+	*/
+	bool seekable = file_input.isSeekable();
+	bool container = options.chunked || options.interleaved || options.adaptive || options.checksum || options.context || !seekable;	// As encode_ decides.
+	size_t unit_size = container ? options.block_size : ESTIMATE_SAMPLE_SIZE;
+	uint64_t sample_limit = container ? ESTIMATE_BLOCK_SAMPLES : ESTIMATE_SAMPLES;
+	uint64_t unit_count = seekable ? (file_input.size() + unit_size - 1) / unit_size : 0;	// Only known for a file that can seek.
+	bool sampled = unit_count > sample_limit;
+	uint64_t sample_count = sampled ? sample_limit : unit_count;
+
+	size_t batch_size = size_t(thread_count) * 2;
+	vector<vector<unsigned char>> input_buffers(batch_size);	// Used only when the input isn't mapped.
+	vector<byte_span> units(batch_size);
+	vector<uint64_t> unit_sizes;							// The size of every unit read.
+	vector<uint64_t> unit_bytes;							// The stored size of every block read (when encoding in blocks).
+	vector<uint64_t> unit_counts;							// The byte counts of every unit read, 256 each (when encoding a single stream).
+	if (container) reserveBlockTrees(batch_size);
+	uint64_t next_sample = 0;
+	bool end_of_input = false;
+	while (!end_of_input)
+	{
+		size_t batch_count = 0;
+		while (batch_count < batch_size)				// Gather the next batch of units.
+		{
+			if (seekable)
+			{
+				if (next_sample == sample_count)
+				{
+					end_of_input = true;
+					break;
+				}
+				file_input.seek(next_sample * unit_count / sample_count * unit_size);	// Start on a unit, so sampled blocks are the encoder's blocks.
+				next_sample++;
+			}
+			size_t size = file_input.nextBlock(units[batch_count], unit_size, input_buffers[batch_count]);
+			if (size > 0) batch_count++;
+			if (!seekable && size < unit_size)
+			{
+				end_of_input = true;
+				break;
+			}
+		}
+
+		size_t first = unit_sizes.size();
+		unit_sizes.resize(first + batch_count);
+		if (container) unit_bytes.resize(first + batch_count);
+		else unit_counts.resize((first + batch_count) * 256, 0);
+		parallelFor(batch_count, thread_count, [&](size_t i)
+		{
+			unit_sizes[first + i] = units[i].size;
+			if (container) unit_bytes[first + i] = estimateBlock(*block_trees[i], *block_models[i], units[i].data, units[i].size);
+			else
+			{
+				PhaseTimer timer(stats_counters.get(), PHASE_FREQUENCY);
+				countBytes(units[i].data, units[i].size, &unit_counts[(first + i) * 256]);
+			}
+		});
+	}
+
+	HuffmanEstimate result;
+	result.input_bytes = seekable ? file_input.size() : file_input.position();
+	size_t read_count = unit_sizes.size();
+	vector<double> encoded(read_count);						// The encoded bytes of each unit (not rounded, for a single stream's part of one).
+	uint64_t overhead = 0;									// The bytes that don't grow with the input: the headers, or the tree header.
+	uint64_t exact_bytes = 0;								// The encoded bytes of every unit, when every unit was read.
+	if (container)
+	{
+		for (size_t i = 0; i < read_count; i++)
+		{
+			encoded[i] = double(unit_bytes[i]);
+			exact_bytes += unit_bytes[i];
+		}
+		overhead = containerOverhead(seekable ? unit_count : read_count);
+	}
+	else
+	{
+		uint64_t counts[256] = { 0 };
+		for (size_t i = 0; i < read_count; i++)
+		{
+			for (int j = 0; j < 256; j++) counts[j] += unit_counts[i * 256 + j];
+		}
+		file_tree.setWeights(counts);
+		createTree(file_tree);								// The tree of the samples stands in for the file's.
+		{
+			PhaseTimer timer(stats_counters.get(), PHASE_CODE_TABLES);
+			file_tree.createCodeTable();
+		}
+		for (size_t i = 0; i < read_count; i++) encoded[i] = file_tree.encodedBits(&unit_counts[i * 256]) / 8.0;
+		overhead = file_tree.headerSize();
+		exact_bytes = (file_tree.encodedBits(counts) + 7) / 8;
+	}
+
+	double sampled_bytes = 0, sampled_encoded = 0;
+	for (size_t i = 0; i < read_count; i++)
+	{
+		sampled_bytes += double(unit_sizes[i]);
+		sampled_encoded += encoded[i];
+	}
+	result.sampled_bytes = uint64_t(sampled_bytes);
+	result.exact = !sampled && !options.adaptive;
+	if (!sampled) result.encoded_bytes = overhead + exact_bytes;
+	else
+	{
+		double unit_ratio = sampled_encoded / sampled_bytes;	// The encoded bytes of each input byte, without the overhead.
+		double mean_size = sampled_bytes / read_count;
+		double residuals = 0;								// How far each sample is from the unit ratio, in bytes.
+		for (size_t i = 0; i < read_count; i++)
+		{
+			double residual = encoded[i] - unit_ratio * unit_sizes[i];
+			residuals += residual * residual;
+		}
+		double variance = (1 - double(read_count) / double(unit_count)) * residuals / (read_count - 1) / (read_count * mean_size * mean_size);
+		result.encoded_bytes = overhead + uint64_t(llround(unit_ratio * double(result.input_bytes)));
+		result.standard_error = sqrt(variance);				// The overhead is known, so the error of the ratio is all the unit ratio's.
+		result.confidence = result.standard_error > 0 ? erf(ESTIMATE_TOLERANCE / (result.standard_error * sqrt(2.0))) : 1;
+	}
+	if (result.input_bytes > 0) result.ratio = double(result.encoded_bytes) / double(result.input_bytes);
+	return result;
+}
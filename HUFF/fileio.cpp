@@ -0,0 +1,415 @@
+//	File:			fileio.cpp
+//	Description:	The implementation of the memory mapped (or block read) input files, and the buffered output files.
+//					Mapping uses the Windows file mapping API or POSIX mmap, depending on the platform.
+
+#include "fileio.h"
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static void setBinaryMode(FILE* file)
+{
+	/*	Windows translates line endings on the standard streams unless they are
+		switched to binary mode. Other platforms never translate them.
+	*/
+#if defined(_WIN32)
+	_setmode(_fileno(file), _O_BINARY);
+#else
+	(void)file;
+#endif
+}
+
+InputFile::InputFile()
+{
+}
+
+InputFile::~InputFile()
+{
+	close();
+}
+
+bool InputFile::open(const string &path)
+{
+	/*	Opens the file, first trying to map the whole thing into memory.
+		If the file can't be mapped (it is too big for the address space, or isn't
+		a regular file) it is opened as a stream and read in blocks instead.
+		The path "-" reads standard input.
+	*/
+	close();
+	read_position = 0;
+	if (path == STANDARD_STREAM)
+	{
+		setBinaryMode(stdin);
+		source = &cin;
+		file_size = 0;									// Standard input can't seek, so its size is unknown.
+		block.resize(BLOCK_SIZE);
+		is_open = true;
+		return true;
+	}
+	if (mapFile(path))
+	{
+		is_open = true;
+		mapped = true;
+		seekable = true;
+		return true;
+	}
+
+	stream.open(path, ios::binary | ios::in);
+	if (!stream) return false;
+	stream.seekg(0, ios::end);							// Find the size of the file.
+	streamoff end = stream.tellg();
+	stream.clear();
+	if (end >= 0)
+	{
+		file_size = uint64_t(end);
+		seekable = true;
+		stream.seekg(0);
+	}
+	else file_size = 0;									// Pipes and devices can't seek, so their size is unknown.
+	block.resize(BLOCK_SIZE);
+	is_open = true;
+	return true;
+}
+
+bool InputFile::openMemory(byte_span contents)
+{
+	/*	Reads from bytes already in memory, as if they were a mapped file. The memory
+		still belongs to the caller, and must stay valid until the file is closed.
+	*/
+	close();
+	read_position = 0;
+	mapped_data = contents.size > 0 ? contents.data : NULL;
+	file_size = contents.size;
+	borrowed = true;
+	mapped = true;
+	seekable = true;
+	is_open = true;
+	return true;
+}
+
+void InputFile::close()
+{
+	/*	Unmaps or closes the file, whichever way it was opened.
+	*/
+	unmapFile();
+	if (stream.is_open()) stream.close();
+	stream.clear();
+	lookahead.clear();
+	source = &stream;
+	is_open = false;
+	mapped = false;
+	seekable = false;
+	file_size = 0;
+}
+
+byte_span InputFile::contents() const
+{
+	/*	The whole mapped file as a single span.
+	*/
+	byte_span span = { mapped_data, size_t(file_size) };
+	return span;
+}
+
+void InputFile::seek(uint64_t offset)
+{
+	/*	Moves the position the next read or block starts at. Mapped files
+		stop at the end of the file.
+	*/
+	if (mapped)
+	{
+		read_position = offset < file_size ? offset : file_size;
+		return;
+	}
+	read_position = offset;
+	lookahead.clear();
+	if (seekable)
+	{
+		stream.clear();
+		stream.seekg(streamoff(read_position));
+	}
+}
+
+size_t InputFile::read(unsigned char* buffer, size_t size)
+{
+	/*	Copies up to size bytes from the read position into the buffer, and moves
+		the read position past them. Returns the number of bytes copied.
+	*/
+	if (isMapped())
+	{
+		uint64_t remaining = file_size - read_position;
+		if (size > remaining) size = size_t(remaining);
+		if (size > 0) memcpy(buffer, mapped_data + read_position, size);
+		read_position += size;
+		return size;
+	}
+	size_t bytes_read = 0;
+	if (!lookahead.empty())								// Anything that was peeked at comes first.
+	{
+		bytes_read = size < lookahead.size() ? size : lookahead.size();
+		memcpy(buffer, lookahead.data(), bytes_read);
+		lookahead.erase(lookahead.begin(), lookahead.begin() + bytes_read);
+	}
+	PhaseTimer io_wait(PHASE_IO);
+	source->read((char*)buffer + bytes_read, streamsize(size - bytes_read));
+	bytes_read += size_t(source->gcount());
+	read_position += bytes_read;
+	return bytes_read;
+}
+
+size_t InputFile::peek(unsigned char* buffer, size_t size)
+{
+	/*	Copies up to size bytes from the read position, but leaves the read position
+		where it is. Streams keep the bytes aside for the next read, so this works even
+		when the input can't seek (a pipe). Returns the number of bytes copied.
+	*/
+	if (isMapped())
+	{
+		uint64_t remaining = file_size - read_position;
+		if (size > remaining) size = size_t(remaining);
+		if (size > 0) memcpy(buffer, mapped_data + read_position, size);
+		return size;
+	}
+	if (lookahead.size() < size)
+	{
+		size_t have = lookahead.size();
+		lookahead.resize(size);
+		PhaseTimer io_wait(PHASE_IO);
+		source->read((char*)lookahead.data() + have, streamsize(size - have));
+		lookahead.resize(have + size_t(source->gcount()));
+	}
+	size_t bytes_copied = size < lookahead.size() ? size : lookahead.size();
+	if (bytes_copied > 0) memcpy(buffer, lookahead.data(), bytes_copied);
+	return bytes_copied;
+}
+
+bool InputFile::nextBlock(byte_span &next)
+{
+	/*	Gives the next block of the file. A mapped file is handed out all at once
+		(from the read position to the end), with no copying. Otherwise, the next
+		BLOCK_SIZE bytes are read into the block buffer.
+	*/
+	if (isMapped())
+	{
+		if (read_position >= file_size) return false;
+		next.data = mapped_data + read_position;
+		next.size = size_t(file_size - read_position);
+		read_position = file_size;
+		return true;
+	}
+	size_t bytes_read = read(block.data(), block.size());
+	next.data = block.data();
+	next.size = bytes_read;
+	return bytes_read > 0;
+}
+
+size_t InputFile::nextBlock(byte_span &next, size_t size, vector<unsigned char> &buffer)
+{
+	/*	Gives the next size bytes of the file (fewer at the end). Mapped files give a span of the
+		mapping itself. Otherwise the bytes are read into the caller's buffer, so several blocks
+		can be kept at once.
+	*/
+	if (isMapped())
+	{
+		uint64_t remaining = file_size - read_position;
+		if (size > remaining) size = size_t(remaining);
+		next.data = mapped_data + read_position;
+		next.size = size;
+		read_position += size;
+		return size;
+	}
+	buffer.resize(size);
+	next.size = read(buffer.data(), size);
+	next.data = buffer.data();
+	return next.size;
+}
+
+bool InputFile::mapFile(const string &path)
+{
+	/*	Maps the whole file into memory for reading. Returns false if this isn't possible,
+		in which case nothing is left open. Empty files are "mapped" with no view at all.
+	*/
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || uint64_t(size.QuadPart) > uint64_t(SIZE_MAX / 2))	// Leave files too big for the address space to the stream.
+	{
+		CloseHandle(file);
+		return false;
+	}
+	file_size = uint64_t(size.QuadPart);
+	if (file_size == 0)
+	{
+		CloseHandle(file);
+		return true;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	file_handle = file;
+	mapping_handle = mapping;
+	mapped_data = (const unsigned char*)view;
+	return true;
+#else
+	int descriptor = ::open(path.c_str(), O_RDONLY);
+	if (descriptor < 0) return false;
+	struct stat info;
+	if (fstat(descriptor, &info) != 0 || !S_ISREG(info.st_mode) || uint64_t(info.st_size) > uint64_t(SIZE_MAX / 2))	// Only regular files that fit can be mapped.
+	{
+		::close(descriptor);
+		return false;
+	}
+	file_size = uint64_t(info.st_size);
+	if (file_size == 0)
+	{
+		::close(descriptor);
+		return true;
+	}
+	void* view = mmap(NULL, size_t(file_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (view == MAP_FAILED)
+	{
+		::close(descriptor);
+		return false;
+	}
+	madvise(view, size_t(file_size), MADV_SEQUENTIAL);	// The kernels read straight through, so let the OS read ahead.
+	file_descriptor = descriptor;
+	mapped_data = (const unsigned char*)view;
+	return true;
+#endif
+}
+
+void InputFile::unmapFile()
+{
+	/*	Releases the mapped view and the handles behind it, if there are any.
+		Memory given to openMemory belongs to the caller, so it is left alone.
+	*/
+	if (borrowed)
+	{
+		mapped_data = NULL;
+		borrowed = false;
+		return;
+	}
+#if defined(_WIN32)
+	if (mapped_data != NULL) UnmapViewOfFile(mapped_data);
+	if (mapping_handle != NULL) CloseHandle((HANDLE)mapping_handle);
+	if (file_handle != NULL) CloseHandle((HANDLE)file_handle);
+	mapping_handle = NULL;
+	file_handle = NULL;
+#else
+	if (mapped_data != NULL) munmap((void*)mapped_data, size_t(file_size));
+	if (file_descriptor >= 0) ::close(file_descriptor);
+	file_descriptor = -1;
+#endif
+	mapped_data = NULL;
+}
+
+OutputFile::OutputFile()
+{
+}
+
+OutputFile::~OutputFile()
+{
+	close();
+}
+
+bool OutputFile::open(const string &path)
+{
+	/*	Opens the output file in binary mode. The buffer is kept from the last file, and only grows
+		(up to BUFFER_SIZE) as it is needed, so writing many small files doesn't clear a large buffer
+		for each one. The path "-" writes to standard output.
+	*/
+	close();
+	write_failed = false;
+	if (path == STANDARD_STREAM)
+	{
+		setBinaryMode(stdout);
+		destination = &cout;
+	}
+	else
+	{
+		stream.open(path, ios::binary | ios::out | ios::trunc);
+		if (!stream) return false;
+		destination = &stream;
+	}
+	buffered = 0;
+	return true;
+}
+
+void OutputFile::write(const unsigned char* data, size_t size)
+{
+	/*	Adds bytes to the buffer, writing the buffer out when it fills.
+		Big writes go straight to the file once the buffer is emptied.
+		A failed write (such as to a full disk) is only recorded, since this may run on the pipeline's
+		writing thread. The caller checks failed once the file is closed.
+	*/
+	if (size == 0 || write_failed) return;
+	if (buffered + size > buffer.size() && buffer.size() < BUFFER_SIZE)	// Grow the buffer first, if it isn't full size yet.
+	{
+		size_t new_size = buffer.size() * 2 > buffered + size ? buffer.size() * 2 : buffered + size;
+		buffer.resize(new_size < BUFFER_SIZE ? new_size : BUFFER_SIZE);
+	}
+	if (buffered + size > buffer.size())
+	{
+		flush();
+		if (size >= buffer.size())
+		{
+			PhaseTimer io_wait(PHASE_IO);
+			destination->write((const char*)data, streamsize(size));
+			if (!destination->good()) write_failed = true;
+			return;
+		}
+	}
+	memcpy(buffer.data() + buffered, data, size);
+	buffered += size;
+}
+
+void OutputFile::flush()
+{
+	/*	Writes out everything waiting in the buffer.
+	*/
+	if (buffered == 0) return;
+	PhaseTimer io_wait(PHASE_IO);
+	if (!write_failed) destination->write((const char*)buffer.data(), streamsize(buffered));
+	if (!destination->good()) write_failed = true;
+	buffered = 0;
+}
+
+void OutputFile::close()
+{
+	/*	Writes out the buffer and closes the file, noting whether the last of it was written.
+	*/
+	if (destination == NULL) return;
+	flush();
+	PhaseTimer io_wait(PHASE_IO);
+	destination->flush();
+	if (!destination->good()) write_failed = true;
+	if (stream.is_open())
+	{
+		stream.close();
+		if (stream.fail()) write_failed = true;
+	}
+	destination = NULL;
+}
@@ -0,0 +1,142 @@
+//	File:			fileio.h
+//	Description:	The file input and output layer used by the Huffman class. Input files are memory mapped when
+//					possible, so the encoding and decoding kernels can work directly on the file's bytes. When a file
+//					can't be mapped, it is read in large blocks instead. Output is collected in a large reusable
+//					buffer and written in big pieces. The path "-" stands for standard input or output, which
+//					are read and written as streams.
+
+#pragma once
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "stats.h"
+#include "crc32c.h"
+using namespace std;
+
+static const char STANDARD_STREAM[] = "-";			// The path that means standard input (or output).
+
+struct byte_span
+{
+	/*	A read-only range of bytes. The bytes are owned by someone else (usually an InputFile). */
+
+	const unsigned char* data;						// The first byte of the range.
+	size_t size;									// The number of bytes in the range.
+};
+
+class ByteSink
+{
+	/*	Something that encoded or decoded bytes can be written to. */
+public:
+	virtual ~ByteSink() {}
+	virtual void write(const unsigned char* data, size_t size) = 0;	// Writes size bytes to the sink.
+};
+
+class VectorSink : public ByteSink
+{
+	/*	A sink that appends everything written to it onto a vector in memory. */
+public:
+	VectorSink(vector<unsigned char> &output) : output(output) {}
+	void write(const unsigned char* data, size_t size) { output.insert(output.end(), data, data + size); }
+
+private:
+	vector<unsigned char> &output;					// The vector bytes are added to.
+};
+
+class CountingSink : public ByteSink
+{
+	/*	A sink that passes everything on to another sink, counting the bytes as they go by. */
+public:
+	CountingSink(ByteSink &destination) : destination(destination) {}
+	void write(const unsigned char* data, size_t size) { bytes_written += size; destination.write(data, size); }
+	uint64_t bytesWritten() const { return bytes_written; }
+
+private:
+	ByteSink &destination;							// The sink the bytes are passed on to.
+	uint64_t bytes_written = 0;
+};
+
+class ChecksumSink : public ByteSink
+{
+	/*	A sink that passes everything on to another sink, taking the CRC-32C of the bytes as they go by,
+		while they are still in cache. */
+public:
+	ChecksumSink(ByteSink &destination) : destination(destination) {}
+	void write(const unsigned char* data, size_t size) { checksum = crc32c(checksum, data, size); destination.write(data, size); }
+	uint32_t checksumWritten() const { return checksum; }
+
+private:
+	ByteSink &destination;							// The sink the bytes are passed on to.
+	uint32_t checksum = 0;
+};
+
+class InputFile
+{
+	/*	Read access to an input file. The whole file is memory mapped if it can be, in which case contents()
+		gives the file as a single span with no copying. Otherwise the file is read through a stream, one
+		block at a time, into a reusable buffer.
+	*/
+public:
+	static const size_t BLOCK_SIZE = 1 << 20;		// The size of the blocks that are read when the file is not mapped.
+
+	InputFile();
+	~InputFile();
+	bool open(const string &path);					// Opens (and maps if possible) the file. Returns false if it can't be opened.
+	bool openMemory(byte_span contents);			// Reads from a range of memory instead of a file, as if it were mapped.
+	void close();									// Unmaps and closes the file.
+	bool isMapped() const { return mapped; }		// Whether contents() can be used.
+	bool isSeekable() const { return seekable; }	// Whether seek can move back to read the file again (false for pipes and standard input).
+	byte_span contents() const;						// The entire mapped file.
+	uint64_t size() const { return file_size; }		// The size of the file, in bytes.
+	uint64_t position() const { return read_position; }	// The offset that the next read starts at.
+	void seek(uint64_t offset);						// Moves the read position to offset.
+	size_t read(unsigned char* buffer, size_t size);	// Copies up to size bytes from the read position into the buffer. Returns the number copied.
+	size_t peek(unsigned char* buffer, size_t size);	// Copies up to size bytes from the read position without moving past them (works on pipes too).
+	bool nextBlock(byte_span &block);				// Gives the next block of the file from the read position. Mapped files are given as one block. Returns false at the end of the file.
+	size_t nextBlock(byte_span &block, size_t size, vector<unsigned char> &buffer);	// Gives up to size bytes from the read position, mapped or read into the buffer. Returns the size given.
+
+private:
+	bool is_open = false;
+	bool mapped = false;							// Whether the file was mapped (an empty file counts as mapped, with no view).
+	bool borrowed = false;							// Whether mapped_data is the caller's memory (from openMemory) rather than a mapping.
+	bool seekable = false;							// Whether the file has a known size, and can be read more than once.
+	uint64_t file_size = 0;
+	uint64_t read_position = 0;
+	const unsigned char* mapped_data = NULL;		// The mapped view of the file, or NULL if the file is read through the stream.
+	ifstream stream;								// The stream used when the file could not be mapped.
+	istream* source = &stream;						// The stream actually read: the file's stream, or standard input.
+	vector<unsigned char> block;					// The buffer that blocks are read into when the file is not mapped.
+	vector<unsigned char> lookahead;				// Bytes taken from the stream by peek that haven't been read yet.
+#if defined(_WIN32)
+	void* file_handle = NULL;						// The Windows file and mapping handles.
+	void* mapping_handle = NULL;
+#else
+	int file_descriptor = -1;						// The POSIX file descriptor that is mapped.
+#endif
+	bool mapFile(const string &path);				// Tries to memory map the whole file.
+	void unmapFile();
+};
+
+class OutputFile : public ByteSink
+{
+	/*	A file that output is written to through a large reusable buffer. Writes that are at least as big as
+		the buffer skip it and go straight to the file.
+	*/
+public:
+	static const size_t BUFFER_SIZE = 1 << 20;		// The size of the output buffer.
+
+	OutputFile();
+	~OutputFile();
+	bool open(const string &path);					// Opens (truncating) the file. Returns false if it can't be opened.
+	void write(const unsigned char* data, size_t size);	// Writes bytes to the file through the buffer.
+	void flush();									// Writes everything in the buffer to the file.
+	void close();									// Flushes and closes the file.
+	bool failed() const { return write_failed; }	// Whether any write to the file (or its closing) has failed since it was opened.
+
+private:
+	ofstream stream;								// The file being written.
+	ostream* destination = NULL;					// The stream actually written: the file's stream, or standard output.
+	bool write_failed = false;						// Set by the first write that fails, after which nothing more is written.
+	vector<unsigned char> buffer;					// The output buffer.
+	size_t buffered = 0;							// The number of bytes waiting in the buffer.
+};
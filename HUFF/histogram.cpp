@@ -0,0 +1,78 @@
+//	File:			histogram.cpp
+//	Description:	The implementation of the byte counting kernel. See histogram.h.
+
+#include "histogram.h"
+#include "parallel.h"
+#include <cstring>
+
+static const size_t HISTOGRAM_FOLD_SIZE = size_t(1) << 30;	// Bytes counted before the 32-bit tables are added into the totals (so they can never overflow).
+
+void countBytes(const unsigned char* data, size_t size, uint64_t counts[256])
+{
+	/*	Counts 16 bytes per step into 4 separate 32-bit tables, one for each byte of a
+		4 byte group. Repeated bytes then go to different tables, so an increment never has
+		to wait on the store of the one before it. The tables are added into counts every
+		HISTOGRAM_FOLD_SIZE bytes, and at the end.
+	*/
+	uint32_t tables[4][256];
+	while (size > 0)
+	{
+		size_t piece = size < HISTOGRAM_FOLD_SIZE ? size : HISTOGRAM_FOLD_SIZE;
+		memset(tables, 0, sizeof(tables));
+
+		size_t i = 0;
+		for (; i + 16 <= piece; i += 16)
+		{
+			uint64_t first, second;						// Load the 16 bytes as two words, then pick the bytes out of them.
+			memcpy(&first, data + i, 8);
+			memcpy(&second, data + i + 8, 8);
+			for (int shift = 0; shift < 64; shift += 32)
+			{
+				tables[0][(first >> shift) & 0xFF]++;
+				tables[1][(first >> (shift + 8)) & 0xFF]++;
+				tables[2][(first >> (shift + 16)) & 0xFF]++;
+				tables[3][(first >> (shift + 24)) & 0xFF]++;
+				tables[0][(second >> shift) & 0xFF]++;
+				tables[1][(second >> (shift + 8)) & 0xFF]++;
+				tables[2][(second >> (shift + 16)) & 0xFF]++;
+				tables[3][(second >> (shift + 24)) & 0xFF]++;
+			}
+		}
+		for (; i < piece; i++) tables[0][data[i]]++;		// Count whatever didn't fill a whole step.
+
+		for (int value = 0; value < 256; value++)
+		{
+			counts[value] += uint64_t(tables[0][value]) + tables[1][value] + tables[2][value] + tables[3][value];
+		}
+		data += piece;
+		size -= piece;
+	}
+}
+
+void buildHistogram(const unsigned char* data, size_t size, uint64_t counts[256], unsigned int threads)
+{
+	/*	Splits the range into one piece per thread (each at least HISTOGRAM_THREAD_MINIMUM bytes),
+		counts the pieces at the same time into separate tables, then adds them together.
+	*/
+	size_t pieces = size / HISTOGRAM_THREAD_MINIMUM;
+	if (pieces > threads) pieces = threads;
+	if (pieces <= 1)
+	{
+		countBytes(data, size, counts);
+		return;
+	}
+
+	size_t piece_size = size / pieces;
+	vector<uint64_t> partial_counts(pieces * 256, 0);		// Every piece counts into its own table.
+	parallelFor(pieces, threads, [&](size_t piece)
+	{
+		size_t start = piece * piece_size;
+		size_t length = piece + 1 == pieces ? size - start : piece_size;		// The last piece takes the remainder.
+		countBytes(data + start, length, &partial_counts[piece * 256]);
+	});
+
+	for (size_t piece = 0; piece < pieces; piece++)		// Merge the partial counts.
+	{
+		for (int value = 0; value < 256; value++) counts[value] += partial_counts[piece * 256 + value];
+	}
+}
@@ -0,0 +1,13 @@
+//	File:			histogram.h
+//	Description:	The byte counting kernel used for the frequency table. Counts go into several flat tables
+//					that are used in turn, so runs of the same byte don't wait on each other's increments. Large
+//					inputs are split between threads and the partial counts added together at the end.
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+static const size_t HISTOGRAM_THREAD_MINIMUM = 4 << 20;	// The least input given to each thread. Smaller inputs are counted on one thread.
+
+void countBytes(const unsigned char* data, size_t size, uint64_t counts[256]);	// Adds the count of each byte value in the range to counts, on this thread.
+void buildHistogram(const unsigned char* data, size_t size, uint64_t counts[256], unsigned int threads);	// Adds the counts of the range to counts, splitting large ranges between threads.
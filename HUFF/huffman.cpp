@@ -19,420 +19,700 @@ void Huffman::displayHelp()
 	cout << "HUFF -d file1 file2 \t\t\t Decode file1 into file2 (both must be specified)" << endl;
 	cout << "HUFF -t file1 [file2] \t\t\t Create a tree file from file1 (if file2 not specified, outputs file1.htree)" << endl;
 	cout << "HUFF -et file1 file2 [file3] \t\t Encode file1 using tree in file2 (if file3 not specified, outputs file1.huf)" << endl;
+	cout << "HUFF -g file1 [file2] \t\t\t Generate a C++ header with an encoder and decoder for the tree in file1 (if file2 not specified, outputs file1.h)" << endl;
+	cout << endl << "Options (may be given anywhere after the command):" << endl;
+	cout << "--chunked \t\t\t\t Encode into independent blocks that are worked on by several threads (-e and -et)" << endl;
+	cout << "--block-size=N[K|M] \t\t\t The number of input bytes in each block (default 1M)" << endl;
+	cout << "--threads=N \t\t\t\t The number of threads to use (default: one per hardware thread)" << endl;
+	cout << "--interleaved \t\t\t\t Split each block into 4 streams that are decoded together, for faster decoding on one thread (implies --chunked)" << endl;
+	cout << "--adaptive \t\t\t\t Store each block with a new tree, the last block's tree, or as it is, whichever is smallest (implies --chunked)" << endl;
+	cout << "--checksum \t\t\t\t Keep a CRC-32C checksum of every block, so decoding stops with an error if the file is damaged (implies --chunked)" << endl;
+	cout << "--context \t\t\t\t Code each byte with one of up to 16 trees, chosen by the byte before it, in the blocks where that is smaller (-e, implies --chunked, codes of at most 11 bits)" << endl;
+	cout << "--max-length=N \t\t\t\t Limit codes to N bits (8 to 15), with a compact canonical header (-e and -t)" << endl;
+	cout << "--range=OFFSET:LENGTH \t\t\t Decode only LENGTH bytes from OFFSET of the decoded file (-d). A single stream file gets a range index (file.hidx) the first time" << endl;
+	cout << "--estimate \t\t\t\t Predict the size -e would write, and the ratio with a confidence, from a sample of the file, writing nothing (-e)" << endl;
+	cout << "--pipelined \t\t\t\t Read and write files on threads of their own while they are coded, so disk and processor work at the same time (-e, -d and -et)" << endl;
+	cout << "--stats \t\t\t\t Report the time of each phase, and the bytes, symbols and average code length, as JSON after the usual report" << endl;
+	cout << "--batch LIST|DIR \t\t\t Run -e, -d or -et (HUFF -et --batch LIST tree.htree) on every file named in LIST, or found under DIR, on a pool of threads. With -t (HUFF -t --batch LIST tree.htree), trains one tree from all of them" << endl;
+	cout << endl << "A file name of - reads standard input or writes standard output (e.g. HUFF -e - -). Standard input is always encoded in blocks." << endl;
 }
 
 void Huffman::MakeTreeBuilder(string inputFile, string outputFile) 
 {
-	/*	A public method that makes input streams, then calls the proper
+	/*	A public method that opens the input and output files, then calls the proper
 		private methods to output the tree builder information.
-		Cleans up the I/O streams as well.
+		Cleans up the files as well.
 	*/
-	ifstream file_input(inputFile, ios::binary | ios::in);		// Open file in binary mode
-	if (!file_input)
-	{
-		cout << "Input file " << inputFile << " not accessible. Ensure the path is correct. \n";		// If the file won't open, display the error to the user and quit.
-		exit(1);
-	}
-	ofstream file_output(outputFile, ios::binary | ios::out);
-	if (!file_output)
-	{
-		cout << "Output file " << outputFile << " not accessible. Ensure the path is correct, \n or that the file specified is available to be written to. \n";		// If the file won't open, display the error to the user and quit.
-		exit(1);
-	}
-
-	buildFrequencyTable(file_input);						// Build the frequency table
-	file_input.clear();										// Because we built the frequency table, we should seek it back to the beginning
-	file_input.seekg(0);
-	createTree();											// Make the tree for the frequencies found
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	InputFile file_input;
+	OutputFile file_output;
+	openInput(file_input, inputFile);
+	openOutput(file_output, outputFile);
+	CountingSink counted_output(file_output);
+
+	buildFrequencyTable(file_tree, file_input);				// Build the frequency table
+	createTree(file_tree);									// Make the tree for the frequencies found
+	outputTreeBuilder(file_tree, statsOutput(counted_output, file_output));	// Output the tree built
+	countOperation(file_input, counted_output);
 	file_input.close();										// Close the file to prevent errrors.
-	outputTreeBuilder(file_output);							// Output the tree built
-	file_output.close();									// Close the file to prevent errrors.
+	closeOutput(file_output, outputFile);
 }
 void Huffman::EncodeFile(string inputFile, string outputFile)
 {
-	/*	A public method that makes input streams, then calls the proper
+	/*	A public method that opens the input and output files, then calls the proper
 		private methods to encode the input file to the output.
-		Cleans up the I/O streams as well.
+		Cleans up the files as well.
 	*/
-	ifstream file_input(inputFile, ios::binary | ios::in);		// Open file in binary mode
-	if (!file_input)
-	{
-		cout << "Input file " << inputFile << " not accessible. Ensure the path is correct. \n";		// If the file won't open, display the error to the user and quit.
-		exit(1);
-	}
-	ofstream file_output(outputFile, ios::binary | ios::out);
-	if (!file_output)
-	{
-		cout << "Output file " << outputFile << " not accessible. Ensure the path is correct, \n or that the file specified is available to be written to. \n";		// If the file won't open, display the error to the user and quit.
-		exit(1);
-	}
-	buildFrequencyTable(file_input);						// Build the frequency table
-	file_input.clear();										// Because we built the frequency table, we should seek it back to the beginning.
-	file_input.seekg(0);
-	createTree();											// Make the tree for the frequencies found
-	outputTreeBuilder(file_output);							// Place the tree in the first 510 bytes.
-	EncodeFile_(file_input, file_output);					// Encode the rest of the file
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	InputFile file_input;
+	OutputFile file_output;
+	openInput(file_input, inputFile);
+	openOutput(file_output, outputFile);
+	unique_ptr<PipelineWriter> pipeline;
+	ByteSink &output = pipelineOutput(pipeline, file_output);
+	CountingSink counted_output(output);
+	encode_(file_input, statsOutput(counted_output, output));
+	if (pipeline) pipeline->finish();
+	countOperation(file_input, counted_output);
 	file_input.close();										// Close the file to prevent errrors.
-	file_output.close();									// Close the file to prevent errrors.
+	closeOutput(file_output, outputFile);
 }
 void Huffman::DecodeFile(string inputFile, string outputFile)
 {
-	/*	A public method that makes input streams, then calls the proper
+	/*	A public method that opens the input and output files, then calls the proper
 		private methods to decode the encoded input to the output specified.
-		Cleans up the I/O streams as well.
+		Cleans up the files as well.
 	*/
-	ifstream file_input(inputFile, ios::binary | ios::in);		// Open file in binary mode
-	if (!file_input)
-	{
-		cout << "Input file " << inputFile << " not accessible. Ensure the path is correct. \n";		// If the file won't open, display the error to the user and quit.
-		exit(1);
-	}
-	ofstream file_output(outputFile, ios::binary | ios::out);
-	if (!file_output)
-	{
-		cout << "Output file " << outputFile << " not accessible. Ensure the path is correct, \n or that the file specified is available to be written to. \n";		// If the file won't open, display the error to the user and quit.
-		exit(1);
-	}
-	rebuildTree(file_input);								// Rebuild the tree in the file
-	file_input.clear();										// Because we read the tree, we should reset it.
-	file_input.seekg(0);
-	DecodeFile_(file_input, file_output);					// Decode the file into the output
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	InputFile file_input;
+	OutputFile file_output;
+	openInput(file_input, inputFile);
+	openOutput(file_output, outputFile);
+	unique_ptr<PipelineWriter> pipeline;
+	ByteSink &output = pipelineOutput(pipeline, file_output);
+	CountingSink counted_output(output);
+	decode_(file_input, statsOutput(counted_output, output));
+	if (pipeline) pipeline->finish();
+	countOperation(file_input, counted_output);
 	file_input.close();										// Close the file to prevent errrors.
-	file_output.close();									// Close the file to prevent errrors.
+	closeOutput(file_output, outputFile);
+}
+void Huffman::DecodeFileRange(string inputFile, string outputFile, uint64_t offset, uint64_t length)
+{
+	/*	A public method that opens the input and output files, then decodes only the bytes from offset
+		to offset + length of the decoded file into the output. A single stream file gets a range index
+		next to it (inputFile + RANGE_INDEX_EXTENSION) the first time, so later ranges start decoding
+		close to where they begin. Throws a HuffmanError for input that can't seek, such as a pipe.
+	*/
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	InputFile file_input;
+	OutputFile file_output;
+	openInput(file_input, inputFile);
+	openOutput(file_output, outputFile);
+	CountingSink counted_output(file_output);
+	uint64_t bytes_read = decodeRange_(file_input, inputFile, statsOutput(counted_output, file_output), offset, length);
+	if (stats_counters) stats_counters->addOperation(bytes_read, counted_output.bytesWritten());
+	file_input.close();
+	closeOutput(file_output, outputFile);
 }
 void Huffman::EncodeFileWithTree(string inputFile, string TreeFile, string outputFile)
 {
-	/*	A public method that makes input streams, then calls the proper
+	/*	A public method that opens the input and output files, then calls the proper
 		private methods to encode the tree using the provided tree file
 		and input file.
-		Cleans up the I/O streams as well.
+		Cleans up the files as well.
 	*/
-	ifstream file_input(inputFile, ios::binary | ios::in);		// Open file in binary mode
-	if (!file_input)
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	InputFile file_input;
+	OutputFile file_output;
+	openInput(file_input, inputFile);
+	HuffmanCode code = readTreeFile(TreeFile);				// Read the tree (or its cached tables)
+	openOutput(file_output, outputFile);
+	unique_ptr<PipelineWriter> pipeline;
+	ByteSink &output = pipelineOutput(pipeline, file_output);
+	CountingSink counted_output(output);
+	encodeWithTree_(file_input, code, statsOutput(counted_output, output));
+	if (pipeline) pipeline->finish();
+	countOperation(file_input, counted_output);
+	file_input.close();										// Close the file to prevent errors.
+	closeOutput(file_output, outputFile);
+}
+
+void Huffman::EncodeFileWithTree(string inputFile, const HuffmanCode &code, string outputFile)
+{
+	/*	The same as EncodeFileWithTree, with a tree that was loaded once (with readTreeFile)
+		instead of being read from its file again for every file it encodes.
+	*/
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	InputFile file_input;
+	OutputFile file_output;
+	openInput(file_input, inputFile);
+	openOutput(file_output, outputFile);
+	unique_ptr<PipelineWriter> pipeline;
+	ByteSink &output = pipelineOutput(pipeline, file_output);
+	CountingSink counted_output(output);
+	encodeWithTree_(file_input, code, statsOutput(counted_output, output));
+	if (pipeline) pipeline->finish();
+	countOperation(file_input, counted_output);
+	file_input.close();										// Close the file to prevent errors.
+	closeOutput(file_output, outputFile);
+}
+
+HuffmanCode Huffman::readTreeFile(string TreeFile)
+{
+	/*	Reads the header of a tree file and loads it as a HuffmanCode. If the tables cached next to
+		the tree file were made for the same header, they are loaded as they are. Otherwise the tables
+		are built from the header, and cached for next time. A tree file's code is usually used for many
+		files, so its pair table (if it would be used) is made here, once, rather than for each file.
+		Throws a HuffmanError if the file can't be read, or isn't a valid tree.
+	*/
+	InputFile tree_input;
+	openInput(tree_input, TreeFile);
+	vector<unsigned char> tree_header;
+	readTreeHeader(tree_input, tree_header);
+	tree_input.close();
+
+	vector<unsigned char> tables;
+	InputFile tables_input;
+	if (tables_input.open(TreeFile + TABLE_CACHE_EXTENSION) && tables_input.isSeekable())
 	{
-		cout << "Input file " << inputFile << " not accessible. Ensure the path is correct. \n";		// If the file won't open, display the error to the user and quit.
-		exit(1);
+		tables.resize(size_t(tables_input.size()));
+		tables.resize(tables_input.read(tables.data(), tables.size()));
 	}
-	ifstream tree_input(TreeFile, ios::binary | ios::in);		// Open file in binary mode
-	if (!tree_input)
+	tables_input.close();
+
+	PhaseTimer timer(stats_counters.get(), PHASE_CODE_TABLES);
+	HuffmanCode code(byte_span{ tree_header.data(), tree_header.size() }, byte_span{ tables.data(), tables.size() });
+	if (!code.loadedTables()) writeTableCache(*code.tree, TreeFile);
+	if (code.tree->pairTableHelps()) code.tree->buildPairTable();
+	return code;
+}
+
+void Huffman::MakeTreeBuilder(const vector<string> &inputFiles, string outputFile)
+{
+	/*	Trains a single tree for a set of sample files, from the total of their byte counts, so files
+		like them can share it (with -et). The files are counted on thread_count threads, each adding
+		into its own table. The tree's tables are cached next to the tree file, ready for readTreeFile.
+		Throws a HuffmanError if a sample file can't be opened.
+	*/
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	vector<uint64_t> worker_counts(size_t(thread_count) * 256, 0);
+	vector<uint64_t> worker_bytes(thread_count, 0);
+	vector<char> opened(inputFiles.size(), 0);
+	parallelForWorkers(inputFiles.size(), thread_count, [&](unsigned int worker, size_t i)
 	{
-		cout << "Input file " << TreeFile << " not accessible. Ensure the path is correct. \n";		// If the file won't open, display the error to the user and quit.
-		exit(1);
-	}
-	ofstream file_output(outputFile, ios::binary | ios::out);
-	if (!file_output)
+		PhaseTimer timer(stats_counters.get(), PHASE_FREQUENCY);
+		InputFile file_input;
+		if (!file_input.open(inputFiles[i])) return;
+		opened[i] = 1;
+		byte_span block;
+		while (file_input.nextBlock(block)) countBytes(block.data, block.size, &worker_counts[size_t(worker) * 256]);
+		worker_bytes[worker] += file_input.size();
+	});
+	for (size_t i = 0; i < inputFiles.size(); i++)
 	{
-		cout << "Output file " << outputFile << " not accessible. Ensure the path is correct, \n or that the file specified is available to be written to. \n";		// If the file won't open, display the error to the user and quit.
-		exit(1);
+		if (!opened[i]) throw HuffmanError("Input file " + inputFiles[i] + " not accessible. Ensure the path is correct.");
 	}
-	rebuildTree(tree_input);								// Rebuild the tree
-	tree_input.close();										// Close the file to prevent errors.
-	outputTreeBuilder(file_output);							// Output the tree builder info
-	file_output.clear();									// Reset the output
-	file_output.seekp(0);
-	EncodeFile_(file_input, file_output);					// Encode the file
-	file_input.close();										// Close the file to prevent errors.
-	file_output.close();									// Close the file to prevent errors.
+
+	uint64_t counts[256] = { 0 };
+	for (size_t i = 0; i < worker_counts.size(); i++) counts[i % 256] += worker_counts[i];
+	file_tree.setWeights(counts);
+	createTree(file_tree);
+
+	OutputFile file_output;
+	openOutput(file_output, outputFile);
+	outputTreeBuilder(file_tree, file_output);
+	closeOutput(file_output, outputFile);
+
+	vector<unsigned char> tree_header(file_tree.headerSize());
+	file_tree.writeHeader(tree_header.data());
+	PhaseTimer timer(stats_counters.get(), PHASE_CODE_TABLES);
+	HuffmanCode code(byte_span{ tree_header.data(), tree_header.size() });	// Cache the tree as readTreeFile loads it, not as it was counted.
+	writeTableCache(*code.tree, outputFile);
+	uint64_t bytes_in = 0;
+	for (uint64_t bytes : worker_bytes) bytes_in += bytes;
+	if (stats_counters) stats_counters->addOperation(bytes_in, tree_header.size());
 }
 
-Huffman::Huffman() 
+void Huffman::writeTableCache(const HuffmanTree &tree, const string &tree_path)
 {
-	/*	The constructor for the Huffman tree. Initializes the frequency table 
-		to 0 weight nodes of all possible 8-bit values.
+	/*	Writes the tree's tables to the cache file next to its tree file. The cache only saves
+		time, so if it can't be written (such as in a read-only directory) nothing is lost.
 	*/
+	vector<unsigned char> tables;
+	tree.writeTables(tables);
+	OutputFile tables_output;
+	if (!tables_output.open(tree_path + TABLE_CACHE_EXTENSION)) return;
+	tables_output.write(tables.data(), tables.size());
+	tables_output.close();
+}
 
-	// Initialize (clear) the frequency table before beginning.
-	for (int i = 0; i < 256; i++)
-	{
-		node* initial_node = new node();
-		initial_node->byte_value = i;		// Each node will have the 8-bit value corresponding to index, and the value of the 'character' found.
-		frequency_table[i] = initial_node;
-	}
+void Huffman::compress(byte_span input, vector<unsigned char> &output)
+{
+	/*	Encodes a range of memory, adding the encoded result to the end of output.
+		The result is exactly what EncodeFile would write for the same bytes and options.
+	*/
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	size_t output_start = output.size();
+	InputFile memory_input;
+	memory_input.openMemory(input);
+	VectorSink sink(output);
+	encode_(memory_input, sink);
+	if (stats_counters) stats_counters->addOperation(input.size, output.size() - output_start);
 }
 
+void Huffman::compress(byte_span input, const HuffmanCode &code, vector<unsigned char> &output)
+{
+	/*	Encodes a range of memory with a prebuilt tree, adding the result (the tree's
+		header, then the encoded bits) to the end of output, as EncodeFileWithTree would.
+	*/
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	size_t output_start = output.size();
+	InputFile memory_input;
+	memory_input.openMemory(input);
+	VectorSink sink(output);
+	encodeWithTree_(memory_input, code, sink);
+	if (stats_counters) stats_counters->addOperation(input.size, output.size() - output_start);
+}
 
-void Huffman::buildFrequencyTable(ifstream &file_input)
+void Huffman::decompress(byte_span input, vector<unsigned char> &output)
 {
-	/*	Iterates through the entire file, constructing nodes for each possible byte value,
-		incrementing the weight of each one as it is encountered. These are stored in a
-		class array to be accessed later for building the tree itself.
+	/*	Decodes a range of memory holding anything EncodeFile or compress could have made,
+		adding the decoded bytes to the end of output.
 	*/
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	size_t output_start = output.size();
+	InputFile memory_input;
+	memory_input.openMemory(input);
+	VectorSink sink(output);
+	decode_(memory_input, sink);
+	if (stats_counters) stats_counters->addOperation(input.size, output.size() - output_start);
+}
+
+void Huffman::decompressRange(byte_span input, uint64_t offset, uint64_t length, vector<unsigned char> &output)
+{
+	/*	Decodes the bytes from offset to offset + length of what a range of memory decodes to, adding
+		them to the end of output. There is nowhere to keep a range index for memory, so a single stream
+		is decoded once to find its checkpoints; a block container only decodes the blocks of the range.
+	*/
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	size_t output_start = output.size();
+	InputFile memory_input;
+	memory_input.openMemory(input);
+	VectorSink sink(output);
+	uint64_t bytes_read = decodeRange_(memory_input, "", sink, offset, length);
+	if (stats_counters) stats_counters->addOperation(bytes_read, output.size() - output_start);
+}
 
-	char current_char;								// Make a byte value.
-	file_input.read(&current_char, 1);				// PRIMING READ. Read in a single byte from the file. This expects a char, so we then convert
-	while (file_input)								// Read while there is content left
+HuffmanCode Huffman::buildTree(byte_span input)
+{
+	/*	Builds a tree from the byte counts of a range of memory (limiting the code
+		lengths if the options ask for it), ready to be shared by many encoders.
+	*/
+	PhaseTimer operation(stats_counters.get(), PHASE_OTHER);
+	uint64_t counts[256] = { 0 };
 	{
-		unsigned char current_byte = unsigned char(current_char); // Convert to unsigned char
-		frequency_table[current_byte]->weight++;	// Increase the weight of that byte.
-		file_input.read(&current_char, 1);			// Read in a single byte from the file for the next iteration. 
+		PhaseTimer timer(stats_counters.get(), PHASE_FREQUENCY);
+		buildHistogram(input.data, input.size, counts, thread_count);
 	}
+	file_tree.setWeights(counts);
+	createTree(file_tree);
+
+	vector<unsigned char> tree_header(file_tree.headerSize());
+	file_tree.writeHeader(tree_header.data());
+	if (stats_counters) stats_counters->addOperation(input.size, tree_header.size());
+	PhaseTimer timer(stats_counters.get(), PHASE_CODE_TABLES);
+	return HuffmanCode(byte_span{ tree_header.data(), tree_header.size() });
 }
 
-void Huffman::createTree()
+void Huffman::openInput(InputFile &file_input, const string &path)
 {
-	/*	This method takes the frequency values constructed, and builds a tree out of them.
-		Minimum nodes are found based on weight, and their positions recorded.
-		These nodes are 'merged' by linking them to a parent that records the sum of their weights.
-		This algorithm runs until all of the nodes are in a single root node. 
+	/*	Opens (or maps) an input file, throwing a HuffmanError if it can't be.
 	*/
-
-	// We know we will need just enough iterations to merge all the nodes together in the tree. (255 merges of 2 nodes = 510 bytes)
-	for(int k=0; k <255; k++)
+	if (!file_input.open(path))
 	{
-		// Set up variables to find the lowest weights and record their position.
-		unsigned char rowNode1, rowNode2;
-		rowNode1 = rowNode2 = 0;
-		unsigned int minVal1, minVal2;
-		minVal1 = minVal2 = UINT_MAX;
-
-		// Iterate through and find the lowest node.
-		for (int i = 0; i < 256; i++)
-		{
-			node* current = frequency_table[i];		// Record the current node for code clarity
-			if (current == NULL) continue;			// Skip NULL nodes to avoid access errors.
-			if (current->weight < minVal1)			
-			{
-				minVal1 = current->weight;			// Record the current weight if it's the new minimum
-				rowNode1 = i;						// Also record that subscript.
-			}
-		}
-		// Second minimum value loop.
-		for (int i = 0; i < 256; i++)
-		{
-			node* current = frequency_table[i];				// Record the current node for code clarity
-			node* minimumNode1 = frequency_table[rowNode1];	// Keep track of the previous minimum node so we don't hit it.
-			if (current == NULL || current == minimumNode1 ) continue;			// Skip NULL nodes, and the first minimum
-			if (current->weight < minVal2)
-			{
-				minVal2 = current->weight;					// Record the current weight if it's the new minimum
-				rowNode2 = i;								// Also record that subscript.
-			}
-		}
+		throw HuffmanError("Input file " + path + " not accessible. Ensure the path is correct.");
+	}
+}
 
-		// Find the smaller and larger subscript to properly give the correct children based on subscript.
-		// This makes it easier to figure out which node came "first" in the tree
-		unsigned char minRow, maxRow;				
-		if (rowNode1 < rowNode2) { minRow = rowNode1; maxRow = rowNode2; }
-		else {minRow = rowNode2; maxRow = rowNode1;}
-		
-		node* minimumNode1 = frequency_table[minRow];	// We can now assign the two nodes properly		
-		node* minimumNode2 = frequency_table[maxRow];
-		
-		node* newParent = new node();					// Make the parent, giving the smaller subscript node to the left child.
-		newParent->LCH = minimumNode1;
-		newParent->RCH = minimumNode2;
-		minimumNode1->parent = newParent;
-		minimumNode2->parent = newParent;
-
-		newParent->weight = minimumNode1->weight + minimumNode2->weight;		// Add the weights of the children
-		
-		frequency_table[minRow] = newParent;	// Reassign the frequency table nodes.
-		frequency_table[maxRow] = NULL;			// The larger subscript points to nothing now.
-
-		
-		tree_sequence[k*2] = minRow;			// Record the two nodes that were squashed in the tree_sequence.
-		tree_sequence[k*2+1] = maxRow;			// Because the loop is 0 <= k < 255, we need to multiply by 2 to access the 'pair' index
+void Huffman::openOutput(OutputFile &file_output, const string &path)
+{
+	/*	Opens an output file, throwing a HuffmanError if it can't be.
+	*/
+	if (!file_output.open(path))
+	{
+		throw HuffmanError("Output file " + path + " not accessible. Ensure the path is correct, or that the file specified is available to be written to.");
 	}
-	root_node = frequency_table[0]; // Assign the root node for easy access.
-	frequency_table[0] = NULL;
 }
 
-void Huffman::rebuildTree(ifstream &file_input)
+void Huffman::closeOutput(OutputFile &file_output, const string &path)
 {
-	/*	A private method to rebuild the tree from a given encoded tree in a file.
-		This method reads the first 510 bytes of the file to  construct the tree and
-		store it in the root_node of the Huffman object.
-		The method checks if there are not enough bytes for the tree, or if it creates
-		an invalid tree object. 
+	/*	Closes an output file, throwing a HuffmanError if any write to it failed (such as on a full disk),
+		so a file that was cut short is never taken for a finished one.
 	*/
+	file_output.close();
+	if (file_output.failed())
+	{
+		throw HuffmanError("Could not write output file " + path + ". The disk may be full, or the file may no longer be writable.");
+	}
+}
 
-	unsigned char firstNode, secondNode;
-	firstNode = secondNode = NULL;
-	
-	for (int i = 0; i < 510; i++)								// Read the first 510 bytes of the file.
+void Huffman::encode_(InputFile &file_input, ByteSink &file_output)
+{
+	/*	Encodes the whole input, building a tree for it first. In the chunked mode, the blocks of
+		the input are encoded separately instead. An input that can only be read once (standard
+		input or a pipe) is always encoded in blocks, since a single tree would need the whole
+		input counted before any of it is encoded.
+	*/
+	if (options.chunked || options.interleaved || options.adaptive || options.checksum || options.context || !file_input.isSeekable())
 	{
-		if (!file_input)		// Check the case that we run out of bits to read before the loop is over.
-		{
-			cerr << "Tree encoding could not be read. The file is less than the required Huffman tree length.\n";
-			exit(1);			// Tell the user there is an error and exit.
-		}
-		char current_char;							// Make a byte value.
-		file_input.read(&current_char, 1);			// Read in a single byte from the file. This expects a char, so we then convert
-		tree_sequence[i] = unsigned char(current_char);
+		EncodeContainer_(file_input, file_output, NULL);	// Each block builds its own tree.
+		return;
 	}
-	for (int i = 0; i < 255; i++)
+	buildFrequencyTable(file_tree, file_input);				// Build the frequency table
+	file_input.seek(0);										// Because we built the frequency table, we should seek it back to the beginning.
+	createTree(file_tree);									// Make the tree for the frequencies found
 	{
-		firstNode = tree_sequence[i*2];
-		secondNode = tree_sequence[i*2+1];
-		node* minimumNode1 = frequency_table[firstNode];		// Assign the nodes as given
-		node* minimumNode2 = frequency_table[secondNode];
-
-		if (minimumNode1 == NULL || minimumNode2 == NULL)		// If either node is NULL, it's possible the tree file provided was invalid
-		{
-			cerr << "Could not build Huffman tree from the provided file. Make sure it is in the correct format. \n";
-			exit(1);
-		}
-
-		node* newParent = new node();							// Make the parent, assigning the first node to the left.
-		newParent->LCH = minimumNode1;
-		newParent->RCH = minimumNode2;
-		minimumNode1->parent = newParent;
-		minimumNode2->parent = newParent;
+		PhaseTimer timer(stats_counters.get(), PHASE_CODE_TABLES);
+		file_tree.createCodeTable();						// Make the code for each byte from the tree
+		if (file_input.size() >= HuffmanTree::PAIR_TABLE_MINIMUM_INPUT && file_tree.pairTableHelps()) file_tree.buildPairTable();
+	}
+	outputTreeBuilder(file_tree, file_output);				// Place the tree at the start of the file.
+	EncodeFile_(file_tree, file_input, file_output);		// Encode the rest of the file
+}
 
-		frequency_table[firstNode] = newParent;					// Put the merged nodes into the lower subsript.
-		frequency_table[secondNode] = NULL;						// Clear the larger subscript pointer.
+void Huffman::encodeWithTree_(InputFile &file_input, const HuffmanCode &code, ByteSink &file_output)
+{
+	/*	Encodes the whole input with a prebuilt tree (whose tables are already made), either as a
+		single stream after the tree's header, or in blocks that each carry the header.
+	*/
+	if (options.chunked || options.interleaved || options.adaptive || options.checksum || options.context)
+	{
+		vector<unsigned char> tree_header = code.header();
+		EncodeContainer_(file_input, file_output, &tree_header);	// Every block uses the same tree.
+		return;
 	}
-	root_node = frequency_table[0];
+	outputTreeBuilder(*code.tree, file_output);				// Output the tree builder info
+	EncodeFile_(*code.tree, file_input, file_output);		// Encode the file after it
 }
 
-void Huffman::outputTreeBuilder(ofstream &output_stream)
+void Huffman::decode_(InputFile &file_input, ByteSink &file_output)
 {
-	/*	This method takes the tree being stored in the Huffman object,
-		and writes it out to a file in 510 bytes. The method checks
-		if the file is available for writing to.
+	/*	Decodes the whole input. Files in the block container format are recognized by their header.
 	*/
-	for (unsigned char i : tree_sequence)
+	if (isContainer(file_input))
 	{
-		output_stream << i;
+		DecodeContainer_(file_input, file_output);			// Decode each of the blocks
+		return;
 	}
-	return;
+	vector<unsigned char> tree_header;
+	rebuildTree(file_tree, file_input, tree_header);		// Rebuild the tree at the start of the file
+	DecodeFile_(file_tree, file_input, file_output);		// Decode the rest of the file (after the tree) into the output
+}
+
+Huffman::Huffman() 
+{
+	/*	The constructor for the Huffman encoder. The trees are reset for each file (or block),
+		so all that's set up here are the default options.
+	*/
+	thread_count = defaultThreadCount();	// Use every hardware thread unless told otherwise.
 }
 
-void Huffman::EncodeFile_(ifstream &file_input, ofstream &file_output)
+void Huffman::setOptions(const HuffmanOptions &new_options)
 {
-	/*	A method to take an input file, read in each byte, and output
-		the encoded result based on the Huffman tree.
+	/*	Changes the settings used when encoding. The block size is kept within the limits
+		of the container format, and a thread count of 0 means one per hardware thread.
 	*/
-	createEncodingStrings();
-	file_output.seekp(510);		// Because the tree is always included in the file, we need to seek the output file and skip those 510 bytes.
+	options = new_options;
+	if (options.block_size < MINIMUM_BLOCK_SIZE) options.block_size = MINIMUM_BLOCK_SIZE;
+	if (options.block_size > MAXIMUM_BLOCK_SIZE) options.block_size = MAXIMUM_BLOCK_SIZE;
+	if (options.max_code_length != 0 && options.max_code_length < HuffmanTree::MINIMUM_LIMITED_LENGTH) options.max_code_length = HuffmanTree::MINIMUM_LIMITED_LENGTH;
+	if (options.max_code_length > HuffmanTree::MAXIMUM_LIMITED_LENGTH) options.max_code_length = HuffmanTree::MAXIMUM_LIMITED_LENGTH;
+	thread_count = options.threads > 0 ? options.threads : defaultThreadCount();
+	if (options.stats && STATS_AVAILABLE && !stats_counters) stats_counters.reset(new StatsCounters());
+	if (!options.stats) stats_counters.reset();
+}
+
+HuffmanStats Huffman::stats() const
+{
+	/*	The counts so far. With the stats option off (or compiled out) they are all 0.
+	*/
+	return stats_counters ? stats_counters->snapshot() : HuffmanStats();
+}
+
+void Huffman::resetStats()
+{
+	/*	Starts counting again, such as before each of a set of measured files.
+	*/
+	if (stats_counters) stats_counters->reset();
+}
+
+ByteSink &Huffman::statsOutput(CountingSink &counted_output, ByteSink &output)
+{
+	/*	Only counts the output when the counts are wanted, so nothing is added to each write otherwise.
+	*/
+	if (stats_counters) return counted_output;
+	return output;
+}
 
-	char current_char;											// Read a byte from the file to begin 
-	file_input.read(&current_char, 1);							// Priming read to get the first character. .read() expects a char so we need to convert.
-	unsigned char currentByte = unsigned char(current_char);	// Convert to unsigned character
-	string outputBuffer = "";									// Initialize a string output buffer to hold the encodings until there is enough bits to write.
+ByteSink &Huffman::pipelineOutput(unique_ptr<PipelineWriter> &pipeline, ByteSink &output)
+{
+	/*	Starts a writer thread in front of the output when the output is to be pipelined. The caller
+		finishes it before counting or closing the output.
+	*/
+	if (!options.pipelined) return output;
+	pipeline.reset(new PipelineWriter(output));
+	return *pipeline;
+}
 
-	while(file_input)
+void Huffman::countOperation(const InputFile &input_file, const CountingSink &counted_output)
+{
+	/*	Counts a file as worked on. A seekable file counts all of its bytes (a mapped file may be
+		read without moving its position), and one read as a stream counts what was read.
+	*/
+	if (!stats_counters) return;
+	stats_counters->addOperation(input_file.isSeekable() ? input_file.size() : input_file.position(), counted_output.bytesWritten());
+}
+
+void Huffman::createTree(HuffmanTree &tree)
+{
+	/*	Makes the tree from the weights already set, limiting the code lengths
+		(with a canonical tree) if the options ask for it.
+	*/
+	PhaseTimer timer(stats_counters.get(), PHASE_TREE);
+	if (options.max_code_length != 0) tree.createLimitedTree(options.max_code_length);
+	else tree.createTree();
+}
+
+void Huffman::buildFrequencyTable(HuffmanTree &tree, InputFile &file_input)
+{
+	/*	Iterates through the entire file, counting each possible byte value
+		as it is encountered. The counts become the weights of the tree's nodes,
+		to be used later for building the tree itself.
+	*/
+
+	PhaseTimer timer(stats_counters.get(), PHASE_FREQUENCY);
+	uint64_t counts[256] = { 0 };					// Count into a flat table, rather than through the node pointers. Large blocks are split between threads.
+	byte_span block;
+	if (options.pipelined)							// Count each block while the next is read.
 	{
-		string currentEncoding = bit_encodings[currentByte];	// Lookup the bit encoding for the currentByte
-		outputBuffer += currentEncoding;						// Add it to the output	buffer
-		while (outputBuffer.size() >= 8)						// If we have enough in the output buffer, we can begin writing it.
-		{
-			string outputBitString = outputBuffer.substr(0,8);	// Store the string of output that will be converted to a byte. (Characters 0-7, length of 8)
-			outputBuffer.erase(0, 8);							// Remove characters 0-7 of the output buffer.
-			unsigned char outputByte = stringToByte(outputBitString);	// Convert this string to a byte.
-			file_output << outputByte;							// Write the byte.
-		}
-		
-		file_input.read(&current_char, 1);						// Finally, read the last character.
-		currentByte = unsigned char(current_char);				// Convert it to unsigned.
+		PipelineReader pipeline(file_input);
+		while (pipeline.nextBlock(block)) buildHistogram(block.data, block.size, counts, thread_count);
 	}
-	if (outputBuffer.size() > 0)								// If we still have some bytes left in the output buffer, we'll need some padding bits!
+	else
 	{
-		string padding_bits = "";								// Start with an empty padding
-		for (int i = 0; i < 256; i++)							// Search the encoding strings array
+		while (file_input.nextBlock(block))			// Read while there is content left
 		{
-			int bits_required = 8 - outputBuffer.size();		// Change the value to the amount remaining
-			if (bit_encodings[i].size() > bits_required)	// We can use a padding bit that will cause us to not hit any leaf nodes by choosing one longer than the output buffer size.
-			{
-				padding_bits = bit_encodings[i].substr(0, bits_required);		// Get the string of the amount for the padding.
-				break;				// Exit the loop on the first one we find.
-			}
+			buildHistogram(block.data, block.size, counts, thread_count);
 		}
-		outputBuffer += padding_bits;		// Concatenate the padding bits to the string.
-		unsigned char outputByte = stringToByte(outputBuffer);	// Now, we can just convert the byte and output it.
-		file_output << outputByte;
 	}
+	tree.setWeights(counts);						// Set the weight of each byte.
 }
 
-unsigned char Huffman::stringToByte(string bit_string)
+void Huffman::readTreeHeader(InputFile &file_input, vector<unsigned char> &tree_header)
 {
-	/*	A method to convert a given bit encoding string of length 8 into
-		a byte where each bit is represented by the character at that position.
+	/*	Reads the tree header at the current position of the file (the 510 byte tree_sequence,
+		or the code lengths of a canonical tree) into tree_header, without building anything.
+		Throws a HuffmanError if the file ends first.
 	*/
-	unsigned char outputByte = 0;
-	for (int i = 0; i < 8; i++)
+	unsigned char magic[4];
+	size_t magic_size = file_input.peek(magic, 4);				// The first bytes tell which kind of header it is.
+	tree_header.resize(HuffmanTree::headerSizeFor(magic, magic_size));
+	if (file_input.read(tree_header.data(), tree_header.size()) < tree_header.size())		// Read the header. Check the case that we run out of bytes before the tree is read.
 	{
-		if (bit_string.at(i) == '1')	// When the current bit should be 1
+		throw HuffmanError("Tree encoding could not be read. The file is less than the required Huffman tree length.");
+	}
+}
+
+void Huffman::rebuildTree(HuffmanTree &tree, InputFile &file_input, vector<unsigned char> &tree_header)
+{
+	/*	A private method to rebuild the tree from a given encoded tree in a file.
+		This method reads the tree header at the start of the file (the 510 byte tree_sequence,
+		or the code lengths of a canonical tree) to construct the tree, keeping the header in tree_header.
+		The method checks if there are not enough bytes for the tree, or if it creates
+		an invalid tree object. 
+	*/
+	readTreeHeader(file_input, tree_header);
+	PhaseTimer timer(stats_counters.get(), PHASE_TREE);
+	if (!tree.readHeader(tree_header.data(), tree_header.size()))		// If the header names a missing node, it's possible the tree file provided was invalid
+	{
+		throw HuffmanError("Could not build Huffman tree from the provided file. Make sure it is in the correct format.");
+	}
+}
+
+void Huffman::outputTreeBuilder(const HuffmanTree &tree, ByteSink &output_file)
+{
+	/*	This method takes the tree, and writes it out to a file (in 510 bytes,
+		or 132 for a canonical tree).
+	*/
+	unsigned char header[510];
+	tree.writeHeader(header);
+	output_file.write(header, tree.headerSize());
+}
+
+void Huffman::EncodeFile_(const HuffmanTree &tree, InputFile &file_input, ByteSink &file_output)
+{
+	/*	A method to take an input file, read in each byte, and output
+		the encoded result based on the Huffman tree. The tree has already
+		been written, so the encoded bits follow it.
+		The input is given to encodeBytes a block at a time (all at once, if
+		the file is mapped), which packs each code into the output. With the
+		pipelined option, the blocks are read on another thread meanwhile.
+	*/
+	PhaseTimer timer(stats_counters.get(), PHASE_CODING);
+	uint64_t start_position = file_input.position();
+	uint64_t remaining = file_input.size() - start_position;
+	size_t writer_size = remaining < ENCODE_BLOCK_SIZE ? size_t(remaining) + 64 : ENCODE_BLOCK_SIZE;	// A small file doesn't need (or pay to clear) a whole block.
+	BitWriter writer(file_output, writer_size);					// The writer that packs the codes into whole bytes.
+	byte_span block;
+	if (options.pipelined)
+	{
+		PipelineReader pipeline(file_input);
+		while (pipeline.nextBlock(block)) tree.encodeBytes(block.data, block.size, writer);
+	}
+	else
+	{
+		while (file_input.nextBlock(block))
 		{
-			outputByte |= 0x01;			// Bitwise OR the output byte with 0000 0001 to add it to the end
+			tree.encodeBytes(block.data, block.size, writer);
 		}
-		if (i == 7) break;				// Break so we don't shift the byte more than we need to (7 shifts only, not 8).
-		outputByte = outputByte<< 1;	// Shift the byte over. We don't need to check for 0, as all bits are 0 to begin with. 
 	}
-	return outputByte;
+	if (stats_counters) stats_counters->addCoded(file_input.position() - start_position, writer.bitsWritten());
+	tree.padFinalByte(writer);									// If we still have some bits left in the last byte, we'll need some padding bits!
+	writer.finish();											// Write out the rest of the output.
 }
-void Huffman::DecodeFile_(ifstream &file_input, ofstream &file_output)
+
+void Huffman::DecodeFile_(HuffmanTree &tree, InputFile &file_input, ByteSink &file_output)
 {
 	/*	A method to decode the provided file into the output file. This serves as a private
 		function that does the behind the scenes work. The calling function to this
 		can decide whether the tree is included or not, allowing for files to be encoded from 
-		a tree in a separate file.
+		a tree in a separate file. Decoding starts from the current position of the input.
+		A mapped file is decoded in place, in one call to decodeBits, or split between the threads
+		by decodeSpeculative_ when it is at least two of its chunks long. Otherwise the encoded bits
+		are read in large blocks. Any bytes that were not fully decoded at the end of a block
+		(the last few codes) are carried to the front of the next block, along with the bit
+		position they begin at. With the pipelined option, the blocks are read on another thread
+		(mapped files too, so the disk is waited on there) while the block before is decoded.
 	*/
+	{
+		PhaseTimer timer(stats_counters.get(), PHASE_CODE_TABLES);
+		tree.buildDecodeTable();				// Build the lookup tables for the tree that was rebuilt.
+	}
+	PhaseTimer timer(stats_counters.get(), PHASE_CODING);
+	CountingSink counted_output(file_output);		// Counts the symbols decoded, for stats().
 
-	node* current_node = root_node;				// Set the current node being navigated as the root node.
-	char current_char;							// Read a byte from the file to begin 
-	file_input.seekg(510);						// Because the tree is included in the file, we need to seek the input file and skip those 510 bytes.
-	
-	file_input.read(&current_char, 1);							// Priming read to get the first character. .read() expects a char so we need to convert.
-	unsigned char currentByte = unsigned char(current_char);	// Convert to unsigned character
-	int iteration = 0;											// Keep track of which iteration to see if we need to read an additional byte
-	while (file_input)
+	if (file_input.isMapped() && !options.pipelined)
 	{
-		if (iteration == 8)						// If the bit string has gone through 8 iterations, it is now x00. We need a new byte.
+		byte_span encoded = file_input.contents();
+		size_t start = size_t(file_input.position());
+		if (thread_count > 1 && encoded.size - start >= 2 * SPECULATIVE_CHUNK_SIZE)
 		{
-			file_input.read(&current_char, 1);	// Read in the new byte, then convert it below.
-			currentByte = unsigned char(current_char);
-			iteration = 0;						// Restart this iterator
-
-			if (!file_input)					// FIXED BUG from first submission : Check that the file input is not at the end.
-			{
-				break;							// We need to break in the case that the EOF flag was set. This prevents extraneous bytes from being written at the end.
-			}
+			decodeSpeculative_(tree, encoded.data + start, encoded.size - start, statsOutput(counted_output, file_output));
 		}
+		else tree.decodeBits(encoded.data + start, encoded.size - start, 0, true, statsOutput(counted_output, file_output));
+		if (stats_counters) stats_counters->addCoded(counted_output.bytesWritten(), uint64_t(encoded.size - start) * 8);
+		return;
+	}
 
-		if ( (currentByte | 0x7F) == 0xFF) current_node = current_node->RCH;	// If the current first bit is true, we go right
-		else current_node = current_node->LCH;	// Else, we go left
-			
-		currentByte = currentByte << 1;			// Remove the bit we just read.
-
-		if (current_node == NULL) break;		// If the node is null, we fell OFF the tree. This is an ending value.
-
-		if (current_node->LCH == NULL && current_node->RCH == NULL)	// Once we have hit a leaf (no children), we can write the byte.
+	const size_t read_size = HuffmanTree::DECODE_BLOCK_SIZE;
+	vector<unsigned char> input_block(read_size + 2 * HuffmanTree::DECODE_SAFE_BYTES);	// The block of encoded input. There is room for the bytes carried over from the last block.
+	size_t carried_bytes = 0;					// Bytes carried over from the previous block.
+	size_t bit_offset = 0;						// The bit (within the first carried byte) that decoding should resume at.
+	uint64_t encoded_bytes = 0;
+	unique_ptr<PipelineReader> pipeline(options.pipelined ? new PipelineReader(file_input) : NULL);
+	while (true)
+	{
+		unsigned char* fill = input_block.data() + carried_bytes;		// Fill the block after any carried over bytes.
+		size_t bytes_read = pipeline ? pipeline->read(fill, read_size) : file_input.read(fill, read_size);
+		size_t block_size = carried_bytes + bytes_read;
+		bool final_block = bytes_read < read_size;	// A short read means we hit the end of the file.
+		encoded_bytes += bytes_read;
+
+		size_t stop_position = tree.decodeBits(input_block.data(), block_size, bit_offset, final_block, statsOutput(counted_output, file_output));
+		if (final_block)						// The last block decodes every remaining bit, so we are done.
 		{
-			file_output << current_node->byte_value;		// Write the bytes
-			current_node = root_node;						// Start over at the root
+			if (stats_counters) stats_counters->addCoded(counted_output.bytesWritten(), encoded_bytes * 8);
+			break;
 		}
-		iteration++;		// Increase the bit iteration for the current byte.
+
+		size_t first_carried = stop_position >> 3;		// Carry the undecoded bytes to the front of the block.
+		carried_bytes = block_size - first_carried;
+		memmove(input_block.data(), input_block.data() + first_carried, carried_bytes);
+		bit_offset = stop_position & 7;
 	}
 }
 
-void Huffman::createEncodingStrings()
+HuffmanCode::HuffmanCode(byte_span tree_header) : tree(new HuffmanTree())
 {
-	/*	Begins creating encoding strings for every node by starting 
-		at the root, with an empty encoding string.
+	/*	Rebuilds the tree from its header, then builds both the encoding and decoding
+		tables, so nothing about the tree changes after this.
 	*/
-	buildNodeString(root_node, "");
+	buildTables(tree_header);
 }
 
-void Huffman::buildNodeString(node* current_node, string current_encoding)
+HuffmanCode::HuffmanCode(byte_span tree_header, byte_span tables) : tree(new HuffmanTree())
 {
-	/*	This method visits all nodes (starting from the root provided) and 
-		creates a string based on the path taken to reach their root.
-		Recurses LEFT-wards through until a leaf is hit. When a leaf is hit, 
-		it will then start work on the RIGHT path. 
-		Each time a LEFT path is taken, the current encoding gains a 0, and
-		a 1 for the RIGHT path. After a leaf is hit, the path is stored in the
-		class array. 
+	/*	Loads the saved tables when they are valid and describe the same tree as the header
+		(so a cache left over from an older tree is never used), otherwise builds them.
 	*/
-
-	if (current_node->LCH == NULL && current_node->RCH == NULL)			// If we hit a leaf node, we save the encodings in the table
+	if (tables.size > 0 && tree->readTables(tables.data, tables.size) && header() == vector<unsigned char>(tree_header.data, tree_header.data + tree_header.size))
 	{
-		bit_encodings[unsigned int(current_node->byte_value)] = current_encoding;		// Save the encodings from the current node in the byte value the node holds
+		loaded_tables = true;
+		return;
 	}
-	else
-	{
-		buildNodeString(current_node->LCH, current_encoding + '0');		// First try the left path, adding a 0 to the encoding if we do.
+	tree->reset();
+	buildTables(tree_header);
+}
 
-		buildNodeString(current_node->RCH, current_encoding + '1');		// Once the left path returns, we try the right path, adding a 1 to the encoding if we do.
+void HuffmanCode::buildTables(byte_span tree_header)
+{
+	/*	Rebuilds the tree from its header and builds both tables.
+	*/
+	if (!tree->readHeader(tree_header.data, tree_header.size))
+	{
+		throw HuffmanError("Could not build Huffman tree from the provided header. Make sure it is in the correct format.");
 	}
-}
\ No newline at end of file
+	tree->createCodeTable();
+	tree->buildDecodeTable();
+}
+
+vector<unsigned char> HuffmanCode::tables() const
+{
+	/*	The tree and both of its tables, in the form readTables loads.
+	*/
+	vector<unsigned char> saved;
+	tree->writeTables(saved);
+	return saved;
+}
+
+vector<unsigned char> HuffmanCode::header() const
+{
+	/*	The header that describes the tree.
+	*/
+	vector<unsigned char> tree_header(tree->headerSize());
+	tree->writeHeader(tree_header.data());
+	return tree_header;
+}
+
+void HuffmanCode::encode(byte_span input, vector<unsigned char> &output) const
+{
+	/*	Packs the code of every input byte onto the end of output, padding the last byte
+		the same way a file is padded. Everything written to belongs to the caller, so this
+		can run on many threads at once.
+	*/
+	VectorSink sink(output);
+	BitWriter writer(sink, MESSAGE_BLOCK_SIZE);
+	tree->encodeBytes(input.data, input.size, writer);
+	tree->padFinalByte(writer);
+	writer.finish();
+}
+
+void HuffmanCode::decode(byte_span encoded, vector<unsigned char> &output) const
+{
+	/*	Decodes bits made by encode onto the end of output. The padding at the end is
+		dropped, as it is for a file. This can also run on many threads at once.
+	*/
+	VectorSink sink(output);
+	tree->decodeBits(encoded.data, encoded.size, 0, true, sink);
+}
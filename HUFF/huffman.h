@@ -2,54 +2,185 @@
 //	Author:			Kyle Uerkwitz
 //	Date:			October 18, 2019
 //	Class:			EECS 2510-001
-//	Description:	The header file for huffman.cpp. Contains the public facing interface methods private implementations for them. 
+//	Description:	The header file for huffman.cpp. Contains the public facing interface methods private implementations for them.
 //					Also pulls in the necessary modules from the std library.
 
 #pragma once
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <stdexcept>
+#include "fileio.h"
+#include "bitio.h"
+#include "histogram.h"
+#include "parallel.h"
+#include "huffman_tree.h"
+#include "context_model.h"
+#include "container.h"
+#include "stats.h"
+#include "pipeline.h"
+#include "range_index.h"
 using namespace std;
 
+static const char TABLE_CACHE_EXTENSION[] = ".tables";	// Added to a tree file's name for the file its tables are cached in.
+static const double ESTIMATE_TOLERANCE = 0.01;		// The margin of an estimate's confidence: the chance its ratio is within this of the real one.
+
+struct HuffmanOptions
+{
+	/*	Settings that change how files are encoded. Decoding detects the format on its own. */
+
+	bool chunked = false;							// Encode into the block container format (see container.h) instead of a single tree and bitstream.
+	size_t block_size = 1 << 20;					// The number of input bytes in each block of the container format.
+	unsigned int threads = 0;						// The number of threads work is split between. 0 means one per hardware thread.
+	unsigned int max_code_length = 0;				// The longest code allowed, which makes canonical trees described by their code lengths. 0 means no limit.
+	bool interleaved = false;						// Split each block into interleaved streams that decode together on one thread (implies chunked).
+	bool adaptive = false;							// Choose for each block between a new tree, the last block's tree, and storing it as it is (implies chunked).
+	bool stats = false;								// Time each phase, and count the bytes and codes, for stats() (see stats.h).
+	bool pipelined = false;							// Read and write files on threads of their own, while they are coded (see pipeline.h).
+	bool checksum = false;							// Keep a checksum of every block, which decoding checks (implies chunked).
+	bool context = false;							// Code each byte with the tree of the byte before it, in the blocks where that is smaller (implies chunked, see context_model.h).
+};
+
+struct HuffmanEstimate
+{
+	/*	What EncodeFile would make of a file, found by EstimateFile from the code lengths of a sample of
+		its bytes, with nothing encoded. Small files are counted in full, which makes the size exact.
+	*/
+
+	uint64_t input_bytes = 0;						// The size of the input.
+	uint64_t sampled_bytes = 0;						// The bytes that were read and counted (all of them when exact).
+	uint64_t encoded_bytes = 0;						// The predicted size of the output, headers and all.
+	double ratio = 1;								// encoded_bytes / input_bytes: below 1 when the file would get smaller (1 for an empty input).
+	double standard_error = 0;						// The standard error of the ratio, from how much it varies between the samples.
+	double confidence = 1;							// The chance that the real ratio is within ESTIMATE_TOLERANCE of ratio (1 when every byte was counted).
+	bool exact = false;								// Whether encoded_bytes is exactly the size EncodeFile would write.
+};
+
+class HuffmanError : public runtime_error
+{
+	/*	Thrown by the Huffman classes for every error: files that can't be opened, and input that
+		is damaged or in the wrong format. The message is meant for the user.
+	*/
+public:
+	explicit HuffmanError(const string &message) : runtime_error(message) {}
+};
+
+class HuffmanCode
+{
+	/*	A prebuilt tree, with its encoding and decoding tables, that can't be changed once made.
+		Since encode and decode only read the tables, one HuffmanCode can be shared by any number
+		of threads at once (for example, one tree from an .htree file used by every request).
+	*/
+public:
+	explicit HuffmanCode(byte_span tree_header);									// Loads the tree from its header (the contents of an .htree file). Throws a HuffmanError if it isn't valid.
+	HuffmanCode(byte_span tree_header, byte_span tables);							// Loads the tree and tables saved by tables() if they were made for this header, or builds them from the header as above.
+	vector<unsigned char> header() const;											// The header that describes the tree (what -t writes to an .htree file).
+	vector<unsigned char> tables() const;											// The tree and its tables, saved so they can be loaded again with no building.
+	bool loadedTables() const { return loaded_tables; }							// Whether the tables were loaded (rather than built).
+	void encode(byte_span input, vector<unsigned char> &output) const;				// Adds the encoded bits of input (with no header) to the end of output.
+	void decode(byte_span encoded, vector<unsigned char> &output) const;			// Adds the bytes decoded from bits made by encode to the end of output.
+
+private:
+	static const size_t MESSAGE_BLOCK_SIZE = 64 << 10;	// The output buffer for encode. Smaller than a file's, since shared trees are mostly used for small messages.
+	unique_ptr<HuffmanTree> tree;					// The tree, with its tables already built. Kept on the heap so codes can be moved cheaply.
+	bool loaded_tables = false;
+	void buildTables(byte_span tree_header);		// Rebuilds the tree from its header and builds both tables, or throws a HuffmanError.
+	friend class Huffman;							// Huffman encodes files with the tree directly.
+};
+
 class Huffman
 {
+	/*	The encoder and decoder. The file methods (and the in-memory methods that mirror them) use
+		trees owned by the object, so each thread should have its own Huffman. Every method throws
+		a HuffmanError instead of exiting when something goes wrong.
+	*/
 public:
 	Huffman();
 	void displayHelp();																// Displays usage information on the program.
 	void MakeTreeBuilder(string inputFile, string outputFile);						// Makes a tree builder from the given input file.
+	void MakeTreeBuilder(const vector<string> &inputFiles, string outputFile);		// Makes one tree builder from the byte counts of many sample files, and caches its tables.
 	void EncodeFile(string inputFile, string outputFile);							// Encodes a file (creating a tree in the process)
 	void DecodeFile(string inputFile, string outputFile);							// Decodes a file (one already containing a tree)
+	void DecodeFileRange(string inputFile, string outputFile, uint64_t offset, uint64_t length);	// Decodes only length bytes from offset of a file's decoded bytes (fewer if it ends first), without decoding the rest.
 	void EncodeFileWithTree(string inputFile, string TreeFile, string outputFile);	// Encodes a file with a separately defined tree.
+	void EncodeFileWithTree(string inputFile, const HuffmanCode &code, string outputFile);	// Encodes a file with a tree already loaded (such as one shared by a batch).
+	HuffmanEstimate EstimateFile(string inputFile);									// Predicts the size EncodeFile would write for a file, from a sample of it, without encoding anything (see estimate.cpp).
+	void MakeCodeHeader(string TreeFile, string outputFile);						// Writes a C++ header with a codec specialized for a tree file's tree (see codegen.cpp).
+	HuffmanCode readTreeFile(string TreeFile);										// Loads the tree from a tree file (as made by MakeTreeBuilder), using the cached tables next to it when they are up to date.
+	void setOptions(const HuffmanOptions &new_options);								// Changes the settings used by the methods above.
+	HuffmanStats stats() const;														// The time of each phase and the counts of every method since the stats option was set (all 0 without it).
+	void resetStats();																// Starts the counts of stats() again from 0.
+
+	// In-memory versions of the methods above. Results are added to the end of output.
+	void compress(byte_span input, vector<unsigned char> &output);					// Encodes a buffer (creating a tree in the process), like EncodeFile.
+	void compress(byte_span input, const HuffmanCode &code, vector<unsigned char> &output);	// Encodes a buffer with a prebuilt tree, like EncodeFileWithTree.
+	void decompress(byte_span input, vector<unsigned char> &output);				// Decodes a buffer from any of the methods above, like DecodeFile.
+	void decompressRange(byte_span input, uint64_t offset, uint64_t length, vector<unsigned char> &output);	// Decodes a range of a buffer's decoded bytes, like DecodeFileRange (a single stream has no saved range index, so it is decoded once to make one).
+	HuffmanEstimate estimate(byte_span input);										// Predicts the size compress would make of a buffer, like EstimateFile.
+	HuffmanCode buildTree(byte_span input);											// Builds a tree for a buffer, like MakeTreeBuilder.
 private:
-	struct node 
-	{
-		/*	The basis for a single 8-bit value's Huffman coding. Provides all required memory mappings */
-
-		unsigned char byte_value;					// The value of the byte ("character") in the node (if it is a leaf)
-		unsigned int weight;						// The weight of the node.
-		node* LCH;									// The left child.
-		node* RCH;									// The right child.
-		node* parent = NULL;						// Parent node (to make traversing easier when building encoding strings.)
-	};
-	node* root_node;								// The root node of the Huffman tree. At the end of tree building, it will be an ancestor to every possible byte value.
-	
-	// Tree information
-	node* frequency_table[256];						// The frequency table mapping. This table holds the calculated frequencies of all bytes in a file.
-	unsigned char tree_sequence[510];				// The sequence that creates the tree for the input file. There are 510 positions, and each holds the frequency rows to be merged (from 0-255, fitting in an unsigned char).
-	string bit_encodings[256];						// Array of strings that represent each byte value's encoded representation. We can use a string to store each of these so we don't need to worry about bits unil encoding.
-	
+	HuffmanOptions options;							// The current settings.
+	HuffmanTree file_tree;							// The tree for the file being worked on. It is reset for each file, so nothing is allocated again.
+	vector<unique_ptr<HuffmanTree>> block_trees;	// A tree for each block of a batch in the block container format, kept between batches and files.
+	unique_ptr<HuffmanTree> carried_tree;			// The last tree of the previous batch, which the blocks of the next batch can reuse.
+	vector<unique_ptr<ContextModel>> block_models;	// A context model for each block of a batch, kept like the block_trees.
+	ContextModel file_model;						// The context model for the block being worked on when blocks are decoded one at a time.
+	unsigned int thread_count;						// The number of threads that work can be split between.
+	static const size_t ENCODE_BLOCK_SIZE = 1 << 20;	// The size of the output buffer the encoded bits are packed into.
+	static const size_t SPECULATIVE_CHUNK_SIZE = 256 << 10;	// The encoded bytes each thread decodes at a time in decodeSpeculative_.
+	static const size_t SPECULATIVE_SYNC_CODES = 1024;	// The codes at the start of a speculative chunk that its join with the chunk before is looked for in.
+	static const size_t ESTIMATE_SAMPLE_SIZE = 64 << 10;	// The size of each sample estimate_ counts from a single stream file.
+	static const size_t ESTIMATE_SAMPLES = 64;		// The most samples estimate_ counts from a single stream file. Smaller files are counted in full.
+	static const size_t ESTIMATE_BLOCK_SAMPLES = 16;	// The most blocks estimate_ sizes from a file to be encoded in blocks.
+	unique_ptr<StatsCounters> stats_counters;		// The counters for stats(), only made when the stats option is set. Every PhaseTimer given NULL does nothing.
+
 	// Private IO Functions
-	void DecodeFile_(ifstream &input_stream, ofstream &output_stream); // Decodes a file given in the input stream, to the output stream.
-	void EncodeFile_(ifstream &input_stream, ofstream &output_stream); // Encodes a file given in the input stream, assuming the encoding strings have already been made.
-	void outputTreeBuilder(ofstream &outputFile);		// Output the tree builder to the desired file.
+	void openInput(InputFile &input_file, const string &path);		// Opens an input file, or throws a HuffmanError.
+	void openOutput(OutputFile &output_file, const string &path);	// Opens an output file, or throws a HuffmanError.
+	void closeOutput(OutputFile &output_file, const string &path);	// Closes an output file, throwing a HuffmanError if any of it couldn't be written.
+	void encode_(InputFile &input_file, ByteSink &output);			// Encodes the input with a tree made for it (or in blocks).
+	void encodeWithTree_(InputFile &input_file, const HuffmanCode &code, ByteSink &output);	// Encodes the input with a prebuilt tree.
+	void decode_(InputFile &input_file, ByteSink &output);			// Decodes the input, whichever format it is in.
+	void DecodeFile_(HuffmanTree &tree, InputFile &input_file, ByteSink &output_file);	// Decodes the input file from its current position, to the output file.
+	void EncodeFile_(const HuffmanTree &tree, InputFile &input_file, ByteSink &output_file);	// Encodes the input file from its current position, once the tree's code table has been made.
+	void outputTreeBuilder(const HuffmanTree &tree, ByteSink &output_file);	// Output the tree builder to the desired file.
+	void writeTableCache(const HuffmanTree &tree, const string &tree_path);	// Saves the tables of a tree next to its tree file, if the file can be written.
+	ByteSink &statsOutput(CountingSink &counted_output, ByteSink &output);	// The counted output when counting for stats(), or the output itself.
+	ByteSink &pipelineOutput(unique_ptr<PipelineWriter> &pipeline, ByteSink &output);	// A writer thread in front of the output with the pipelined option, or the output itself.
+	void countOperation(const InputFile &input_file, const CountingSink &counted_output);	// Adds a file (or buffer) that was worked on to the counters, if there are any.
 
 	// Private Tree Building Functions
-	void buildFrequencyTable(ifstream &input_stream);	// Calculates the frequency of characters from a given file.
-	void rebuildTree(ifstream &input_stream);			// Rebuilds the tree from an input file.
-	void createTree();									// The method that creates the tree from the frequency table.
-
-	// Private Encoding String Functions
-	void createEncodingStrings();						// Creates a list of bit_encodings in the form of strings by starting at the root and calling buildNodeString.
-	void buildNodeString(node* current_node, string current_encoding);	// Creates a string representing the bit path of the node from the root.
-	unsigned char stringToByte(string bit_string);		// Converts a bit string (1,0 in string format) to a byte.
-};
\ No newline at end of file
+	void buildFrequencyTable(HuffmanTree &tree, InputFile &input_file);	// Calculates the frequency of characters from a given file.
+	void createTree(HuffmanTree &tree);				// Makes the tree from its weights, limiting the code lengths if the options ask for it.
+	void readTreeHeader(InputFile &input_file, vector<unsigned char> &tree_header);	// Reads a tree header (of either kind) from an input file.
+	void rebuildTree(HuffmanTree &tree, InputFile &input_file, vector<unsigned char> &tree_header);	// Reads a tree header from an input file and rebuilds the tree from it.
+
+	// Private Block Container Functions (container.cpp)
+	bool isContainer(InputFile &input_file);		// Checks if a file starts with the block container header, without reading past it.
+	void EncodeContainer_(InputFile &input_file, ByteSink &output_file, const vector<unsigned char>* tree_header);	// Encodes the input into blocks, each with its own tree (or the tree of the given header).
+	void DecodeContainer_(InputFile &input_file, ByteSink &output_file);	// Decodes every block of a block container file.
+	void reserveBlockTrees(size_t count);			// Makes sure there are at least count block_trees (and block_models).
+	void buildBlockTree(HuffmanTree &tree, const unsigned char* data, size_t size, const vector<unsigned char>* tree_header, uint64_t counts[256]);	// Makes the tree and code table for one block, keeping its counts if asked.
+	unsigned char chooseBlockType(const HuffmanTree &tree, const HuffmanTree* previous_tree, const ContextModel* model, const uint64_t counts[256], size_t size);	// Picks the smallest type for a block, from its estimated sizes.
+	void encodeBlock(const HuffmanTree &tree, const ContextModel &model, unsigned char block_type, const unsigned char* data, size_t size, vector<unsigned char> &block_output);	// Encodes one block, header and all.
+	bool decodeBlock(const HuffmanTree &tree, ContextModel &model, unsigned char block_type, const unsigned char* payload, size_t payload_size, size_t decoded_size, vector<unsigned char> &block_output, uint32_t* checksum);	// Decodes one block's payload (after any tree header), and its checksum if asked for. Returns false if it is damaged.
+	uint64_t estimateBlock(HuffmanTree &tree, ContextModel &model, const unsigned char* data, size_t size);	// The exact size EncodeContainer_ would store a block in (header and payload), with no earlier tree to reuse, found without encoding it.
+	uint64_t containerOverhead(uint64_t block_count) const;	// The bytes of a container file that aren't in its blocks: the file header, end block, block index and trailer.
+	unsigned int contextCodeLength() const;			// The longest code of the context models, from the options.
+	uint64_t DecodeContainerRange_(InputFile &input_file, ByteSink &output_file, uint64_t offset, uint64_t length);	// Decodes a range of a block container file through its block index. Returns the bytes read.
+
+	// Private Range Functions (range.cpp)
+	uint64_t decodeRange_(InputFile &input_file, const string &input_path, ByteSink &output, uint64_t offset, uint64_t length);	// Decodes a range of the input, whichever format it is in, keeping a single stream's range index next to input_path ("" for none). Returns the bytes read.
+	void buildRangeIndex(const HuffmanTree &tree, InputFile &input_file, RangeIndex &index);	// Decodes a single stream from the read position, recording its checkpoints in index.
+
+	// Private Estimate Functions (estimate.cpp)
+	HuffmanEstimate estimate_(InputFile &input_file);	// Predicts the size encode_ would write for the input, from a sample of it.
+
+	// Private Speculative Decoding Functions (speculative.cpp)
+	void decodeSpeculative_(const HuffmanTree &tree, const unsigned char* data, size_t size, ByteSink &output);	// Decodes a whole single stream in memory on thread_count threads, with the same output as decodeBits.
+};
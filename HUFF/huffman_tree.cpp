@@ -0,0 +1,1074 @@
+//	File:			huffman_tree.cpp
+//	Description:	The implementation of a single Huffman tree. Builds the tree from byte weights (or rebuilds it from
+//					a tree_sequence), then turns it into the packed code table used for encoding and the lookup tables
+//					used for decoding. The encoding and decoding kernels work on ranges of bytes in memory.
+
+#include "huffman_tree.h"
+#include "crc32c.h"
+#include <climits>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+
+HuffmanTree::HuffmanTree()
+{
+	/*	The constructor for the Huffman tree. All of the nodes live in the tree itself,
+		so there is nothing to allocate. Starts out reset.
+	*/
+	reset();
+}
+
+void HuffmanTree::reset()
+{
+	/*	Puts the tree back to where it started: a frequency table of 0 weight leaves,
+		one for each possible 8-bit value, and no merged nodes. The tables made from an
+		earlier tree keep their memory, so a reused tree doesn't allocate again.
+	*/
+	for (int i = 0; i < 256; i++)
+	{
+		nodes[i].LCH = nodes[i].RCH = NO_NODE;		// Leaves have no children. Their index is their byte value.
+		nodes[i].weight = 0;
+		frequency_table[i] = uint16_t(i);
+	}
+	node_count = 256;
+	root_node = NO_NODE;
+	canonical = false;
+}
+
+uint16_t HuffmanTree::mergeNodes(uint16_t left, uint16_t right)
+{
+	/*	Takes the next free node of the array as the parent of the two nodes given,
+		with the sum of their weights. Returns the parent's index.
+	*/
+	node &newParent = nodes[node_count];
+	newParent.LCH = left;
+	newParent.RCH = right;
+	newParent.weight = nodes[left].weight + nodes[right].weight;		// Add the weights of the children
+	return node_count++;
+}
+
+void HuffmanTree::setWeights(const uint64_t counts[256])
+{
+	/*	Resets the tree, then gives each byte value's node the number of times
+		it was counted as its weight. Weights are 32 bits, so counts that add up to more than
+		MAXIMUM_TOTAL_WEIGHT (from more than 4 GiB of input) are halved until they don't, keeping
+		every byte that was counted at all at a weight of at least 1. The largest weight still has
+		24 bits or more, so the code lengths are all but the same as the full counts would give.
+	*/
+	reset();
+	uint64_t total = 0;
+	for (int i = 0; i < 256; i++) total += counts[i];
+	unsigned int shift = 0;
+	while (total > MAXIMUM_TOTAL_WEIGHT)
+	{
+		shift++;
+		total = 0;
+		for (int i = 0; i < 256; i++) total += counts[i] == 0 ? 0 : max(counts[i] >> shift, uint64_t(1));
+	}
+	for (int i = 0; i < 256; i++)
+	{
+		nodes[i].weight = (unsigned int)(counts[i] == 0 ? 0 : max(counts[i] >> shift, uint64_t(1)));
+	}
+}
+
+void HuffmanTree::createTree()
+{
+	/*	This method takes the frequency values constructed, and builds a tree out of them.
+		The two lowest weight nodes are taken from a min-heap, and 'merged' by linking them to a
+		parent that records the sum of their weights. The parent goes back into the heap in the
+		smaller of the two rows. This runs until all of the nodes are in a single root node.
+
+		Each heap key is the weight above the row number, so comparing keys orders nodes by weight,
+		then by row. That is exactly the order the original linear scan (mergeByScan) picked them in,
+		so the tree_sequence is the same. The scan can never pick a node of weight UINT_MAX by its
+		weight (it only looks for weights below it), so if one of those would be merged, the rest of
+		the merges are left to the scan itself.
+	*/
+	uint64_t heap[256];								// The rows still to be merged, as (weight << 8 | row).
+	for (int i = 0; i < 256; i++) heap[i] = (uint64_t(nodes[frequency_table[i]].weight) << 8) | i;
+	make_heap(heap, heap + 256, greater<uint64_t>());
+	size_t heap_size = 256;
+
+	for (int k = 0; k < 255; k++)
+	{
+		pop_heap(heap, heap + heap_size, greater<uint64_t>());		// Take the two smallest keys off the heap.
+		pop_heap(heap, heap + heap_size - 1, greater<uint64_t>());
+		uint64_t first = heap[heap_size - 1];
+		uint64_t second = heap[heap_size - 2];
+		if ((second >> 8) == UINT_MAX)				// The scan treats these weights differently, so let it finish.
+		{
+			mergeByScan(k);
+			return;
+		}
+		heap_size -= 2;
+
+		unsigned char minRow = (unsigned char)(first & 0xFF);		// Give the smaller subscript node to the left child, as the scan does.
+		unsigned char maxRow = (unsigned char)(second & 0xFF);
+		if (maxRow < minRow) swap(minRow, maxRow);
+
+		uint16_t newParent = mergeNodes(frequency_table[minRow], frequency_table[maxRow]);
+		frequency_table[minRow] = newParent;		// The merged node takes the smaller row.
+		frequency_table[maxRow] = NO_NODE;
+		tree_sequence[k*2] = minRow;				// Record the two nodes that were squashed in the tree_sequence.
+		tree_sequence[k*2+1] = maxRow;
+
+		heap[heap_size++] = (uint64_t(nodes[newParent].weight) << 8) | minRow;
+		push_heap(heap, heap + heap_size, greater<uint64_t>());
+	}
+	root_node = frequency_table[0];					// Assign the root node for easy access.
+	frequency_table[0] = NO_NODE;
+}
+
+void HuffmanTree::mergeByScan(int first_merge)
+{
+	/*	The original tree builder, which createTree matches. Starting at merge first_merge,
+		minimum nodes are found by scanning every row of the frequency table, and their positions recorded.
+		These nodes are 'merged' by linking them to a parent that records the sum of their weights.
+		This algorithm runs until all of the nodes are in a single root node. 
+	*/
+
+	// We know we will need just enough iterations to merge all the nodes together in the tree. (255 merges of 2 nodes = 510 bytes)
+	for(int k=first_merge; k <255; k++)
+	{
+		// Set up variables to find the lowest weights and record their position.
+		unsigned char rowNode1, rowNode2;
+		rowNode1 = rowNode2 = 0;
+		unsigned int minVal1, minVal2;
+		minVal1 = minVal2 = UINT_MAX;
+
+		// Iterate through and find the lowest node.
+		for (int i = 0; i < 256; i++)
+		{
+			uint16_t current = frequency_table[i];		// Record the current node for code clarity
+			if (current == NO_NODE) continue;			// Skip rows that were merged away.
+			if (nodes[current].weight < minVal1)			
+			{
+				minVal1 = nodes[current].weight;			// Record the current weight if it's the new minimum
+				rowNode1 = i;						// Also record that subscript.
+			}
+		}
+		// Second minimum value loop.
+		for (int i = 0; i < 256; i++)
+		{
+			uint16_t current = frequency_table[i];				// Record the current node for code clarity
+			uint16_t minimumNode1 = frequency_table[rowNode1];	// Keep track of the previous minimum node so we don't hit it.
+			if (current == NO_NODE || current == minimumNode1 ) continue;			// Skip empty rows, and the first minimum
+			if (nodes[current].weight < minVal2)
+			{
+				minVal2 = nodes[current].weight;					// Record the current weight if it's the new minimum
+				rowNode2 = i;								// Also record that subscript.
+			}
+		}
+
+		// Find the smaller and larger subscript to properly give the correct children based on subscript.
+		// This makes it easier to figure out which node came "first" in the tree
+		unsigned char minRow, maxRow;				
+		if (rowNode1 < rowNode2) { minRow = rowNode1; maxRow = rowNode2; }
+		else {minRow = rowNode2; maxRow = rowNode1;}
+		
+		// Make the parent, giving the smaller subscript node to the left child.
+		frequency_table[minRow] = mergeNodes(frequency_table[minRow], frequency_table[maxRow]);	// Reassign the frequency table nodes.
+		frequency_table[maxRow] = NO_NODE;		// The larger subscript points to nothing now.
+
+		
+		tree_sequence[k*2] = minRow;			// Record the two nodes that were squashed in the tree_sequence.
+		tree_sequence[k*2+1] = maxRow;			// Because the loop is 0 <= k < 255, we need to multiply by 2 to access the 'pair' index
+	}
+	root_node = frequency_table[0]; // Assign the root node for easy access.
+	frequency_table[0] = NO_NODE;
+}
+
+bool HuffmanTree::rebuildTree(const unsigned char sequence[510])
+{
+	/*	Resets the tree, then rebuilds it from a tree_sequence (as written at the start of a file).
+		Each pair of the sequence names the two frequency table rows that were merged,
+		the merged node going into the first row.
+		Returns false if the sequence does not make a valid tree (a row is used after it
+		was merged away, or merged with itself).
+	*/
+
+	unsigned char firstNode, secondNode;
+	reset();
+	memcpy(tree_sequence, sequence, 510);
+	for (int i = 0; i < 255; i++)
+	{
+		firstNode = tree_sequence[i*2];
+		secondNode = tree_sequence[i*2+1];
+		uint16_t minimumNode1 = frequency_table[firstNode];		// Assign the nodes as given
+		uint16_t minimumNode2 = frequency_table[secondNode];
+
+		if (minimumNode1 == NO_NODE || minimumNode2 == NO_NODE || firstNode == secondNode)		// If either row is empty, it's possible the tree file provided was invalid
+		{
+			return false;
+		}
+
+		frequency_table[firstNode] = mergeNodes(minimumNode1, minimumNode2);	// Put the merged nodes into the lower subsript, the first node to the left.
+		frequency_table[secondNode] = NO_NODE;					// Clear the larger subscript.
+	}
+	for (int i = 0; i < 256; i++)								// After 255 merges, exactly one row is left holding the root.
+	{
+		if (frequency_table[i] != NO_NODE)
+		{
+			root_node = frequency_table[i];
+			frequency_table[i] = NO_NODE;
+		}
+	}
+	return true;
+}
+
+void HuffmanTree::createLimitedTree(unsigned int max_length)
+{
+	/*	Creates a canonical tree from the weights, where no code is longer than max_length bits
+		(between MINIMUM_LIMITED_LENGTH and MAXIMUM_LIMITED_LENGTH). The lengths of the codes are
+		chosen by limitCodeLengths, then the codes themselves are given out in canonical order,
+		so the tree can be described by the code lengths alone.
+	*/
+	limitCodeLengths(max_length);
+	buildCanonicalTree();
+}
+
+void HuffmanTree::limitCodeLengths(unsigned int max_length)
+{
+	/*	Finds the code length of every byte value with the package-merge algorithm, which gives the
+		smallest output possible for codes of at most max_length bits. Every byte value gets a code
+		(as in the unlimited tree), so any input can be encoded with the tree.
+
+		Each level of the algorithm holds the 256 leaves, merged in weight order with the packages
+		made by pairing up the items of the level below. The cheapest 2 * 256 - 2 items of the top
+		level are taken. A leaf's code length is the number of levels it is taken from, and a package
+		taken on one level means both of its items are taken on the level below. Since packages pair
+		the items of the level below in order, taking the first m packages takes the first 2 * m items.
+	*/
+	struct item
+	{
+		uint64_t weight;
+		int leaf;								// The byte value, or -1 for a package.
+	};
+
+	item leaves[256];
+	for (int i = 0; i < 256; i++) leaves[i] = { nodes[i].weight, i };
+	stable_sort(leaves, leaves + 256, [](const item &a, const item &b) { return a.weight < b.weight; });
+
+	vector<vector<item>> levels(max_length);	// levels[0] is the top level (the first bit of a code).
+	levels[max_length - 1].assign(leaves, leaves + 256);
+	for (int level = int(max_length) - 2; level >= 0; level--)
+	{
+		const vector<item> &below = levels[level + 1];
+		vector<item> &current = levels[level];
+		size_t next_leaf = 0, next_pair = 0;
+		while (next_leaf < 256 || next_pair + 1 < below.size())		// Merge the leaves with the packages, leaves first on ties.
+		{
+			bool take_leaf = next_pair + 1 >= below.size() ||
+				(next_leaf < 256 && leaves[next_leaf].weight <= below[next_pair].weight + below[next_pair + 1].weight);
+			if (take_leaf) current.push_back(leaves[next_leaf++]);
+			else
+			{
+				current.push_back({ below[next_pair].weight + below[next_pair + 1].weight, -1 });
+				next_pair += 2;
+			}
+		}
+	}
+
+	memset(code_lengths, 0, sizeof(code_lengths));
+	size_t taken = 2 * 256 - 2;
+	for (unsigned int level = 0; level < max_length && taken > 0; level++)
+	{
+		size_t packages = 0;
+		for (size_t i = 0; i < taken; i++)
+		{
+			if (levels[level][i].leaf >= 0) code_lengths[levels[level][i].leaf]++;
+			else packages++;
+		}
+		taken = 2 * packages;
+	}
+}
+
+bool HuffmanTree::buildCanonicalTree()
+{
+	/*	Builds the tree for the code lengths in code_lengths. Codes are given out in order of length,
+		then byte value, each one the next binary number after the one before it (shifted left as the
+		length grows). Each code's path is then added to the tree, making the nodes along it.
+		Returns false if the lengths don't make a complete code, where every path ends in a leaf.
+	*/
+	uint32_t kraft_sum = 0;						// The share of the code space used, in units of 2^-MAXIMUM_LIMITED_LENGTH.
+	for (int i = 0; i < 256; i++)
+	{
+		if (code_lengths[i] < 1 || code_lengths[i] > MAXIMUM_LIMITED_LENGTH) return false;
+		kraft_sum += uint32_t(1) << (MAXIMUM_LIMITED_LENGTH - code_lengths[i]);
+	}
+	if (kraft_sum != uint32_t(1) << MAXIMUM_LIMITED_LENGTH) return false;
+
+	unsigned char order[256];					// The byte values, by code length then value.
+	for (int i = 0; i < 256; i++) order[i] = (unsigned char)(i);
+	stable_sort(order, order + 256, [&](unsigned char a, unsigned char b) { return code_lengths[a] < code_lengths[b]; });
+
+	for (int i = 0; i < 256; i++) nodes[i].LCH = nodes[i].RCH = NO_NODE;
+	node_count = 256;
+	root_node = node_count++;
+	nodes[root_node].LCH = nodes[root_node].RCH = NO_NODE;
+	nodes[root_node].weight = 0;				// The merged nodes have no weights of their own, but are given one so saved tables are the same every time.
+
+	uint32_t code = 0;
+	unsigned int previous_length = code_lengths[order[0]];
+	for (int i = 0; i < 256; i++)
+	{
+		unsigned int length = code_lengths[order[i]];
+		code <<= length - previous_length;
+		previous_length = length;
+
+		uint16_t current_node = root_node;
+		for (unsigned int bit = length - 1; bit > 0; bit--)		// Walk (or make) the path down to the leaf's parent.
+		{
+			uint16_t &child = ((code >> bit) & 1) ? nodes[current_node].RCH : nodes[current_node].LCH;
+			if (child == NO_NODE)
+			{
+				child = node_count;
+				nodes[node_count].LCH = nodes[node_count].RCH = NO_NODE;
+				nodes[node_count].weight = 0;
+				node_count++;
+			}
+			current_node = child;
+		}
+		if (code & 1) nodes[current_node].RCH = order[i];
+		else nodes[current_node].LCH = order[i];
+		code++;
+	}
+	canonical = true;
+	return true;
+}
+
+size_t HuffmanTree::headerSize() const
+{
+	/*	The number of bytes writeHeader writes for this tree.
+	*/
+	return canonical ? CANONICAL_HEADER_SIZE : 510;
+}
+
+void HuffmanTree::writeHeader(unsigned char* header) const
+{
+	/*	Writes the description of the tree that readHeader rebuilds it from. Unlimited trees are
+		written as their 510 byte tree_sequence. Canonical trees are written as CANONICAL_MAGIC,
+		then the code lengths packed two to a byte (the first in the high 4 bits).
+	*/
+	if (!canonical)
+	{
+		memcpy(header, tree_sequence, 510);
+		return;
+	}
+	memcpy(header, CANONICAL_MAGIC, 4);
+	for (int i = 0; i < 128; i++) header[4 + i] = (unsigned char)((code_lengths[i * 2] << 4) | code_lengths[i * 2 + 1]);
+}
+
+size_t HuffmanTree::headerSizeFor(const unsigned char* first_bytes, size_t available)
+{
+	/*	Works out the size of a tree header from its first bytes (up to 4). A tree_sequence never
+		starts with CANONICAL_MAGIC, as its first row is always the smaller one.
+	*/
+	if (available >= 4 && memcmp(first_bytes, CANONICAL_MAGIC, 4) == 0) return CANONICAL_HEADER_SIZE;
+	return 510;
+}
+
+bool HuffmanTree::readHeader(const unsigned char* header, size_t size)
+{
+	/*	Rebuilds the tree from a header written by writeHeader. Returns false if the header is
+		too short, or doesn't describe a valid tree.
+	*/
+	size_t header_size = headerSizeFor(header, size);
+	if (size < header_size) return false;
+	if (header_size == 510) return rebuildTree(header);
+
+	reset();
+	for (int i = 0; i < 128; i++)
+	{
+		code_lengths[i * 2] = header[4 + i] >> 4;
+		code_lengths[i * 2 + 1] = header[4 + i] & 0x0F;
+	}
+	return buildCanonicalTree();
+}
+
+void HuffmanTree::createCodeTable()
+{
+	/*	Begins creating codewords for every node by starting
+		at the root, with an empty code.
+	*/
+	long_code_table.clear();
+	buildCodeword(root_node, 0);
+	packCodes();
+}
+
+void HuffmanTree::packCodes()
+{
+	/*	Packs each code with its length for the grouped kernels, and picks the largest group
+		whose merged codes still fit in a single putBits.
+	*/
+	unsigned int longest = 0;
+	for (int i = 0; i < 256; i++)
+	{
+		if (code_table[i].length > longest) longest = code_table[i].length;
+		uint64_t mask = code_table[i].length < 32 ? (uint64_t(1) << code_table[i].length) - 1 : 0xFFFFFFFF;	// Merging needs nothing above the code's own bits.
+		packed_codes[i] = (code_table[i].bits & mask) | (uint64_t(code_table[i].length) << 32);
+	}
+	encode_group = longest <= ENCODE_QUAD_LENGTH ? 4 : longest <= ENCODE_PAIR_LENGTH ? 2 : 1;
+	pair_codes.clear();								// A pair table made for the last tree no longer applies.
+}
+
+void HuffmanTree::buildPairTable()
+{
+	/*	Merges the codes of every pair of byte values into one entry, so encodePairs needs one lookup
+		(and one putBits) for every two bytes. Pairs whose codes add up to more than BitWriter::MAX_CODE_LENGTH
+		are left 0, and written one code at a time. The table is 512K, so it is only worth making once
+		it will be used for a lot of input.
+	*/
+	pair_codes.assign(size_t(1) << 16, 0);
+	for (int second = 0; second < 256; second++)
+	{
+		const codeword &second_code = code_table[second];
+		for (int first = 0; first < 256; first++)
+		{
+			const codeword &first_code = code_table[first];
+			unsigned int length = first_code.length + second_code.length;
+			if (length > BitWriter::MAX_CODE_LENGTH) continue;
+			uint64_t first_bits = first_code.bits & ((uint64_t(1) << first_code.length) - 1);
+			uint64_t second_bits = second_code.bits & ((uint64_t(1) << second_code.length) - 1);
+			pair_codes[size_t(second) << 8 | size_t(first)] = ((first_bits << second_code.length) | second_bits) | (uint64_t(length) << PAIR_LENGTH_SHIFT);
+		}
+	}
+}
+
+void HuffmanTree::buildCodeword(uint16_t current_node, unsigned int depth)
+{
+	/*	This method visits all nodes (starting from the root provided) and
+		records the path taken to reach them in code_path.
+		Recurses LEFT-wards through until a leaf is hit. When a leaf is hit,
+		it will then start work on the RIGHT path.
+		Each time a LEFT path is taken, the path gains a 0, and
+		a 1 for the RIGHT path. After a leaf is hit, the path is packed into
+		the leaf's codeword.
+	*/
+
+	if (isLeaf(current_node))											// If we hit a leaf node, we save the code in the table
+	{
+		codeword &code = code_table[current_node];
+		code.length = depth;
+		code.bits = 0;
+		for (unsigned int i = 0; i < depth; i++) code.bits = (code.bits << 1) | code_path[i];	// Pack the path (only the last 64 bits remain for long codes).
+
+		if (depth > BitWriter::MAX_CODE_LENGTH)							// Codes too long to write at once are also kept in full.
+		{
+			if (long_code_table.empty()) long_code_table.assign(256 * 4, 0);
+			uint64_t* words = &long_code_table[size_t(current_node) * 4];
+			for (unsigned int i = 0; i < 4; i++) words[i] = 0;
+			for (unsigned int i = 0; i < depth; i++) words[i / 64] |= uint64_t(code_path[i]) << (63 - i % 64);
+		}
+	}
+	else
+	{
+		code_path[depth] = 0;
+		buildCodeword(nodes[current_node].LCH, depth + 1);		// First try the left path, adding a 0 to the code if we do.
+
+		code_path[depth] = 1;
+		buildCodeword(nodes[current_node].RCH, depth + 1);		// Once the left path returns, we try the right path, adding a 1 to the code if we do.
+	}
+}
+
+void HuffmanTree::encodeBytes(const unsigned char* data, size_t size, BitWriter &writer) const
+{
+	/*	Packs the code for every byte in the range into the writer. When the codes are short enough to
+		be merged, the grouped kernel does it instead (see encode_kernels.h). Otherwise, if a pair
+		table was made, the codes are written two at a time from it. Every kernel writes the same bits as
+		the loop here.
+	*/
+	EncodeKernel kernel = encode_group > 1 ? encodeKernel() : ENCODE_KERNEL_SCALAR;
+	if (!pair_codes.empty() && kernel == ENCODE_KERNEL_SCALAR)
+	{
+		encodePairs(data, size, writer);
+		return;
+	}
+	if (kernel == ENCODE_KERNEL_GROUPED)
+	{
+		encodeGrouped(packed_codes, encode_group, data, size, writer);
+		return;
+	}
+	for (size_t i = 0; i < size; i++)
+	{
+		const codeword &code = code_table[data[i]];		// Lookup the code for the current byte
+		if (code.length <= BitWriter::MAX_CODE_LENGTH) writer.putBits(code.bits, code.length);
+		else putLongCode(writer, data[i]);
+	}
+}
+
+void HuffmanTree::encodePairs(const unsigned char* data, size_t size, BitWriter &writer) const
+{
+	/*	Writes each pair of bytes with the single merged code from pair_codes. The few pairs too long
+		to merge (an entry of 0), and a byte left over at the end, are written a code at a time.
+	*/
+	const uint64_t* pairs = pair_codes.data();
+	size_t i = 0;
+	for (; i + 2 <= size; i += 2)
+	{
+		uint64_t entry = pairs[size_t(data[i]) | (size_t(data[i + 1]) << 8)];
+		if (entry != 0)
+		{
+			writer.putBits(entry & PAIR_BITS_MASK, (unsigned int)(entry >> PAIR_LENGTH_SHIFT));
+			continue;
+		}
+		for (size_t j = i; j < i + 2; j++)
+		{
+			const codeword &code = code_table[data[j]];
+			if (code.length <= BitWriter::MAX_CODE_LENGTH) writer.putBits(code.bits, code.length);
+			else putLongCode(writer, data[j]);
+		}
+	}
+	for (; i < size; i++)
+	{
+		const codeword &code = code_table[data[i]];
+		if (code.length <= BitWriter::MAX_CODE_LENGTH) writer.putBits(code.bits, code.length);
+		else putLongCode(writer, data[i]);
+	}
+}
+
+uint64_t HuffmanTree::encodedBits(const uint64_t counts[256]) const
+{
+	/*	Adds up the length of every byte's code, from the counts of each byte value. This is exactly
+		the size encodeBytes would produce, found from the code_table alone.
+	*/
+	uint64_t bits = 0;
+	for (int i = 0; i < 256; i++) bits += counts[i] * code_table[i].length;
+	return bits;
+}
+
+void HuffmanTree::putLongCode(BitWriter &writer, unsigned char byte_value) const
+{
+	/*	Writes a code longer than BitWriter::MAX_CODE_LENGTH, 32 bits at a time.
+		These are stored left aligned in 4 words of the long_code_table.
+	*/
+	const uint64_t* words = &long_code_table[size_t(byte_value) * 4];
+	unsigned int length = code_table[byte_value].length;
+	for (unsigned int position = 0; position < length; position += 32)
+	{
+		uint64_t chunk = (words[position / 64] >> (32 - position % 64)) & 0xFFFFFFFF;	// The 32 bits starting at position.
+		unsigned int chunk_length = length - position < 32 ? length - position : 32;
+		writer.putBits(chunk >> (32 - chunk_length), chunk_length);
+	}
+}
+
+uint64_t HuffmanTree::codePrefix(unsigned char byte_value, unsigned int length) const
+{
+	/*	Returns the first length bits of the code for a byte value (right aligned).
+		The length must be at most 64 bits, and no longer than the code.
+	*/
+	const codeword &code = code_table[byte_value];
+	if (code.length <= 64) return code.bits >> (code.length - length);
+	return long_code_table[size_t(byte_value) * 4] >> (64 - length);		// Long codes keep their first bits in the first word.
+}
+
+void HuffmanTree::padFinalByte(BitWriter &writer) const
+{
+	/*	If the last byte of the output isn't full, it is padded with the start of a code that is
+		longer than the bits remaining. Those bits lead partway down the tree without reaching a
+		leaf, so the decoder drops them.
+	*/
+	if (writer.pendingBits() == 0) return;
+	unsigned int bits_required = 8 - writer.pendingBits();		// The amount remaining in the byte.
+	for (int i = 0; i < 256; i++)								// Search the code table
+	{
+		if (code_table[i].length > bits_required)				// We can use padding bits that will cause us to not hit any leaf nodes by choosing a code longer than the bits remaining.
+		{
+			writer.putBits(codePrefix(i, bits_required), bits_required);	// Pad with the start of that code.
+			break;				// Exit the loop on the first one we find.
+		}
+	}
+}
+
+void HuffmanTree::buildDecodeTable()
+{
+	/*	Builds the lookup tables used by decodeBits from the current tree. The primary table is indexed
+		by the next DECODE_TABLE_BITS bits of input. Each entry is 32 bits:
+			bits  0-15	The decoded byte(s) (first in the low byte), or the offset of an overflow subtable.
+			bits 16-23	The number of input bits the entry consumes.
+			bits 24-25	The number of decoded bytes (1 or 2). A 0 means the entry points to a subtable instead.
+			bits 26-29	The number of bits that index the subtable (for subtable entries only).
+		Codes too long for the primary table continue in subtables (found after the primary table) that
+		hold at most DECODE_SUBTABLE_BITS bits each. Subtables can point to further subtables, so every
+		code the tree can produce (up to 255 bits) is covered.
+	*/
+	decode_table.assign(size_t(1) << DECODE_TABLE_BITS, 0);
+	buildDecodeSubtable(root_node, DECODE_TABLE_BITS, 0);
+}
+
+unsigned int HuffmanTree::subtreeHeight(uint16_t current_node)
+{
+	/*	Returns the length of the longest path from the given node down to a leaf.
+		Used to size the overflow subtables of the decoder.
+	*/
+	if (isLeaf(current_node)) return 0;				// Leaves have no height.
+	unsigned int left_height = subtreeHeight(nodes[current_node].LCH);
+	unsigned int right_height = subtreeHeight(nodes[current_node].RCH);
+	return 1 + (left_height > right_height ? left_height : right_height);
+}
+
+void HuffmanTree::buildDecodeSubtable(uint16_t table_root, unsigned int table_bits, size_t table_offset)
+{
+	/*	Fills the (sub)table starting at table_offset. Every index of the table is walked down the tree
+		from table_root, one bit at a time from the most significant bit. If a leaf is reached, the entry
+		decodes that byte. In the primary table, the leftover bits are walked again from the root, so an
+		entry can decode two short codes at once. If no leaf is reached, a new subtable is made for the
+		node we stopped on and the entry points to it.
+	*/
+	size_t table_size = size_t(1) << table_bits;
+	for (size_t index = 0; index < table_size; index++)
+	{
+		uint16_t current_node = table_root;
+		unsigned int length = 0;
+		while (length < table_bits && !isLeaf(current_node))		// Walk until we hit a leaf, or run out of bits.
+		{
+			if ((index >> (table_bits - 1 - length)) & 1) current_node = nodes[current_node].RCH;		// A 1 bit goes right, a 0 bit goes left.
+			else current_node = nodes[current_node].LCH;
+			length++;
+		}
+
+		if (!isLeaf(current_node))							// No leaf was hit, this code continues in a subtable.
+		{
+			unsigned int subtable_bits = subtreeHeight(current_node);
+			if (subtable_bits > DECODE_SUBTABLE_BITS) subtable_bits = DECODE_SUBTABLE_BITS;
+			size_t subtable_offset = decode_table.size();
+			decode_table.resize(subtable_offset + (size_t(1) << subtable_bits), 0);
+			decode_table[table_offset + index] = uint32_t(subtable_offset - (size_t(1) << DECODE_TABLE_BITS)) | (table_bits << 16) | (subtable_bits << 26);
+			buildDecodeSubtable(current_node, subtable_bits, subtable_offset);
+			continue;
+		}
+
+		uint32_t entry = current_node | (length << 16) | (1 << 24);		// A single decoded byte (a leaf's index is its byte value).
+		if (table_offset == 0)								// In the primary table, try to fit a second code in the remaining bits.
+		{
+			uint16_t second_node = root_node;
+			unsigned int second_length = length;
+			while (second_length < table_bits && !isLeaf(second_node))
+			{
+				if ((index >> (table_bits - 1 - second_length)) & 1) second_node = nodes[second_node].RCH;
+				else second_node = nodes[second_node].LCH;
+				second_length++;
+			}
+			if (isLeaf(second_node))						// The second code fit as well, so decode both bytes.
+			{
+				entry = current_node | (second_node << 8) | (second_length << 16) | (2 << 24);
+			}
+		}
+		decode_table[table_offset + index] = entry;
+	}
+}
+
+size_t HuffmanTree::decodeBits(const unsigned char* data, size_t size, size_t bit_position, bool final_block, ByteSink &file_output) const
+{
+	/*	Decodes the encoded bits of a block, starting at bit_position, and writes the bytes to the output.
+		The bits are held in a 64-bit buffer (most significant bit first) that is refilled 8 bytes at a time,
+		and each lookup of the table resolves one or two whole codes. This fast loop only runs while
+		DECODE_SAFE_BYTES remain in the block, so the refills never read past the end.
+		If this is not the final block, the position of the first undecoded bit is returned so the caller
+		can carry the rest over. Otherwise, the remaining bits are decoded by walking the tree, and any
+		padding bits at the end (a partial code) are dropped.
+		Decoded bytes are collected in a buffer on the stack, so one tree can decode on many threads at once.
+	*/
+	const unsigned char* input = data + (bit_position >> 3);			// The next byte to load into the bit buffer.
+	const unsigned char* input_limit = size > DECODE_SAFE_BYTES ? data + size - DECODE_SAFE_BYTES : data;
+	const uint32_t* primary_table = decode_table.data();
+	const uint32_t* subtables = primary_table + (size_t(1) << DECODE_TABLE_BITS);
+	unsigned char decode_output[DECODE_OUTPUT_SIZE];					// Decoded bytes are collected here before being written.
+	unsigned char* output = decode_output;
+	unsigned char* output_limit = output + DECODE_OUTPUT_SIZE - 2;		// Leave room for a two byte entry.
+
+	uint64_t bit_buffer = 0;					// The buffered bits, starting from the most significant bit.
+	unsigned int bit_count = 0;					// The number of valid bits in the buffer.
+	auto refill = [&]()
+	{
+		// Refill the buffer to at least 56 bits. The bits below the valid bits are always the next bits of input,
+		// so it is safe to OR the same bytes in again.
+		bit_buffer |= loadBigEndian64(input) >> bit_count;
+		input += (63 - bit_count) >> 3;
+		bit_count |= 56;
+	};
+
+	bool primed = input < input_limit;			// Only use the buffer if the fast loop will run at all.
+	if (primed)
+	{
+		refill();								// Prime the buffer, skipping the bits already decoded in the first byte.
+		bit_buffer <<= (bit_position & 7);
+		bit_count -= (bit_position & 7);
+	}
+	while (input < input_limit)
+	{
+		refill();
+		uint32_t entry = primary_table[bit_buffer >> (64 - DECODE_TABLE_BITS)];
+		while (((entry >> 24) & 3) == 0)		// Follow subtables until we find a decoded byte.
+		{
+			unsigned int consumed = (entry >> 16) & 0xFF;
+			bit_buffer <<= consumed;
+			bit_count -= consumed;
+			if (bit_count < 32) refill();		// Long codes can use up the buffer, so refill between subtables.
+			unsigned int subtable_bits = (entry >> 26) & 0xF;
+			entry = subtables[(entry & 0xFFFF) + (bit_buffer >> (64 - subtable_bits))];
+		}
+
+		output[0] = (unsigned char)(entry);		// Write both bytes, but only advance past the ones that were decoded.
+		output[1] = (unsigned char)(entry >> 8);
+		output += (entry >> 24) & 3;
+		unsigned int consumed = (entry >> 16) & 0xFF;
+		bit_buffer <<= consumed;
+		bit_count -= consumed;
+
+		if (output >= output_limit)				// Write out the decoded bytes once the buffer is full.
+		{
+			file_output.write(decode_output, output - decode_output);
+			output = decode_output;
+		}
+	}
+	if (primed) bit_position = size_t(input - data) * 8 - bit_count;		// Find out where the fast loop stopped.
+
+	if (final_block)
+	{
+		// Decode the last few bytes one bit at a time, just as walking the tree would.
+		uint16_t current_node = root_node;
+		size_t end_position = size * 8;
+		for (; bit_position < end_position; bit_position++)
+		{
+			if ((data[bit_position >> 3] >> (7 - (bit_position & 7))) & 1) current_node = nodes[current_node].RCH;	// If the current bit is true, we go right
+			else current_node = nodes[current_node].LCH;	// Else, we go left
+
+			if (isLeaf(current_node))					// Once we have hit a leaf (no children), we can write the byte.
+			{
+				*output++ = (unsigned char)(current_node);
+				current_node = root_node;				// Start over at the root
+				if (output >= output_limit)
+				{
+					file_output.write(decode_output, output - decode_output);
+					output = decode_output;
+				}
+			}
+		}
+	}
+	file_output.write(decode_output, output - decode_output);	// Write whatever is left in the output buffer.
+	return bit_position;
+}
+
+bool HuffmanTree::decodeStreams(const byte_span streams[], unsigned char* output, const size_t output_sizes[]) const
+{
+	/*	Decodes INTERLEAVED_STREAMS separately encoded streams, each into its own consecutive part of
+		output (output_sizes[i] bytes each). Within one stream, the start of each code depends on the
+		length of the last one, so decodeBits waits on every table lookup. Here each turn of the loop
+		takes one step in every stream, and the steps don't depend on each other, so the processor can
+		overlap their lookups. The table lookups are the same as in decodeBits. Once any stream gets
+		near the end of its input or output, the rest of each stream is finished on its own.
+		Returns false if a stream runs out of bits (or has bits left over) before its part is full.
+	*/
+	struct stream_reader
+	{
+		const unsigned char* data;				// The start of the stream's encoded bits.
+		const unsigned char* input;				// The next byte to load into the bit buffer.
+		const unsigned char* input_limit;		// Where the fast loop has to stop reading.
+		uint64_t bit_buffer;
+		unsigned int bit_count;
+		unsigned char* output;					// Where the next decoded byte goes.
+		unsigned char* output_end;				// The end of the stream's part of the output.
+	};
+	const uint32_t* primary_table = decode_table.data();
+	const uint32_t* subtables = primary_table + (size_t(1) << DECODE_TABLE_BITS);
+
+	stream_reader readers[INTERLEAVED_STREAMS];
+	unsigned char* part = output;
+	for (size_t i = 0; i < INTERLEAVED_STREAMS; i++)
+	{
+		stream_reader &reader = readers[i];
+		reader.data = streams[i].data;
+		reader.input = streams[i].data;
+		reader.input_limit = streams[i].size > DECODE_SAFE_BYTES ? streams[i].data + streams[i].size - DECODE_SAFE_BYTES : streams[i].data;
+		reader.bit_buffer = 0;
+		reader.bit_count = 0;
+		reader.output = part;
+		reader.output_end = part + output_sizes[i];
+		part += output_sizes[i];
+	}
+
+	auto refill = [](stream_reader &reader)
+	{
+		reader.bit_buffer |= loadBigEndian64(reader.input) >> reader.bit_count;
+		reader.input += (63 - reader.bit_count) >> 3;
+		reader.bit_count |= 56;
+	};
+	auto canStep = [](const stream_reader &reader)
+	{
+		// A step reads up to DECODE_SAFE_BYTES ahead and writes two bytes (even if only one is decoded).
+		return reader.input < reader.input_limit && reader.output + 1 < reader.output_end;
+	};
+	auto step = [&](stream_reader &reader)
+	{
+		refill(reader);
+		uint32_t entry = primary_table[reader.bit_buffer >> (64 - DECODE_TABLE_BITS)];
+		while (((entry >> 24) & 3) == 0)
+		{
+			unsigned int consumed = (entry >> 16) & 0xFF;
+			reader.bit_buffer <<= consumed;
+			reader.bit_count -= consumed;
+			if (reader.bit_count < 32) refill(reader);
+			unsigned int subtable_bits = (entry >> 26) & 0xF;
+			entry = subtables[(entry & 0xFFFF) + (reader.bit_buffer >> (64 - subtable_bits))];
+		}
+		reader.output[0] = (unsigned char)(entry);
+		reader.output[1] = (unsigned char)(entry >> 8);
+		reader.output += (entry >> 24) & 3;
+		unsigned int consumed = (entry >> 16) & 0xFF;
+		reader.bit_buffer <<= consumed;
+		reader.bit_count -= consumed;
+	};
+
+	bool all_ready = true;
+	for (size_t i = 0; i < INTERLEAVED_STREAMS; i++) all_ready = all_ready && canStep(readers[i]);
+	while (all_ready)							// The interleaved loop, written out so each step is independent.
+	{
+		step(readers[0]);
+		step(readers[1]);
+		step(readers[2]);
+		step(readers[3]);
+		all_ready = canStep(readers[0]) && canStep(readers[1]) && canStep(readers[2]) && canStep(readers[3]);
+	}
+
+	for (size_t i = 0; i < INTERLEAVED_STREAMS; i++)
+	{
+		stream_reader &reader = readers[i];
+		while (canStep(reader)) step(reader);	// Finish the stream on its own, as decodeBits would.
+		size_t bit_position = size_t(reader.input - reader.data) * 8 - reader.bit_count;	// Still 0 if the buffer was never filled.
+
+		uint16_t current_node = root_node;		// Walk the tree for the last few bytes, stopping once the part is full.
+		size_t end_position = streams[i].size * 8;
+		for (; bit_position < end_position && reader.output < reader.output_end; bit_position++)
+		{
+			if ((reader.data[bit_position >> 3] >> (7 - (bit_position & 7))) & 1) current_node = nodes[current_node].RCH;
+			else current_node = nodes[current_node].LCH;
+			if (isLeaf(current_node))
+			{
+				*reader.output++ = (unsigned char)(current_node);
+				current_node = root_node;
+			}
+		}
+		if (reader.output != reader.output_end || end_position - bit_position >= 8) return false;	// Only the padding of the last byte may be left.
+	}
+	return true;
+}
+
+size_t HuffmanTree::decodeCount(const unsigned char* data, size_t size, size_t &bit_position, size_t count, bool final_block, unsigned char* output) const
+{
+	/*	Decodes up to count bytes into output, starting at bit_position, and leaves bit_position just
+		after the last code decoded. Unlike decodeBits, this stops exactly after count bytes, so it can
+		find where any byte's code starts (as the checkpoints of a range index need). The fast loop is
+		the same as decodeBits', but stops with one byte to go, since a two byte entry could overshoot;
+		that byte is found by walking the tree. If this isn't the final block, decoding also stops once
+		fewer than DECODE_SAFE_BYTES remain, and the caller carries the rest over as for decodeBits.
+		Returns the number of bytes decoded.
+	*/
+	const unsigned char* input = data + (bit_position >> 3);
+	const unsigned char* input_limit = size > DECODE_SAFE_BYTES ? data + size - DECODE_SAFE_BYTES : data;
+	const uint32_t* primary_table = decode_table.data();
+	const uint32_t* subtables = primary_table + (size_t(1) << DECODE_TABLE_BITS);
+	unsigned char* next_output = output;
+	unsigned char* output_end = output + count;
+
+	uint64_t bit_buffer = 0;
+	unsigned int bit_count = 0;
+	auto refill = [&]()
+	{
+		bit_buffer |= loadBigEndian64(input) >> bit_count;
+		input += (63 - bit_count) >> 3;
+		bit_count |= 56;
+	};
+
+	bool primed = input < input_limit && count >= 2;
+	if (primed)
+	{
+		refill();
+		bit_buffer <<= (bit_position & 7);
+		bit_count -= (bit_position & 7);
+	}
+	while (input < input_limit && output_end - next_output >= 2)
+	{
+		refill();
+		uint32_t entry = primary_table[bit_buffer >> (64 - DECODE_TABLE_BITS)];
+		while (((entry >> 24) & 3) == 0)
+		{
+			unsigned int consumed = (entry >> 16) & 0xFF;
+			bit_buffer <<= consumed;
+			bit_count -= consumed;
+			if (bit_count < 32) refill();
+			unsigned int subtable_bits = (entry >> 26) & 0xF;
+			entry = subtables[(entry & 0xFFFF) + (bit_buffer >> (64 - subtable_bits))];
+		}
+		next_output[0] = (unsigned char)(entry);
+		next_output[1] = (unsigned char)(entry >> 8);
+		next_output += (entry >> 24) & 3;
+		unsigned int consumed = (entry >> 16) & 0xFF;
+		bit_buffer <<= consumed;
+		bit_count -= consumed;
+	}
+	if (primed) bit_position = size_t(input - data) * 8 - bit_count;
+
+	if (final_block || input < input_limit)		// Short of the limit, at least DECODE_SAFE_BYTES are left, enough for any code.
+	{
+		uint16_t current_node = root_node;
+		size_t end_position = size * 8;
+		for (; bit_position < end_position && next_output < output_end; bit_position++)
+		{
+			if ((data[bit_position >> 3] >> (7 - (bit_position & 7))) & 1) current_node = nodes[current_node].RCH;
+			else current_node = nodes[current_node].LCH;
+			if (isLeaf(current_node))
+			{
+				*next_output++ = (unsigned char)(current_node);
+				current_node = root_node;
+			}
+		}
+	}
+	return size_t(next_output - output);
+}
+
+void HuffmanTree::writeTables(vector<unsigned char> &tables) const
+{
+	/*	Saves everything encoding and decoding need, so readTables can load it with no building at all.
+		The tables are cached for the machine that made them, so every number is kept in its own byte
+		order (which the mark tells), and every array is saved as it is in memory, to be copied back whole:
+			4	TABLES_MAGIC, then 1 byte TABLES_VERSION and 1 byte DECODE_TABLE_BITS
+			4	TABLES_BYTE_ORDER, as a 32-bit number
+			2	node_count, then 2 root_node, then 1 byte canonical
+			510	tree_sequence, then 256 code_lengths
+			8	Each node (weight, LCH, RCH), node_count times
+			2304	The bits of each byte value's code (8 bytes each), then the lengths (1 byte each)
+			4	The number of long_code_table words, then 8 bytes each
+			4	The number of decode_table entries, then 4 bytes each
+			4	The CRC-32C (see crc32c.h) of everything before it
+	*/
+	size_t start = tables.size();
+	tables.resize(start + 6 + 4 + 5 + 510 + 256 + size_t(node_count) * sizeof(node) + 256 * 9 + 4 + long_code_table.size() * 8 + 4 + decode_table.size() * 4 + 4);
+	unsigned char* output = &tables[start];
+	auto put = [&](const void* data, size_t size)		// Copies size bytes to the output and moves past them.
+	{
+		if (size > 0) memcpy(output, data, size);
+		output += size;
+	};
+
+	unsigned char fixed[6] = { TABLES_MAGIC[0], TABLES_MAGIC[1], TABLES_MAGIC[2], TABLES_MAGIC[3], TABLES_VERSION, (unsigned char)(DECODE_TABLE_BITS) };
+	uint32_t byte_order = TABLES_BYTE_ORDER;
+	unsigned char is_canonical = canonical ? 1 : 0;
+	put(fixed, 6);
+	put(&byte_order, 4);
+	put(&node_count, 2);
+	put(&root_node, 2);
+	put(&is_canonical, 1);
+	if (canonical) memset(output, 0, 510), output += 510;	// Canonical trees have no tree_sequence, and legacy trees no code_lengths,
+	else put(tree_sequence, 510);						// so whichever the tree doesn't set is saved as 0s, and the saved tables
+	if (canonical) put(code_lengths, 256);				// are the same every time.
+	else memset(output, 0, 256), output += 256;
+	put(nodes, size_t(node_count) * sizeof(node));
+	for (int i = 0; i < 256; i++) put(&code_table[i].bits, 8);
+	for (int i = 0; i < 256; i++) *output++ = (unsigned char)(code_table[i].length);
+
+	uint32_t long_count = uint32_t(long_code_table.size()), decode_count = uint32_t(decode_table.size());
+	put(&long_count, 4);
+	put(long_code_table.data(), long_code_table.size() * 8);
+	put(&decode_count, 4);
+	put(decode_table.data(), decode_table.size() * 4);
+	uint32_t checksum = crc32c(0, &tables[start], size_t(output - &tables[start]));
+	put(&checksum, 4);
+}
+
+bool HuffmanTree::readTables(const unsigned char* tables, size_t size)
+{
+	/*	Loads the tree and tables saved by writeTables. The checksum catches a damaged or half written
+		file, so the arrays are copied back whole, and only what could send encoding or decoding outside
+		of its tables is checked: that the nodes below the root form a tree, the code lengths, and the
+		offsets of the decoder's subtables. If anything is wrong, false is returned and the tree is left reset.
+	*/
+	static_assert(sizeof(node) == 8, "Nodes are saved and loaded as they are in memory.");
+	reset();
+	if (size < 4) return false;
+	uint32_t checksum;
+	memcpy(&checksum, tables + size - 4, 4);
+	if (checksum != crc32c(0, tables, size - 4)) return false;
+	auto rejected = [&]()						// Leaves the tree reset, whatever was copied into it.
+	{
+		reset();
+		return false;
+	};
+	const unsigned char* input = tables;
+	const unsigned char* end = tables + size - 4;
+	auto take = [&](void* data, size_t count)		// Copies count bytes to data and moves past them. Returns false if there aren't enough.
+	{
+		if (size_t(end - input) < count) return false;
+		if (count > 0) memcpy(data, input, count);
+		input += count;
+		return true;
+	};
+
+	unsigned char fixed[6], is_canonical;
+	uint32_t byte_order;
+	uint16_t count, root;
+	if (!take(fixed, 6) || memcmp(fixed, TABLES_MAGIC, 4) != 0 || fixed[4] != TABLES_VERSION || fixed[5] != DECODE_TABLE_BITS) return rejected();
+	if (!take(&byte_order, 4) || byte_order != TABLES_BYTE_ORDER) return rejected();	// Made on a machine with another byte order.
+	if (!take(&count, 2) || !take(&root, 2) || !take(&is_canonical, 1) || count < 257 || count > 511 || root < 256 || root >= count) return rejected();
+	if (!take(tree_sequence, 510) || !take(code_lengths, 256) || !take(nodes, size_t(count) * sizeof(node))) return rejected();
+	canonical = is_canonical != 0;
+
+	bool reached[511] = { false };					// Every node below the root must be reached once, by one parent, so walking the tree can't loop or leave it.
+	uint16_t pending[511];
+	size_t pending_count = 0;
+	pending[pending_count++] = root;
+	reached[root] = true;
+	while (pending_count > 0)
+	{
+		uint16_t index = pending[--pending_count];
+		const node &parent = nodes[index];
+		if (isLeaf(index))
+		{
+			if (parent.LCH != NO_NODE || parent.RCH != NO_NODE) return rejected();
+			continue;
+		}
+		for (uint16_t child : { parent.LCH, parent.RCH })
+		{
+			if (child >= count || reached[child]) return rejected();
+			reached[child] = true;
+			pending[pending_count++] = child;
+		}
+	}
+
+	uint64_t code_bits[256];
+	unsigned char lengths[256];
+	if (!take(code_bits, sizeof(code_bits)) || !take(lengths, 256)) return rejected();
+	bool has_long_codes = false;
+	for (int i = 0; i < 256; i++)
+	{
+		code_table[i].bits = code_bits[i];
+		code_table[i].length = lengths[i];
+		if (lengths[i] > BitWriter::MAX_CODE_LENGTH) has_long_codes = true;
+	}
+
+	uint32_t long_count, decode_count;
+	if (!take(&long_count, 4) || long_count != (has_long_codes ? 256 * 4 : 0)) return rejected();
+	long_code_table.resize(long_count);
+	if (!take(long_code_table.data(), size_t(long_count) * 8)) return rejected();
+	size_t primary_size = size_t(1) << DECODE_TABLE_BITS;
+	if (!take(&decode_count, 4) || decode_count < primary_size || size_t(end - input) != size_t(decode_count) * 4) return rejected();
+	decode_table.resize(decode_count);
+	take(decode_table.data(), size_t(decode_count) * 4);
+	uint32_t invalid = 0;							// Checked without branching, except for the few entries that lead to a subtable.
+	const uint32_t* entries = decode_table.data();
+	for (size_t i = 0; i < decode_count; i++)
+	{
+		uint32_t entry = entries[i];
+		uint32_t consumed = (entry >> 16) & 0xFF, kind = (entry >> 24) & 3;
+		invalid |= uint32_t(consumed - 1 >= DECODE_TABLE_BITS) | uint32_t(kind == 3);
+		if (kind != 0) continue;
+		uint32_t subtable_bits = (entry >> 26) & 0xF;	// A subtable must fit in the table, and resolve at least one bit.
+		if (subtable_bits - 1 >= DECODE_SUBTABLE_BITS || primary_size + (entry & 0xFFFF) + (size_t(1) << subtable_bits) > decode_count) return rejected();
+	}
+	if (invalid != 0) return rejected();
+
+	node_count = count;
+	root_node = root;
+	packCodes();
+	return true;
+}
@@ -0,0 +1,135 @@
+//	File:			huffman_tree.h
+//	Description:	The header file for huffman_tree.cpp. A HuffmanTree holds a single Huffman tree, and the tables made
+//					from it for encoding and decoding. The Huffman class uses one for each file (or each block of a
+//					file), so blocks can be encoded and decoded on separate threads, each with its own tree.
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <climits>
+#include "fileio.h"
+#include "bitio.h"
+#include "encode_kernels.h"
+using namespace std;
+
+static const unsigned char CANONICAL_MAGIC[4] = { 0xFE, 'H', 'U', 'C' };	// The start of a canonical tree's header.
+static const unsigned char TABLES_MAGIC[4] = { 'H', 'U', 'F', 'T' };		// The start of a saved set of tables (see writeTables).
+static const unsigned char TABLES_VERSION = 2;
+static const uint32_t TABLES_BYTE_ORDER = 0x01020304;			// Saved as a number, so tables from a machine with another byte order are rebuilt.
+
+class HuffmanTree
+{
+public:
+	HuffmanTree();
+	HuffmanTree(const HuffmanTree&) = delete;				// Trees are large and meant to be reused, so they aren't copied.
+	HuffmanTree& operator=(const HuffmanTree&) = delete;
+
+	// Tree Building Functions
+	void reset();											// Clears the tree back to 256 unmerged leaves, keeping all memory for reuse.
+	void setWeights(const uint64_t counts[256]);			// Resets the tree, then sets the weight of every byte value from a table of counts.
+	void createTree();										// Creates the tree from the weights, recording the merges in the tree_sequence.
+	void createTreeByScan() { mergeByScan(0); }				// Creates the same tree with the original linear scan (kept as the reference for createTree).
+	bool rebuildTree(const unsigned char sequence[510]);	// Resets the tree and rebuilds it from a tree_sequence. Returns false if the sequence doesn't make a valid tree.
+	const unsigned char* treeSequence() const { return tree_sequence; }	// The 510 byte sequence that rebuilds this tree.
+	void createLimitedTree(unsigned int max_length);		// Creates a canonical tree from the weights, with no code longer than max_length bits.
+	bool isCanonical() const { return canonical; }			// Whether the tree is described by its code lengths instead of a tree_sequence.
+
+	// Tree Header Functions (the tree_sequence, or the code lengths of a canonical tree)
+	size_t headerSize() const;								// The size of the header that describes this tree.
+	void writeHeader(unsigned char* header) const;			// Writes the header that describes this tree.
+	bool readHeader(const unsigned char* header, size_t size);	// Resets the tree and rebuilds it from a header. Returns false if it isn't valid.
+	static size_t headerSizeFor(const unsigned char* first_bytes, size_t available);	// The size of the header that starts with the given bytes.
+
+	static const unsigned int MINIMUM_LIMITED_LENGTH = 8;	// The shortest code length limit. Every byte value gets a code, and 256 codes need at least 8 bits.
+	static const unsigned int MAXIMUM_LIMITED_LENGTH = 15;	// The longest code length limit (so a length fits in 4 bits of the header).
+	static const size_t CANONICAL_HEADER_SIZE = 4 + 128;	// CANONICAL_MAGIC, then 256 code lengths of 4 bits each.
+
+	// Encoding Functions (once the tables are built, the const functions can be used by many threads at once)
+	void createCodeTable();									// Creates the code_table by starting at the root and calling buildCodeword.
+	void encodeBytes(const unsigned char* data, size_t size, BitWriter &writer) const;	// Packs the codes for a range of bytes into the writer.
+	void padFinalByte(BitWriter &writer) const;				// Fills out the last byte of the output with bits that can't decode to anything.
+	uint64_t encodedBits(const uint64_t counts[256]) const;	// The number of bits encodeBytes would write for bytes with these counts (without encoding them).
+	void buildPairTable();									// Makes the table of merged codes for every pair of bytes, which encodeBytes then uses. Worth it for large inputs, or a tree used many times.
+	bool pairTableHelps() const { return encode_group == 1; }	// Whether encodeBytes would use a pair table (only when the kernels can't group the codes, since they are faster).
+	const uint64_t* packedCodes() const { return packed_codes; }	// The codes as the grouped kernels take them, once the code table has been made (for benchmarks of other kernels).
+	unsigned int encodeGroup() const { return encode_group; }	// How many codes the grouped kernels merge at a time (1 when they can't).
+	unsigned int codeLength(unsigned char byte_value) const { return code_table[byte_value].length; }	// The length of a byte value's code, once the code table has been made.
+	uint64_t codeBits(unsigned char byte_value) const { return code_table[byte_value].bits; }	// The bits of a byte value's code (right aligned, and only the last 64 of longer codes).
+
+	// Decoding Functions (as above)
+	void buildDecodeTable();								// Builds the table driven decoder from the tree.
+	size_t decodeBits(const unsigned char* data, size_t size, size_t bit_position, bool final_block, ByteSink &output) const;	// Decodes a block of encoded bits, returning the bit position it stopped at.
+	bool decodeStreams(const byte_span streams[], unsigned char* output, const size_t output_sizes[]) const;	// Decodes INTERLEAVED_STREAMS streams at once into consecutive parts of output. Returns false if any doesn't fill its part.
+	size_t decodeCount(const unsigned char* data, size_t size, size_t &bit_position, size_t count, bool final_block, unsigned char* output) const;	// Decodes at most count bytes from bit_position (which is moved past them), stopping exactly after the last. Returns the number decoded.
+
+	// Table Cache Functions (the tree and both sets of tables, saved so they can be loaded instead of built)
+	void writeTables(vector<unsigned char> &tables) const;	// Adds the tree and its tables to the end of tables. Both tables must have been built.
+	bool readTables(const unsigned char* tables, size_t size);	// Loads a tree and its tables from writeTables. Returns false if they aren't valid.
+
+	// Code Generation Functions (codegen.cpp)
+	string codeHeader(const string &name, const string &file_name, const string &tree_path) const;	// The text of a C++ header (file_name) with a codec for this tree in namespace name. Both tables must have been built.
+
+	static const size_t DECODE_SAFE_BYTES = 48;				// Bytes that must remain in a block for the fast decoding loop (enough for the longest possible 255 bit code, plus a refill).
+	static const size_t DECODE_BLOCK_SIZE = 1 << 20;		// The size of the blocks encoded bits are read in when the input isn't mapped.
+	static const size_t DECODE_OUTPUT_SIZE = 64 << 10;		// The size of the (stack) buffer decoded bytes are collected in before being written.
+	static const size_t INTERLEAVED_STREAMS = 4;			// The number of streams decodeStreams works through together.
+	static const size_t PAIR_TABLE_MINIMUM_INPUT = 256 << 10;	// The least input a pair table is made for. Below it, making the table takes longer than it saves.
+	static const uint64_t MAXIMUM_TOTAL_WEIGHT = UINT_MAX - 1;	// The most the weights of a tree may add up to, so that every node's weight (the root's is the sum) fits in 32 bits.
+
+private:
+	struct node
+	{
+		/*	The basis for a single 8-bit value's Huffman coding. Nodes refer to their children by
+			their index in the nodes array. The first 256 nodes are the leaves, and a leaf's index is
+			the value of the byte ("character") it codes.
+		*/
+
+		unsigned int weight;						// The weight of the node.
+		uint16_t LCH;								// The left child (NO_NODE for a leaf).
+		uint16_t RCH;								// The right child (NO_NODE for a leaf).
+	};
+	static const uint16_t NO_NODE = 0xFFFF;			// The index that stands for no node at all.
+	node nodes[511];								// Every node of the tree: 256 leaves, then the 255 merged nodes in the order they were made.
+	uint16_t node_count;							// The number of nodes in use (the next merged node goes here).
+	uint16_t root_node;								// The root node of the Huffman tree. At the end of tree building, it will be an ancestor to every possible byte value.
+	bool isLeaf(uint16_t index) const { return index < 256; }
+
+	// Tree information
+	uint16_t frequency_table[256];					// The frequency table mapping. Each row holds the node currently standing for it (NO_NODE once merged away).
+	unsigned char tree_sequence[510];				// The sequence that creates the tree for the input file. There are 510 positions, and each holds the frequency rows to be merged (from 0-255, fitting in an unsigned char).
+	bool canonical;									// Whether the tree was made from code_lengths (and is described by them).
+	unsigned char code_lengths[256];				// The code length of each byte value in a canonical tree.
+
+	// Encoding table information
+	struct codeword
+	{
+		/*	A single byte value's encoded representation, packed into an integer. */
+
+		uint64_t bits;								// The bits of the code, right aligned (the first bit of the code is the most significant). Only holds the last 64 bits of longer codes.
+		unsigned int length;						// The number of bits in the code.
+	};
+	codeword code_table[256];						// The code for each byte value. Codes are kept as integers so they can be packed straight into the output.
+	uint64_t packed_codes[256];						// The same codes for the grouped kernels (see encode_kernels.h): the bits, with the length in the high 32 bits.
+	unsigned int encode_group = 1;					// How many codes the kernels merge at a time: 4 or 2 when every code is short enough, otherwise 1 (no grouping).
+	vector<uint64_t> pair_codes;					// The merged codes of every pair of bytes (indexed by the first byte, plus the second times 256): the bits, with the length in the top byte. 0 for pairs too long to merge.
+	vector<uint64_t> long_code_table;				// Codes longer than BitWriter::MAX_CODE_LENGTH (only possible with unusual trees), 4 words per byte value with the code left aligned.
+	unsigned char code_path[255];					// The path taken from the root while building the code table (0 for left, 1 for right).
+
+	// Decoding table information
+	static const unsigned int DECODE_TABLE_BITS = 11;		// The number of bits resolved by a single lookup in the primary decoding table.
+	static const unsigned int DECODE_SUBTABLE_BITS = 8;		// The largest number of bits resolved by a lookup in an overflow subtable (used for codes longer than the primary table).
+	vector<uint32_t> decode_table;					// The primary decoding table, followed by all overflow subtables. See buildDecodeTable for the layout of an entry.
+
+	// Private Helper Functions
+	uint16_t mergeNodes(uint16_t left, uint16_t right);	// Makes a new parent node for two nodes, returning its index.
+	void limitCodeLengths(unsigned int max_length);	// Sets code_lengths from the weights with the package-merge algorithm.
+	bool buildCanonicalTree();						// Builds the tree for the canonical codes of code_lengths. Returns false if they aren't a complete code.
+	void mergeByScan(int first_merge);				// Finishes building the tree from the given merge, finding each pair of nodes with a linear scan.
+	void buildCodeword(uint16_t current_node, unsigned int depth);	// Packs the bit path of every leaf below the node into its codeword.
+	void putLongCode(BitWriter &writer, unsigned char byte_value) const;	// Writes a code that is too long for a single BitWriter::putBits.
+	void encodePairs(const unsigned char* data, size_t size, BitWriter &writer) const;	// Packs the codes of a range of bytes two at a time from pair_codes.
+	void packCodes();								// Makes packed_codes and encode_group from the code_table.
+	uint64_t codePrefix(unsigned char byte_value, unsigned int length) const;	// Returns the first bits (up to 64) of a byte value's code.
+	unsigned int subtreeHeight(uint16_t current_node);		// Finds the length of the longest path from a node down to a leaf.
+	void buildDecodeSubtable(uint16_t table_root, unsigned int table_bits, size_t table_offset);	// Fills one (sub)table of the decoder with entries that start at table_root.
+};
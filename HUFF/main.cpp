@@ -8,132 +8,388 @@
 //					and displayed to the user.
 
 #include <chrono>
+#include <sys/stat.h>
 #include "huffman.h"
+#include "batch.h"
 
 using namespace std;
 
-unsigned int getFileSize(string path)
+bool getFileSize(string path, uint64_t &size)
 {
 	/*	A method to get the file size from a given path.
 		This method  helps gives the user information on the
-		amount of compression for the files. */
+		amount of compression for the files. The size is read from the directory entry, without
+		opening the file, and only a regular file has one: opening a named pipe again would wait
+		for something to write to it. Returns false for anything else. */
 
 	// NOTE:	Because this implementation was not included in the definition of the Huffman interface,
 	//			I felt it best to include this in the 'main' file, as it interacts with the user.
 
-	ifstream file_input(path, ios::binary | ios::in);	// Construct the input stream.
-	unsigned int begin = file_input.tellg();			// Record the beginning position.
-	file_input.seekg(0, ios::end);						// Move the stream head to the end.
-	unsigned int end = file_input.tellg();				// Record the end position.
-	file_input.close();									// Close the stream.
-	return end - begin;									// Return size.
+#if defined(_WIN32)
+	struct _stat64 info;								// 64 bits, so files over 4 GB are right.
+	if (_stat64(path.c_str(), &info) != 0 || (info.st_mode & _S_IFMT) != _S_IFREG) return false;
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) return false;
+#endif
+	size = uint64_t(info.st_size);
+	return true;
 }
 
-int main(int argc, char* argv[])
+struct DecodeRange
 {
-	Huffman* HuffmanTreeEncoder = new Huffman();						// Create the encoder object to begin operations.
+	/*	The part of the decoded file that --range asks for. */
 
+	bool given = false;
+	uint64_t offset = 0;
+	uint64_t length = 0;
+};
 
-	string input_path = "";												// Initialize some variables to begin
-	string output_path = "";
+bool parseByteCount(const string &text, uint64_t &count)
+{
+	/*	Reads a number of bytes, which may end in K, M or G. Returns false if it isn't one.
+	*/
+	char* suffix;
+	if (text.empty() || text[0] < '0' || text[0] > '9') return false;
+	count = strtoull(text.c_str(), &suffix, 10);
+	if (*suffix == 'K' || *suffix == 'k') count <<= 10, suffix++;
+	else if (*suffix == 'M' || *suffix == 'm') count <<= 20, suffix++;
+	else if (*suffix == 'G' || *suffix == 'g') count <<= 30, suffix++;
+	return *suffix == '\0';
+}
+
+bool parseOptions(int &argc, char* argv[], HuffmanOptions &options, string &batch_source, DecodeRange &range, bool &estimate)
+{
+	/*	Pulls the options (arguments starting with "--") out of argv, wherever they are,
+		and records them in options. The remaining arguments are moved down so the commands
+		below can read them as before. Returns false if an option isn't recognized.
+		--batch takes the argument after it as well: the list file or directory of the batch.
+		--range is kept in range, since it isn't a setting of the encoder but a different decode.
+		--estimate is kept in estimate for the same reason: it turns -e into a prediction of its size.
+	*/
+	int kept = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		string argument = argv[i];
+		if (argument.compare(0, 2, "--") != 0)
+		{
+			argv[kept++] = argv[i];										// Not an option, keep it in place for the commands.
+		}
+		else if (argument == "--chunked")
+		{
+			options.chunked = true;
+		}
+		else if (argument == "--interleaved")
+		{
+			options.interleaved = true;
+		}
+		else if (argument == "--adaptive")
+		{
+			options.adaptive = true;
+		}
+		else if (argument == "--checksum")
+		{
+			options.checksum = true;
+		}
+		else if (argument == "--context")
+		{
+			options.context = true;
+		}
+		else if (argument.compare(0, 13, "--block-size=") == 0)
+		{
+			char* suffix;
+			unsigned long long size = strtoull(argument.c_str() + 13, &suffix, 10);
+			if (*suffix == 'K' || *suffix == 'k') size <<= 10, suffix++;	// Allow the size in kilobytes or megabytes.
+			else if (*suffix == 'M' || *suffix == 'm') size <<= 20, suffix++;
+			if (*suffix != '\0' || size < MINIMUM_BLOCK_SIZE || size > MAXIMUM_BLOCK_SIZE)
+			{
+				cerr << "The block size must be between " << (MINIMUM_BLOCK_SIZE >> 10) << "K and " << (MAXIMUM_BLOCK_SIZE >> 20) << "M. \n";
+				return false;
+			}
+			options.block_size = size_t(size);
+		}
+		else if (argument.compare(0, 13, "--max-length=") == 0)
+		{
+			options.max_code_length = (unsigned int)strtoul(argument.c_str() + 13, NULL, 10);
+			if (options.max_code_length < HuffmanTree::MINIMUM_LIMITED_LENGTH || options.max_code_length > HuffmanTree::MAXIMUM_LIMITED_LENGTH)
+			{
+				cerr << "The code length limit must be between " << HuffmanTree::MINIMUM_LIMITED_LENGTH << " and " << HuffmanTree::MAXIMUM_LIMITED_LENGTH << ". \n";
+				return false;
+			}
+		}
+		else if (argument == "--batch")
+		{
+			if (i + 1 >= argc)
+			{
+				cerr << "--batch needs a list file or a directory. \n";
+				return false;
+			}
+			batch_source = argv[++i];
+		}
+		else if (argument.compare(0, 10, "--threads=") == 0)
+		{
+			options.threads = (unsigned int)strtoul(argument.c_str() + 10, NULL, 10);
+		}
+		else if (argument.compare(0, 8, "--range=") == 0)
+		{
+			size_t colon = argument.find(':', 8);
+			if (colon == string::npos || !parseByteCount(argument.substr(8, colon - 8), range.offset) || !parseByteCount(argument.substr(colon + 1), range.length))
+			{
+				cerr << "--range needs an offset and a length, such as --range=1M:4K. \n";
+				return false;
+			}
+			range.given = true;
+		}
+		else if (argument == "--estimate")
+		{
+			estimate = true;
+		}
+		else if (argument == "--pipelined")
+		{
+			options.pipelined = true;
+		}
+		else if (argument == "--stats")
+		{
+			if (!STATS_AVAILABLE)
+			{
+				cerr << "--stats is not available, since HUFF was built with HUFF_NO_STATS. \n";
+				return false;
+			}
+			options.stats = true;
+		}
+		else
+		{
+			cerr << "Unknown option " << argument << ". Try 'HUFF -h' for help. \n";
+			return false;
+		}
+	}
+	argc = kept;
+	argv[kept] = NULL;													// The commands check for a missing argument by its NULL.
+	return true;
+}
+
+int runBatchCommand(char* argv[], const HuffmanOptions &options, const string &batch_source)
+{
+	/*	Runs -e, -d or -et (with the shared tree file after it) over every file of the batch,
+		or trains the tree file after -t from all of them, then reports the totals. Returns 1 if any file failed.
+	*/
+	BatchCommand command;
 	string tree_file = "";
+	string command_name = argv[1] == NULL ? "" : argv[1];
+	if (command_name == "-e") command = BATCH_ENCODE;
+	else if (command_name == "-d") command = BATCH_DECODE;
+	else if (command_name == "-et" && argv[2] != NULL)
+	{
+		command = BATCH_ENCODE_WITH_TREE;
+		tree_file = argv[2];
+	}
+	else if (command_name == "-t" && argv[2] != NULL)
+	{
+		command = BATCH_TRAIN;
+		tree_file = argv[2];
+	}
+	else
+	{
+		cerr << "--batch works with -e, -d, or -et or -t and a tree file. \n";
+		return 1;
+	}
 
-	auto beginTime = chrono::high_resolution_clock::now();				// Begin recording the time of the operation.
+	vector<string> paths;
+	if (!listBatchFiles(batch_source, command, paths))
+	{
+		cerr << "Batch list " << batch_source << " not accessible. Ensure the path is correct. \n";
+		return 1;
+	}
 
-	// Begin validating parameters, and make decisions on what commands to assume.
-	if (argv[1] == NULL)												// No parameters provided, exit the script.
+	BatchReport report;
+	try
 	{
-		cerr << "No parameters provided. \n";
-		exit(1);
+		report = runBatch(command, paths, options, tree_file);
+	}
+	catch (const HuffmanError &error)
+	{
+		cerr << error.what() << endl;
+		return 1;
 	}
-	else if (string(argv[1]) == "-h" || string(argv[1]) == "-?" || string(argv[1]) == "-help")	// Help command
+
+	double megabytes = double(command == BATCH_DECODE ? report.bytes_out : report.bytes_in) / 1e6;	// Throughput is measured in uncompressed bytes.
+	printf("Batch: %zu files (%zu failed). \t", report.files, report.failed);
+	printf("Time: %.6f seconds. \t", report.seconds);
+	printf("%llu bytes in / %llu bytes out \t", (unsigned long long)report.bytes_in, (unsigned long long)report.bytes_out);
+	printf("%.1f MB/s, %.0f files/s\n", megabytes / report.seconds, report.files / report.seconds);
+	if (options.stats) printf("%s\n", report.stats.json().c_str());
+	return report.failed > 0 ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+	Huffman* HuffmanTreeEncoder = new Huffman();						// Create the encoder object to begin operations.
+
+	HuffmanOptions options;
+	string batch_source = "";
+	DecodeRange range;
+	bool estimate = false;
+	HuffmanEstimate estimate_result;
+	if (!parseOptions(argc, argv, options, batch_source, range, estimate)) exit(1);	// Take out any options before looking at the command.
+	HuffmanTreeEncoder->setOptions(options);
+	if (range.given && (argv[1] == NULL || string(argv[1]) != "-d" || !batch_source.empty()))
 	{
-		HuffmanTreeEncoder->displayHelp();								// Display Help, and exit
+		cerr << "--range only works with -d, on a single file. \n";
 		exit(1);
 	}
-	else if (string(argv[1]) == "-e")									// Encode Command
+	if (estimate && (argv[1] == NULL || string(argv[1]) != "-e" || !batch_source.empty()))
 	{
-		if (argv[2] == NULL)
-		{
-			cout << "No file was provided to encode. \n";				// Exit if a file was not provided
-			exit(1);
-		} 
+		cerr << "--estimate only works with -e, on a single file. \n";
+		exit(1);
+	}
 
-		input_path = argv[2];											// Record input path
+	if (!batch_source.empty()) return runBatchCommand(argv, options, batch_source);	// Many files are handled (and reported) differently.
 
-		if (argv[3] == NULL)
-		{
-			output_path = input_path.substr(0, input_path.find('.')) += ".huf";	// If the output file was not specified, remove the extension and add ".huf"
-		}
-		else {
-			output_path = argv[3];										// Else, use the specified path
-		}
-		HuffmanTreeEncoder->EncodeFile(input_path, output_path);		// Call the function
-	}
-	else if (string(argv[1]) == "-d")
+	string input_path = "";												// Initialize some variables to begin
+	string output_path = "";
+	string tree_file = "";
+
+	auto beginTime = chrono::steady_clock::now();						// Begin recording the time of the operation.
+
+	try
 	{
-		if (argv[2] == NULL)
+		// Begin validating parameters, and make decisions on what commands to assume.
+		if (argv[1] == NULL)												// No parameters provided, exit the script.
 		{
-			cout << "No file was provided to decode. \n";				// Exit if a file was not provided
+			cerr << "No parameters provided. \n";
 			exit(1);
 		}
-		if (argv[3] == NULL)
+		else if (string(argv[1]) == "-h" || string(argv[1]) == "-?" || string(argv[1]) == "-help")	// Help command
 		{
-			cout << "No output path was specified. \n";					// Exit if a file was not provided
+			HuffmanTreeEncoder->displayHelp();								// Display Help, and exit
 			exit(1);
 		}
-		input_path = argv[2];											// Record input path
-		output_path = argv[3];											// Record output path
-		
-		HuffmanTreeEncoder->DecodeFile(input_path, output_path);		// Call the function
-	}
-	else if (string(argv[1]) == "-t")									// Build tree command
-	{
-		if (argv[2] == NULL)
+		else if (string(argv[1]) == "-e")									// Encode Command
 		{
-			cout << "No file was provided to build a tree with. \n";				// Exit if a file was not provided
-			exit(1);
+			if (argv[2] == NULL)
+			{
+				cout << "No file was provided to encode. \n";				// Exit if a file was not provided
+				exit(1);
+			} 
+
+			input_path = argv[2];											// Record input path
+
+			if (argv[3] == NULL && input_path == STANDARD_STREAM)
+			{
+				output_path = STANDARD_STREAM;								// Standard input goes to standard output, unless told otherwise
+			}
+			else if (argv[3] == NULL)
+			{
+				output_path = input_path.substr(0, input_path.find('.')) += ".huf";	// If the output file was not specified, remove the extension and add ".huf"
+			}
+			else {
+				output_path = argv[3];										// Else, use the specified path
+			}
+			if (estimate) estimate_result = HuffmanTreeEncoder->EstimateFile(input_path);	// Only predict the size, writing nothing
+			else HuffmanTreeEncoder->EncodeFile(input_path, output_path);	// Call the function
 		}
-		input_path = argv[2];
-		if (argv[3] == NULL)
+		else if (string(argv[1]) == "-d")
 		{
-			output_path = input_path.substr(0, input_path.find('.')) += ".htree";	// If the output file was not specified, remove the extension and add ".htree"
-		}
-		else {
-			output_path = argv[3];													// Else, use the specified path
+			if (argv[2] == NULL)
+			{
+				cout << "No file was provided to decode. \n";				// Exit if a file was not provided
+				exit(1);
+			}
+			if (argv[3] == NULL)
+			{
+				cout << "No output path was specified. \n";					// Exit if a file was not provided
+				exit(1);
+			}
+			input_path = argv[2];											// Record input path
+			output_path = argv[3];											// Record output path
+		
+			if (range.given) HuffmanTreeEncoder->DecodeFileRange(input_path, output_path, range.offset, range.length);	// Only the range asked for
+			else HuffmanTreeEncoder->DecodeFile(input_path, output_path);	// Call the function
 		}
-		HuffmanTreeEncoder->MakeTreeBuilder(input_path, output_path);	// Call the function
-	}
-	else if (string(argv[1]) == "-et")									// Encode with tree command
-	{
-		if (argv[2] == NULL)
+		else if (string(argv[1]) == "-t")									// Build tree command
 		{
-			cout << "No file was provided to encode with. \n";		// Exit if a file was not provided
-			exit(1);
+			if (argv[2] == NULL)
+			{
+				cout << "No file was provided to build a tree with. \n";				// Exit if a file was not provided
+				exit(1);
+			}
+			input_path = argv[2];
+			if (argv[3] == NULL)
+			{
+				output_path = input_path.substr(0, input_path.find('.')) += ".htree";	// If the output file was not specified, remove the extension and add ".htree"
+			}
+			else {
+				output_path = argv[3];													// Else, use the specified path
+			}
+			HuffmanTreeEncoder->MakeTreeBuilder(input_path, output_path);	// Call the function
 		}
-		input_path = argv[2];
-		if (argv[3] == NULL)
+		else if (string(argv[1]) == "-et")									// Encode with tree command
 		{
-			cout << "No tree file was provided to encode with \n";					// Exit if a file was not provided
-			exit(1);
+			if (argv[2] == NULL)
+			{
+				cout << "No file was provided to encode with. \n";		// Exit if a file was not provided
+				exit(1);
+			}
+			input_path = argv[2];
+			if (argv[3] == NULL)
+			{
+				cout << "No tree file was provided to encode with \n";					// Exit if a file was not provided
+				exit(1);
+			}
+			tree_file = argv[3];
+			if (argv[4] == NULL)
+			{
+				output_path = input_path.substr(0, input_path.find('.')) += ".huf";	// If the output file was not specified, remove the extension and add ".htree"
+			}
+			else {
+				output_path = argv[4];													// Else, use the specified path
+			}
+			HuffmanTreeEncoder->EncodeFileWithTree(input_path, tree_file, output_path);
 		}
-		tree_file = argv[3];
-		if (argv[4] == NULL)
+		else if (string(argv[1]) == "-g")									// Generate code for a tree command
 		{
-			output_path = input_path.substr(0, input_path.find('.')) += ".huf";	// If the output file was not specified, remove the extension and add ".htree"
+			if (argv[2] == NULL)
+			{
+				cout << "No tree file was provided to generate code for. \n";			// Exit if a file was not provided
+				exit(1);
+			}
+			input_path = argv[2];
+			if (argv[3] == NULL)
+			{
+				output_path = input_path.substr(0, input_path.find('.')) += ".h";		// If the output file was not specified, remove the extension and add ".h"
+			}
+			else {
+				output_path = argv[3];													// Else, use the specified path
+			}
+			HuffmanTreeEncoder->MakeCodeHeader(input_path, output_path);
 		}
 		else {
-			output_path = argv[4];													// Else, use the specified path
+			cout << "No valid parameters were found. Try 'HUFF -h' for help.  \n";
+			return(1);		// Break if we were not given a valid parameter
 		}
-		HuffmanTreeEncoder->EncodeFileWithTree(input_path, tree_file, output_path);
 	}
-	else {
-		cout << "No valid parameters were found. Try 'HUFF -h' for help.  \n";
-		return(1);		// Break if we were not given a valid parameter
+	catch (const HuffmanError &error)										// Any error from the encoder is shown to the user, then we quit.
+	{
+		cerr << error.what() << endl;
+		exit(1);
 	}
 
-	auto endTime = chrono::high_resolution_clock::now();											// End the clock.
-	float duration = chrono::duration_cast<chrono::milliseconds>(endTime - beginTime).count();		// Calculate the time difference
-	printf("Time: %.3f seconds. \t", duration / 1000);												// Print the time duration.
-	printf("%u bytes in / %u bytes out", getFileSize(input_path), getFileSize(output_path));		// Print the bytes in and bytes out of the operation.
+	auto endTime = chrono::steady_clock::now();														// End the clock.
+	double duration = chrono::duration<double>(endTime - beginTime).count();						// Calculate the time difference, in seconds (not rounded to milliseconds)
+	FILE* report = output_path == STANDARD_STREAM && !estimate ? stderr : stdout;					// Keep the report out of the output when it goes to standard output.
+	fprintf(report, "Time: %.6f seconds. \t", duration);												// Print the time duration.
+	if (estimate)																					// The prediction, in place of the sizes of files that weren't written.
+	{
+		fprintf(report, "%llu bytes in / %llu bytes out %s \t", (unsigned long long)estimate_result.input_bytes, (unsigned long long)estimate_result.encoded_bytes, estimate_result.exact ? "exactly" : "estimated");
+		fprintf(report, "Ratio: %.4f (standard error %.4f, confidence %.3f, %llu bytes sampled)", estimate_result.ratio, estimate_result.standard_error, estimate_result.confidence, (unsigned long long)estimate_result.sampled_bytes);
+	}
+	else if (input_path != STANDARD_STREAM && output_path != STANDARD_STREAM)							// The standard streams have no size to report...
+	{
+		uint64_t input_size = 0, output_size = 0;
+		if (getFileSize(input_path, input_size) && getFileSize(output_path, output_size))				// ...and neither do pipes or devices.
+		{
+			fprintf(report, "%llu bytes in / %llu bytes out", (unsigned long long)input_size, (unsigned long long)output_size);	// Print the bytes in and bytes out of the operation.
+		}
+	}
+	if (options.stats) fprintf(report, "\n%s\n", HuffmanTreeEncoder->stats().json().c_str());	// The time of each phase, as JSON on its own line.
 }
\ No newline at end of file
@@ -0,0 +1,65 @@
+//	File:			parallel.h
+//	Description:	A small helper for spreading independent pieces of work over several threads.
+//					Workers take the next piece from a shared counter until none are left, so uneven pieces
+//					still keep every thread busy.
+
+#pragma once
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <functional>
+using namespace std;
+
+static inline unsigned int defaultThreadCount()
+{
+	/*	The number of threads to use when none is given: one per hardware thread.
+	*/
+	unsigned int threads = thread::hardware_concurrency();
+	return threads > 0 ? threads : 1;
+}
+
+static inline void parallelFor(size_t count, unsigned int threads, const function<void(size_t)> &work)
+{
+	/*	Calls work(i) for every i from 0 to count - 1, using up to the given number of threads.
+		The calling thread does its share of the work, and this returns once every piece is done.
+	*/
+	if (threads > count) threads = (unsigned int)count;
+	if (threads <= 1)
+	{
+		for (size_t i = 0; i < count; i++) work(i);
+		return;
+	}
+
+	atomic<size_t> next_piece(0);						// The next piece of work to be taken.
+	auto worker = [&]()
+	{
+		for (size_t i = next_piece++; i < count; i = next_piece++) work(i);
+	};
+	vector<thread> workers;
+	for (unsigned int i = 1; i < threads; i++) workers.emplace_back(worker);
+	worker();
+	for (thread &t : workers) t.join();
+}
+
+static inline void parallelForWorkers(size_t count, unsigned int threads, const function<void(unsigned int, size_t)> &work)
+{
+	/*	Like parallelFor, but also tells work which worker (0 to threads - 1) is running it, so each
+		worker can keep its own state from one piece to the next.
+	*/
+	if (threads > count) threads = (unsigned int)count;
+	if (threads <= 1)
+	{
+		for (size_t i = 0; i < count; i++) work(0, i);
+		return;
+	}
+
+	atomic<size_t> next_piece(0);
+	auto worker = [&](unsigned int worker_number)
+	{
+		for (size_t i = next_piece++; i < count; i = next_piece++) work(worker_number, i);
+	};
+	vector<thread> workers;
+	for (unsigned int i = 1; i < threads; i++) workers.emplace_back(worker, i);
+	worker(0);
+	for (thread &t : workers) t.join();
+}
@@ -0,0 +1,181 @@
+//	File:			pipeline.cpp
+//	Description:	The implementation of the pipelined reader and writer (see pipeline.h). A thread that finds its
+//					ring empty yields for a moment, then sleeps, so one waiting on the disk doesn't keep
+//					a processor busy.
+
+#include "pipeline.h"
+#include <chrono>
+#include <cstring>
+
+static const size_t TOUCHED_PAGE_SIZE = 4096;		// The step pages of a mapped file are touched in (the smallest page size in use).
+
+void pipelineBackOff(unsigned int &attempts)
+{
+	/*	The other thread is usually only a moment away, so the first few waits only yield.
+		After that, the stage it is waiting on is the slow one, and sleeping costs nothing.
+	*/
+	attempts++;
+	if (attempts < 64) this_thread::yield();
+	else this_thread::sleep_for(chrono::microseconds(50));
+}
+
+PipelineReader::PipelineReader(InputFile &input_file) : input_file(input_file)
+{
+	/*	Every buffer starts out free. Mapped files are read in bigger blocks, since nothing is copied.
+	*/
+	block_size = input_file.isMapped() ? PIPELINE_MAPPED_BLOCK_SIZE : PIPELINE_BLOCK_SIZE;
+	buffers.resize(PIPELINE_DEPTH);
+	for (size_t slot = 0; slot < PIPELINE_DEPTH; slot++) free_slots.tryPush(slot);
+	reader = thread(&PipelineReader::readBlocks, this);
+}
+
+PipelineReader::~PipelineReader()
+{
+	stopping = true;
+	reader.join();
+}
+
+void PipelineReader::readBlocks()
+{
+	/*	Reads blocks for as long as there is a free buffer, until the file ends (with a block
+		shorter than the rest), or the coding thread no longer wants them.
+	*/
+	while (true)
+	{
+		size_t slot;
+		for (unsigned int attempts = 0; !free_slots.tryPop(slot); pipelineBackOff(attempts))
+		{
+			if (stopping) return;
+		}
+		byte_span span;
+		input_file.nextBlock(span, block_size, buffers[slot]);
+		if (input_file.isMapped())
+		{
+			volatile unsigned char touched = 0;				// Fault each page in here, rather than in the coding loop.
+			for (size_t i = 0; i < span.size; i += TOUCHED_PAGE_SIZE) touched += span.data[i];
+		}
+		Block block = { span.data, span.size, slot };
+		full_blocks.tryPush(block);						// There is always room, since every block in the ring holds a slot.
+		if (span.size < block_size) return;
+	}
+}
+
+bool PipelineReader::takeBlock()
+{
+	/*	Hands the current block back, then takes the next one. Waiting for it is time spent
+		on the input, so it is timed as such.
+	*/
+	if (holding)
+	{
+		free_slots.tryPush(current.slot);
+		holding = false;
+	}
+	if (at_end) return false;
+	if (!full_blocks.tryPop(current))
+	{
+		PhaseTimer io_wait(PHASE_IO);
+		for (unsigned int attempts = 0; !full_blocks.tryPop(current);) pipelineBackOff(attempts);
+	}
+	holding = true;
+	current_used = 0;
+	at_end = current.size < block_size;
+	return current.size > 0;
+}
+
+bool PipelineReader::nextBlock(byte_span &block)
+{
+	/*	Gives the next block whole. The block stays valid until the next call.
+	*/
+	if (!takeBlock()) return false;
+	block.data = current.data;
+	block.size = current.size;
+	current_used = current.size;
+	return true;
+}
+
+size_t PipelineReader::read(unsigned char* buffer, size_t size)
+{
+	/*	Copies from the current block, going on to the next ones until size bytes are copied
+		or the file ends.
+	*/
+	size_t copied = 0;
+	while (copied < size)
+	{
+		if (!holding || current_used == current.size)
+		{
+			if (!takeBlock()) break;
+		}
+		size_t piece = current.size - current_used < size - copied ? current.size - current_used : size - copied;
+		memcpy(buffer + copied, current.data + current_used, piece);
+		current_used += piece;
+		copied += piece;
+	}
+	return copied;
+}
+
+PipelineWriter::PipelineWriter(ByteSink &destination) : destination(destination)
+{
+	/*	The first buffer is the one being filled, and the rest start out free.
+	*/
+	buffers.resize(PIPELINE_DEPTH);
+	for (size_t slot = 0; slot < PIPELINE_DEPTH; slot++) buffers[slot].resize(PIPELINE_BLOCK_SIZE);
+	for (size_t slot = 1; slot < PIPELINE_DEPTH; slot++) free_slots.tryPush(slot);
+	writer = thread(&PipelineWriter::writeBlocks, this);
+}
+
+PipelineWriter::~PipelineWriter()
+{
+	finish();
+}
+
+void PipelineWriter::writeBlocks()
+{
+	/*	Writes each block as it comes, and hands its buffer back, until the empty block at the end.
+	*/
+	while (true)
+	{
+		Block block;
+		for (unsigned int attempts = 0; !full_blocks.tryPop(block);) pipelineBackOff(attempts);
+		if (block.size == 0) return;
+		destination.write(buffers[block.slot].data(), block.size);
+		free_slots.tryPush(block.slot);
+	}
+}
+
+void PipelineWriter::write(const unsigned char* data, size_t size)
+{
+	/*	Fills the current block, and passes it to the writing thread each time it is full. Waiting
+		for a free buffer is time spent on the output, so it is timed as such.
+	*/
+	while (size > 0)
+	{
+		size_t piece = PIPELINE_BLOCK_SIZE - current_size < size ? PIPELINE_BLOCK_SIZE - current_size : size;
+		memcpy(buffers[current_slot].data() + current_size, data, piece);
+		current_size += piece;
+		data += piece;
+		size -= piece;
+		if (current_size == PIPELINE_BLOCK_SIZE)
+		{
+			full_blocks.push(Block{ current_slot, current_size });
+			if (!free_slots.tryPop(current_slot))
+			{
+				PhaseTimer io_wait(PHASE_IO);
+				for (unsigned int attempts = 0; !free_slots.tryPop(current_slot);) pipelineBackOff(attempts);
+			}
+			current_size = 0;
+		}
+	}
+}
+
+void PipelineWriter::finish()
+{
+	/*	Passes on whatever is in the current block, then the empty block that stops the writing
+		thread, and waits for it. The writes end up in the destination, which still has to be closed.
+	*/
+	if (finished) return;
+	finished = true;
+	if (current_size > 0) full_blocks.push(Block{ current_slot, current_size });
+	full_blocks.push(Block{ 0, 0 });
+	PhaseTimer io_wait(PHASE_IO);
+	writer.join();
+}
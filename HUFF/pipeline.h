@@ -0,0 +1,127 @@
+//	File:			pipeline.h
+//	Description:	A reader and a writer that each run on a thread of their own, so reading the input, coding it and
+//					writing the output overlap instead of taking turns. Each is joined to the coding thread by two bounded
+//					single producer, single consumer rings: one passes full blocks along, the other passes the emptied
+//					blocks back to be used again. Nothing is locked, so a thread only waits when its ring is empty,
+//					which is when the stage before it is the slower one.
+
+#pragma once
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include "fileio.h"
+using namespace std;
+
+static const size_t PIPELINE_BLOCK_SIZE = 1 << 20;			// The size of the blocks read and written through the stream.
+static const size_t PIPELINE_MAPPED_BLOCK_SIZE = 16 << 20;	// The size of the blocks of a mapped file (big enough to count on several threads).
+static const size_t PIPELINE_DEPTH = 4;						// The number of blocks a stage can be ahead of the next one (a power of 2).
+
+void pipelineBackOff(unsigned int &attempts);				// Waits a little longer each time a ring is found empty (or full).
+
+template <class T, size_t CAPACITY>
+class SpscRing
+{
+	/*	A bounded queue between one thread that pushes and one that pops. Each index is only written
+		by one of the two threads, and is released after the item it covers, so an item is always in
+		place before the other thread can see it. CAPACITY must be a power of 2.
+	*/
+public:
+	bool tryPush(const T &item)
+	{
+		size_t tail = write_index.load(memory_order_relaxed);
+		if (tail - read_index.load(memory_order_acquire) == CAPACITY) return false;
+		items[tail & (CAPACITY - 1)] = item;
+		write_index.store(tail + 1, memory_order_release);
+		return true;
+	}
+
+	bool tryPop(T &item)
+	{
+		size_t head = read_index.load(memory_order_relaxed);
+		if (head == write_index.load(memory_order_acquire)) return false;
+		item = items[head & (CAPACITY - 1)];
+		read_index.store(head + 1, memory_order_release);
+		return true;
+	}
+
+	void push(const T &item)
+	{
+		/*	Pushes the item, waiting for room if the ring is full. */
+		for (unsigned int attempts = 0; !tryPush(item);) pipelineBackOff(attempts);
+	}
+
+private:
+	T items[CAPACITY];
+	alignas(64) atomic<size_t> write_index{ 0 };	// Only changed by the pushing thread (and kept on its own cache line).
+	alignas(64) atomic<size_t> read_index{ 0 };		// Only changed by the popping thread.
+};
+
+class PipelineReader
+{
+	/*	Reads an input file ahead of the thread coding it, from the file's position when this is made to
+		its end. Streamed files are read into PIPELINE_DEPTH buffers in turn. Mapped files are handed out
+		as spans of the mapping, but the reading thread touches each page first, so it is the one that
+		waits for the disk. The file mustn't be used any other way until this is destroyed.
+	*/
+public:
+	explicit PipelineReader(InputFile &input_file);	// Starts reading on a thread of its own.
+	~PipelineReader();								// Stops the reading thread, even partway through the file.
+	PipelineReader(const PipelineReader&) = delete;
+	PipelineReader &operator=(const PipelineReader&) = delete;
+	bool nextBlock(byte_span &block);				// Gives the next block, handing the one before back to be read into again. Returns false at the end of the file.
+	size_t read(unsigned char* buffer, size_t size);	// Copies up to size bytes of the next blocks into buffer. Returns the number copied (fewer than size only at the end).
+
+private:
+	struct Block
+	{
+		const unsigned char* data;
+		size_t size;								// Less than block_size only for the last block (which may be empty).
+		size_t slot;								// The buffer the block was read into, which is handed back once it has been used.
+	};
+
+	InputFile &input_file;
+	size_t block_size;
+	vector<vector<unsigned char>> buffers;			// The buffers blocks are read into (unused when the file is mapped).
+	SpscRing<Block, PIPELINE_DEPTH> full_blocks;	// Blocks read and waiting to be coded.
+	SpscRing<size_t, PIPELINE_DEPTH> free_slots;	// Buffers that can be read into.
+	atomic<bool> stopping{ false };					// Tells the reading thread to stop early.
+	Block current = {};								// The block being used by the coding thread.
+	size_t current_used = 0;						// The bytes of current already given out by read.
+	bool holding = false;							// Whether current is a block that hasn't been handed back yet.
+	bool at_end = false;							// Whether current is the last block.
+	thread reader;
+	void readBlocks();								// The reading thread.
+	bool takeBlock();								// Hands back current and waits for the next block. Returns false at the end.
+};
+
+class PipelineWriter : public ByteSink
+{
+	/*	Collects the output of the coding thread in blocks, and writes each full block to another sink on
+		a thread of its own. finish (or the destructor) writes the last block and waits for the rest.
+	*/
+public:
+	explicit PipelineWriter(ByteSink &destination);	// Starts the writing thread.
+	~PipelineWriter();								// Finishes, if finish wasn't called.
+	PipelineWriter(const PipelineWriter&) = delete;
+	PipelineWriter &operator=(const PipelineWriter&) = delete;
+	void write(const unsigned char* data, size_t size);	// Copies the bytes into the current block, passing it on whenever it fills.
+	void finish();									// Passes on the last block, and waits until everything has been written.
+
+private:
+	struct Block
+	{
+		size_t slot;								// The buffer holding the block.
+		size_t size;								// The bytes in the block. An empty block tells the writing thread to stop.
+	};
+
+	ByteSink &destination;
+	vector<vector<unsigned char>> buffers;
+	SpscRing<Block, PIPELINE_DEPTH * 2> full_blocks;	// Room for every buffer, and the empty block at the end.
+	SpscRing<size_t, PIPELINE_DEPTH> free_slots;
+	size_t current_slot = 0;						// The buffer being filled by write.
+	size_t current_size = 0;
+	bool finished = false;
+	thread writer;
+	void writeBlocks();								// The writing thread.
+};
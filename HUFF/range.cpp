@@ -0,0 +1,231 @@
+//	File:			range.cpp
+//	Description:	The Huffman methods that decode a range of a file's decoded bytes without decoding the rest. A single
+//					stream file is decoded from the checkpoint before the range, found in its range index (see range_index.h),
+//					which is made the first time it is needed. Container files are handled in container.cpp, through their
+//					own block index.
+
+#include "huffman.h"
+#include <sys/stat.h>
+
+static uint64_t rangeIndexHash(const unsigned char* data, size_t size, uint64_t hash = 0xCBF29CE484222325ull)
+{
+	/*	A 64-bit FNV-1a hash, for the fingerprint of a file and the checksum of its index.
+	*/
+	for (size_t i = 0; i < size; i++) hash = (hash ^ data[i]) * 0x100000001B3ull;
+	return hash;
+}
+
+static uint64_t fileFingerprint(InputFile &file_input, const vector<unsigned char> &tree_header)
+{
+	/*	A hash of the file's tree header and its last RANGE_FINGERPRINT_TAIL bytes. Along with the file's
+		size, it tells an index made for this file from one left over from an earlier file of the same name,
+		without reading the whole file. The read position is left where it was.
+	*/
+	uint64_t position = file_input.position();
+	size_t tail_size = file_input.size() < RANGE_FINGERPRINT_TAIL ? size_t(file_input.size()) : RANGE_FINGERPRINT_TAIL;
+	vector<unsigned char> tail(tail_size);
+	file_input.seek(file_input.size() - tail_size);
+	tail.resize(file_input.read(tail.data(), tail_size));
+	file_input.seek(position);
+	return rangeIndexHash(tail.data(), tail.size(), rangeIndexHash(tree_header.data(), tree_header.size()));
+}
+
+static void fileIdentity(const string &path, RangeIndex &index)
+{
+	/*	Sets the modification time and inode of the file at path in index. Writing a new file over an
+		old one changes at least one of them, even when the fingerprint can't tell them apart (such as
+		when only bytes in the middle changed). Both are left 0 if the file can't be found.
+	*/
+#if defined(_WIN32)
+	struct _stat64 info;							// Windows has no inode numbers, and keeps whole seconds.
+	if (_stat64(path.c_str(), &info) != 0) return;
+	index.modified = uint64_t(info.st_mtime);
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0) return;
+#if defined(__APPLE__)
+	index.modified = uint64_t(info.st_mtimespec.tv_sec) * 1000000000 + uint64_t(info.st_mtimespec.tv_nsec);
+#else
+	index.modified = uint64_t(info.st_mtim.tv_sec) * 1000000000 + uint64_t(info.st_mtim.tv_nsec);
+#endif
+	index.inode = uint64_t(info.st_ino);
+#endif
+}
+
+static bool readRangeIndex(const string &path, RangeIndex &index)
+{
+	/*	Loads the index kept at path, if it is undamaged and was made for the file described by index
+		(its file_size, fingerprint, modification time and inode). Returns false otherwise, leaving index as it was.
+	*/
+	InputFile index_input;
+	if (!index_input.open(path) || !index_input.isSeekable() || index_input.size() < RANGE_INDEX_HEADER_SIZE + 8) return false;
+	vector<unsigned char> saved(size_t(index_input.size()));
+	if (index_input.read(saved.data(), saved.size()) < saved.size()) return false;
+	index_input.close();
+
+	const unsigned char* header = saved.data();
+	size_t checkpoint_count = loadLittleEndian32(header + 36);
+	uint64_t interval = loadLittleEndian32(header + 32);
+	uint64_t decoded_size = loadLittleEndian64(header + 24);
+	if (memcmp(header, RANGE_INDEX_MAGIC, 4) != 0 || header[4] != RANGE_INDEX_VERSION) return false;
+	if (loadLittleEndian64(header + 8) != index.file_size || loadLittleEndian64(header + 16) != index.fingerprint) return false;
+	if (loadLittleEndian64(header + 40) != index.modified || loadLittleEndian64(header + 48) != index.inode) return false;
+	if (interval == 0 || checkpoint_count != decoded_size / interval + 1) return false;
+	if (saved.size() != RANGE_INDEX_HEADER_SIZE + checkpoint_count * 8 + 8) return false;
+	if (loadLittleEndian64(&saved[saved.size() - 8]) != rangeIndexHash(saved.data(), saved.size() - 8)) return false;
+
+	vector<uint64_t> checkpoints(checkpoint_count);
+	for (size_t i = 0; i < checkpoint_count; i++)
+	{
+		checkpoints[i] = loadLittleEndian64(header + RANGE_INDEX_HEADER_SIZE + i * 8);
+		if (checkpoints[i] > index.file_size * 8 || (i > 0 && checkpoints[i] < checkpoints[i - 1])) return false;
+	}
+	index.decoded_size = decoded_size;
+	index.interval = interval;
+	index.checkpoints.swap(checkpoints);
+	return true;
+}
+
+static void writeRangeIndex(const string &path, const RangeIndex &index)
+{
+	/*	Saves the index at path. Like the table cache, the index only saves time, so if it
+		can't be written (such as next to a file in a read-only directory) nothing is lost.
+	*/
+	vector<unsigned char> saved(RANGE_INDEX_HEADER_SIZE + index.checkpoints.size() * 8 + 8, 0);
+	memcpy(saved.data(), RANGE_INDEX_MAGIC, 4);
+	saved[4] = RANGE_INDEX_VERSION;
+	storeLittleEndian64(&saved[8], index.file_size);
+	storeLittleEndian64(&saved[16], index.fingerprint);
+	storeLittleEndian64(&saved[24], index.decoded_size);
+	storeLittleEndian32(&saved[32], uint32_t(index.interval));
+	storeLittleEndian32(&saved[36], uint32_t(index.checkpoints.size()));
+	storeLittleEndian64(&saved[40], index.modified);
+	storeLittleEndian64(&saved[48], index.inode);
+	for (size_t i = 0; i < index.checkpoints.size(); i++) storeLittleEndian64(&saved[RANGE_INDEX_HEADER_SIZE + i * 8], index.checkpoints[i]);
+	storeLittleEndian64(&saved[saved.size() - 8], rangeIndexHash(saved.data(), saved.size() - 8));
+
+	OutputFile index_output;
+	if (!index_output.open(path)) return;
+	index_output.write(saved.data(), saved.size());
+	index_output.close();
+}
+
+void Huffman::buildRangeIndex(const HuffmanTree &tree, InputFile &file_input, RangeIndex &index)
+{
+	/*	Decodes the whole stream from the read position (just after the tree header), and records the bit
+		at which every index.interval'th decoded byte starts. The stream is read in blocks, with the bytes
+		not yet decoded carried over to the next block as in DecodeFile_. The decoded bytes aren't kept.
+	*/
+	PhaseTimer timer(stats_counters.get(), PHASE_CODING);
+	const size_t read_size = HuffmanTree::DECODE_BLOCK_SIZE;
+	vector<unsigned char> input_block(read_size + 2 * HuffmanTree::DECODE_SAFE_BYTES);
+	vector<unsigned char> decoded(size_t(index.interval));
+	index.checkpoints.assign(1, 0);
+	index.decoded_size = 0;
+	uint64_t block_start = 0;					// The bit of the stream that the block starts at.
+	size_t carried_bytes = 0;
+	size_t bit_position = 0;					// The position of the next code, from the start of the block.
+	size_t to_checkpoint = size_t(index.interval);	// The bytes left to decode before the next checkpoint.
+	while (true)
+	{
+		size_t bytes_read = file_input.read(input_block.data() + carried_bytes, read_size);
+		size_t block_size = carried_bytes + bytes_read;
+		bool final_block = bytes_read < read_size;
+		while (true)
+		{
+			size_t count = tree.decodeCount(input_block.data(), block_size, bit_position, to_checkpoint, final_block, decoded.data());
+			index.decoded_size += count;
+			to_checkpoint -= count;
+			if (to_checkpoint > 0) break;			// The block ran out first.
+			index.checkpoints.push_back(block_start + bit_position);
+			to_checkpoint = size_t(index.interval);
+		}
+		if (final_block) break;
+
+		size_t first_carried = bit_position >> 3;
+		carried_bytes = block_size - first_carried;
+		memmove(input_block.data(), input_block.data() + first_carried, carried_bytes);
+		block_start += uint64_t(first_carried) * 8;
+		bit_position &= 7;
+	}
+}
+
+uint64_t Huffman::decodeRange_(InputFile &file_input, const string &input_path, ByteSink &file_output, uint64_t offset, uint64_t length)
+{
+	/*	Decodes the bytes from offset to offset + length of the decoded file (or to its end, if that
+		comes first). A single stream is decoded one checkpoint interval at a time, from the checkpoint
+		at or before offset, so at most one interval is decoded before the range starts. Its range index
+		is loaded from next to input_path, or made (and saved there, unless input_path is empty) if it
+		isn't up to date. Every interval must stop exactly at the next checkpoint. If one doesn't, the
+		index doesn't belong to this file after all, so it is made again before anything wrong is written.
+		Returns the number of encoded bytes read, for stats().
+	*/
+	if (!file_input.isSeekable())
+	{
+		throw HuffmanError("A range can only be decoded from a file that can be read more than once (not standard input or a pipe).");
+	}
+	if (isContainer(file_input)) return DecodeContainerRange_(file_input, file_output, offset, length);
+
+	vector<unsigned char> tree_header;
+	rebuildTree(file_tree, file_input, tree_header);
+	{
+		PhaseTimer timer(stats_counters.get(), PHASE_CODE_TABLES);
+		file_tree.buildDecodeTable();
+	}
+	uint64_t stream_start = file_input.position();
+	string index_path = input_path.empty() ? string() : input_path + RANGE_INDEX_EXTENSION;
+	RangeIndex index;
+	index.file_size = file_input.size();
+	index.fingerprint = fileFingerprint(file_input, tree_header);
+	if (!input_path.empty()) fileIdentity(input_path, index);
+	bool index_built = index_path.empty() || !readRangeIndex(index_path, index);
+	if (index_built)
+	{
+		buildRangeIndex(file_tree, file_input, index);
+		if (!index_path.empty()) writeRangeIndex(index_path, index);
+	}
+
+	if (offset >= index.decoded_size) return 0;
+	uint64_t end = length < index.decoded_size - offset ? offset + length : index.decoded_size;
+	PhaseTimer timer(stats_counters.get(), PHASE_CODING);
+	vector<unsigned char> encoded_buffer;		// Used only when the file isn't mapped.
+	vector<unsigned char> decoded(size_t(index.interval));
+	uint64_t bytes_read = 0;
+	size_t checkpoint = size_t(offset / index.interval);
+	uint64_t position = checkpoint * index.interval;
+	while (position < end)
+	{
+		uint64_t first_byte = stream_start + index.checkpoints[checkpoint] / 8;	// Read from the byte of the checkpoint to the byte of the next.
+		uint64_t last_byte = checkpoint + 1 < index.checkpoints.size() ? stream_start + (index.checkpoints[checkpoint + 1] + 7) / 8 : index.file_size;
+		if (last_byte > index.file_size) last_byte = index.file_size;
+		byte_span encoded;
+		file_input.seek(first_byte);
+		file_input.nextBlock(encoded, size_t(last_byte - first_byte), encoded_buffer);
+		bytes_read += encoded.size;
+
+		size_t count = index.decoded_size - position < index.interval ? size_t(index.decoded_size - position) : size_t(index.interval);
+		size_t bit_position = size_t(index.checkpoints[checkpoint] & 7);
+		bool decoded_all = file_tree.decodeCount(encoded.data, encoded.size, bit_position, count, true, decoded.data()) == count;
+		if (!decoded_all || (checkpoint + 1 < index.checkpoints.size() && (first_byte - stream_start) * 8 + bit_position != index.checkpoints[checkpoint + 1]))
+		{
+			if (index_built)
+			{
+				throw HuffmanError("Could not decode the range. The file may be damaged.");
+			}
+			file_input.seek(stream_start);			// The saved index was wrong, so make a new one and decode this interval again.
+			buildRangeIndex(file_tree, file_input, index);
+			if (!index_path.empty()) writeRangeIndex(index_path, index);
+			index_built = true;
+			if (offset >= index.decoded_size) break;
+			end = length < index.decoded_size - offset ? offset + length : index.decoded_size;
+			continue;
+		}
+		size_t range_start = position < offset ? size_t(offset - position) : 0;
+		size_t range_end = end - position < count ? size_t(end - position) : count;
+		file_output.write(decoded.data() + range_start, range_end - range_start);
+		if (stats_counters) stats_counters->addCoded(count, uint64_t(encoded.size) * 8);
+		position += index.interval;
+		checkpoint++;
+	}
+	return bytes_read;
+}
@@ -0,0 +1,49 @@
+//	File:			range_index.h
+//	Description:	The layout of the range index, a file kept next to a single stream .huf file (with RANGE_INDEX_EXTENSION
+//					added to its name) that lets a range of the decoded bytes be decoded without the rest. A single stream
+//					can only be decoded from a code boundary, so the index records the bit at which the code of every
+//					RANGE_CHECKPOINT_INTERVAL'th decoded byte starts. It is made by decoding the whole file once, the first
+//					time a range of it is asked for. Files in the block container format don't need one: their own block
+//					index (see container.h) already leads to the blocks that hold any range.
+//
+//					All numbers are little endian.
+//					Header (RANGE_INDEX_HEADER_SIZE bytes):
+//						4	RANGE_INDEX_MAGIC
+//						1	RANGE_INDEX_VERSION
+//						3	Reserved (0)
+//						8	The size of the .huf file the index was made for
+//						8	A hash of that file's tree header and its last bytes (see fileFingerprint in range.cpp)
+//						8	The number of decoded bytes in the file
+//						4	The checkpoint interval, in decoded bytes
+//						4	The number of checkpoints
+//						8	The modification time of the .huf file (in nanoseconds where the system keeps them, otherwise seconds)
+//						8	The file's inode number (0 on systems without one)
+//					Checkpoints, 8 bytes each: the bit (counted from the first bit after the tree header) at which
+//					the code of decoded byte (checkpoint number * interval) starts. The first is always 0.
+//					Checksum (8 bytes): a hash of everything before it, so a damaged index is made again.
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+static const char RANGE_INDEX_EXTENSION[] = ".hidx";	// Added to a .huf file's name for the file its range index is kept in.
+static const unsigned char RANGE_INDEX_MAGIC[4] = { 'H', 'U', 'F', 'R' };
+static const unsigned char RANGE_INDEX_VERSION = 2;
+static const size_t RANGE_INDEX_HEADER_SIZE = 56;
+static const size_t RANGE_CHECKPOINT_INTERVAL = 256 << 10;	// Decoded bytes between checkpoints: the most that is decoded (and thrown away) before a range starts.
+static const size_t RANGE_FINGERPRINT_TAIL = 4096;		// The bytes at the end of a .huf file that its fingerprint covers, besides the tree header.
+
+struct RangeIndex
+{
+	/*	The checkpoints of a single stream file, as read from (or written to) its range index. */
+
+	uint64_t file_size = 0;							// The size of the .huf file.
+	uint64_t fingerprint = 0;						// The hash of its tree header and last bytes.
+	uint64_t modified = 0;							// The file's modification time.
+	uint64_t inode = 0;								// The file's inode number.
+	uint64_t decoded_size = 0;						// The number of bytes the file decodes to.
+	uint64_t interval = RANGE_CHECKPOINT_INTERVAL;
+	vector<uint64_t> checkpoints;					// The bit offset of the code of every interval'th decoded byte.
+};
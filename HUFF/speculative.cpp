@@ -0,0 +1,131 @@
+//	File:			speculative.cpp
+//	Description:	The parallel decoder for single stream files (both the legacy tree_sequence header and the canonical
+//					one), which only mark where their first code starts. The stream is cut into chunks, and every chunk
+//					but the first is decoded from its first bit as if a code started there. That guess is usually wrong,
+//					but Huffman codes resynchronize: after a few codes, a decode that started in the wrong place starts
+//					its codes where the true decode does, and from then on both decode the same bytes. Each chunk's
+//					decode carries on past its end until one of its code starts is one of those the next chunk found,
+//					which proves where the next chunk's decode joins the true stream. The bytes the next chunk decoded
+//					before that point are dropped. A chunk that never joins within SPECULATIVE_SYNC_CODES codes is
+//					decoded again from the true stream instead, so the output is always exactly the serial decode's.
+
+#include "huffman.h"
+#include <algorithm>
+
+static const size_t SPECULATIVE_BATCH = 64 << 10;	// The bytes a chunk's output grows by, and the most decoded in one call.
+
+struct SpeculativeChunk
+{
+	/*	The state of one chunk's decode. output is only ever grown, so it is reused from round to round. */
+
+	size_t bit_position = 0;					// The start of the next code to decode.
+	vector<unsigned char> output;
+	size_t used = 0;							// The bytes of output decoded so far.
+	vector<size_t> heads;						// The start of each of the first codes decoded (heads[j] is the code of output[j]).
+	size_t skip = 0;							// The bytes at the start of output decoded before the chunk joined the true stream.
+};
+
+static void decodeOne(const HuffmanTree &tree, const unsigned char* data, size_t size, SpeculativeChunk &chunk)
+{
+	/*	Decodes the next code of the chunk by walking the tree. At the end of the stream,
+		only the padding is left and nothing is decoded.
+	*/
+	if (chunk.output.size() < chunk.used + 1) chunk.output.resize(chunk.used + SPECULATIVE_BATCH);
+	chunk.used += tree.decodeCount(data, size, chunk.bit_position, 1, true, &chunk.output[chunk.used]);
+}
+
+static void decodeUntil(const HuffmanTree &tree, const unsigned char* data, size_t size, size_t stop_position, SpeculativeChunk &chunk)
+{
+	/*	Decodes the chunk from its bit_position until a code starts at or after stop_position (or the stream ends).
+		Most of it goes through decodeCount's fast loop, which is only given the bytes up to stop_position (plus the
+		bytes it has to keep in hand), so it stops near it. The last few codes before it are decoded one at a time.
+	*/
+	size_t limit = stop_position / 8 + HuffmanTree::DECODE_SAFE_BYTES;
+	if (limit > size) limit = size;
+	while (chunk.bit_position < stop_position)
+	{
+		if (chunk.output.size() < chunk.used + SPECULATIVE_BATCH) chunk.output.resize(chunk.used + SPECULATIVE_BATCH);
+		size_t count = tree.decodeCount(data, limit, chunk.bit_position, SPECULATIVE_BATCH, limit == size, &chunk.output[chunk.used]);
+		chunk.used += count;
+		if (count > 0) continue;
+		size_t before = chunk.used;
+		decodeOne(tree, data, size, chunk);
+		if (chunk.used == before) break;		// Only padding was left.
+	}
+}
+
+static bool joinNextChunk(const HuffmanTree &tree, const unsigned char* data, size_t size, SpeculativeChunk &chunk, SpeculativeChunk &next)
+{
+	/*	Carries on decoding a chunk that is on the true stream, code by code, until one of its codes starts where
+		one of the next chunk's first codes did. The next chunk is on the true stream from that code, so the bytes
+		it decoded before it are marked to be skipped. Once the two share a code start they share every later one,
+		so checking only the codes after the chunk stopped can't miss the join. Returns false if the join isn't
+		among the next chunk's recorded codes.
+	*/
+	while (true)
+	{
+		auto found = lower_bound(next.heads.begin(), next.heads.end(), chunk.bit_position);
+		if (found == next.heads.end()) return false;
+		if (*found == chunk.bit_position)
+		{
+			next.skip = size_t(found - next.heads.begin());
+			return true;
+		}
+		size_t before = chunk.used;
+		decodeOne(tree, data, size, chunk);
+		if (chunk.used == before) return false;
+	}
+}
+
+void Huffman::decodeSpeculative_(const HuffmanTree &tree, const unsigned char* data, size_t size, ByteSink &output)
+{
+	/*	Decodes a whole single stream (data holds its bits, from its first code to its padding) with the decode
+		table already built, on thread_count threads. The stream is worked through in rounds of one chunk of
+		SPECULATIVE_CHUNK_SIZE bytes per thread, so only one round's output is held at once. Each round starts at
+		the true code start where the last one stopped. Its first chunk starts there; the others record their
+		first codes, then decode to the end of their chunk. Every chunk then joins the next (see joinNextChunk).
+		If one can't, it decodes the rest of the round itself, and the chunks after it are dropped.
+	*/
+	vector<SpeculativeChunk> chunks(thread_count);
+	size_t round_start = 0;
+	size_t end_position = size * 8;
+	while (round_start < end_position)
+	{
+		size_t first_byte = round_start / 8;
+		size_t chunk_count = (size - first_byte + SPECULATIVE_CHUNK_SIZE - 1) / SPECULATIVE_CHUNK_SIZE;
+		if (chunk_count > chunks.size()) chunk_count = chunks.size();
+		size_t round_end = first_byte + chunk_count * SPECULATIVE_CHUNK_SIZE < size ? (first_byte + chunk_count * SPECULATIVE_CHUNK_SIZE) * 8 : end_position;
+
+		parallelFor(chunk_count, thread_count, [&](size_t i)
+		{
+			SpeculativeChunk &chunk = chunks[i];
+			size_t chunk_end = i + 1 < chunk_count ? (first_byte + (i + 1) * SPECULATIVE_CHUNK_SIZE) * 8 : round_end;
+			chunk.bit_position = i == 0 ? round_start : (first_byte + i * SPECULATIVE_CHUNK_SIZE) * 8;
+			chunk.used = 0;
+			chunk.skip = 0;
+			chunk.heads.clear();
+			for (size_t j = 0; i > 0 && j < SPECULATIVE_SYNC_CODES && chunk.bit_position < chunk_end; j++)
+			{
+				size_t head = chunk.bit_position;
+				decodeOne(tree, data, size, chunk);
+				if (chunk.used == j) break;
+				chunk.heads.push_back(head);
+			}
+			decodeUntil(tree, data, size, chunk_end, chunk);
+		});
+		vector<char> joined(chunk_count, 1);
+		parallelFor(chunk_count - 1, thread_count, [&](size_t i)
+		{
+			joined[i] = joinNextChunk(tree, data, size, chunks[i], chunks[i + 1]);
+		});
+		for (size_t i = 0; i + 1 < chunk_count; i++)
+		{
+			if (joined[i]) continue;
+			decodeUntil(tree, data, size, round_end, chunks[i]);	// On the true stream, so it is right where the guesses weren't.
+			chunk_count = i + 1;
+		}
+
+		for (size_t i = 0; i < chunk_count; i++) output.write(chunks[i].output.data() + chunks[i].skip, chunks[i].used - chunks[i].skip);
+		round_start = chunks[chunk_count - 1].bit_position;
+	}
+}
@@ -0,0 +1,112 @@
+//	File:			stats.cpp
+//	Description:	The implementation of the profiling counters (see stats.h). The timer running on each thread is kept
+//					in a thread_local pointer, and each timer remembers the one it interrupted.
+
+#include "stats.h"
+#include <cstdio>
+
+double HuffmanStats::averageCodeLength() const
+{
+	/*	The bits of code per coded symbol (0 if nothing was coded).
+	*/
+	return symbols > 0 ? double(code_bits) / double(symbols) : 0;
+}
+
+double HuffmanStats::totalSeconds() const
+{
+	/*	The time of every phase together.
+	*/
+	uint64_t total = 0;
+	for (int i = 0; i < STATS_PHASES; i++) total += phase_nanoseconds[i];
+	return total / 1e9;
+}
+
+void HuffmanStats::add(const HuffmanStats &other)
+{
+	/*	Adds another set of counts to these, such as those of each worker of a batch.
+	*/
+	for (int i = 0; i < STATS_PHASES; i++) phase_nanoseconds[i] += other.phase_nanoseconds[i];
+	operations += other.operations;
+	bytes_in += other.bytes_in;
+	bytes_out += other.bytes_out;
+	symbols += other.symbols;
+	code_bits += other.code_bits;
+}
+
+string HuffmanStats::json() const
+{
+	/*	Writes the counters as one JSON object (with no line break), with the phase times in seconds.
+	*/
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer), "{\"operations\":%llu,\"bytes_in\":%llu,\"bytes_out\":%llu,\"symbols\":%llu,\"code_bits\":%llu,\"average_code_length\":%.4f,\"seconds\":{",
+		(unsigned long long)operations, (unsigned long long)bytes_in, (unsigned long long)bytes_out,
+		(unsigned long long)symbols, (unsigned long long)code_bits, averageCodeLength());
+	string result = buffer;
+	for (int i = 0; i < STATS_PHASES; i++)
+	{
+		snprintf(buffer, sizeof(buffer), "\"%s\":%.6f,", STATS_PHASE_NAMES[i], seconds(StatsPhase(i)));
+		result += buffer;
+	}
+	snprintf(buffer, sizeof(buffer), "\"total\":%.6f}}", totalSeconds());
+	return result + buffer;
+}
+
+HuffmanStats StatsCounters::snapshot() const
+{
+	/*	Copies the counters out. Counters still being added to by other threads may be
+		caught partway through, so this is best taken between operations.
+	*/
+	HuffmanStats stats;
+	for (int i = 0; i < STATS_PHASES; i++) stats.phase_nanoseconds[i] = phase_nanoseconds[i];
+	stats.operations = operations;
+	stats.bytes_in = bytes_in;
+	stats.bytes_out = bytes_out;
+	stats.symbols = symbols;
+	stats.code_bits = code_bits;
+	return stats;
+}
+
+void StatsCounters::reset()
+{
+	/*	Starts every counter again from 0.
+	*/
+	for (int i = 0; i < STATS_PHASES; i++) phase_nanoseconds[i] = 0;
+	operations = 0;
+	bytes_in = 0;
+	bytes_out = 0;
+	symbols = 0;
+	code_bits = 0;
+}
+
+#if !defined(HUFF_NO_STATS)
+static thread_local PhaseTimer* current_timer = NULL;	// The innermost timer running on this thread.
+
+PhaseTimer::PhaseTimer(StatsPhase phase)
+{
+	/*	Joins whatever is being timed on this thread. With nothing running, nothing is timed.
+	*/
+	if (current_timer != NULL) start(current_timer->counters, phase);
+}
+
+void PhaseTimer::start(StatsCounters* phase_counters, StatsPhase timed_phase)
+{
+	/*	Charges the interrupted phase with its time so far, then makes this the running timer.
+	*/
+	started = chrono::steady_clock::now();
+	counters = phase_counters;
+	phase = timed_phase;
+	outer = current_timer;
+	if (outer != NULL) outer->counters->addTime(outer->phase, uint64_t(chrono::duration_cast<chrono::nanoseconds>(started - outer->started).count()));
+	current_timer = this;
+}
+
+void PhaseTimer::stop()
+{
+	/*	Charges this phase with its time, and picks the interrupted phase up again from now.
+	*/
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	counters->addTime(phase, uint64_t(chrono::duration_cast<chrono::nanoseconds>(now - started).count()));
+	current_timer = outer;
+	if (outer != NULL) outer->started = now;
+}
+#endif
@@ -0,0 +1,104 @@
+//	File:			stats.h
+//	Description:	Optional profiling counters for the Huffman class: the time spent in each phase of encoding or decoding,
+//					and the bytes, symbols and bits of code handled. A phase is timed by a PhaseTimer, which charges the time
+//					of its thread to the innermost phase running on that thread, so a phase inside another (such as a read
+//					inside the decoding loop) is never counted twice. Defining HUFF_NO_STATS compiles the timers out entirely.
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+using namespace std;
+
+enum StatsPhase
+{
+	PHASE_FREQUENCY,								// Counting the bytes of the input.
+	PHASE_TREE,										// Making the tree from the counts (createTree), or rebuilding it from a header (rebuildTree).
+	PHASE_CODE_TABLES,								// Making the code table and the decoding tables from the tree.
+	PHASE_CODING,									// The encoding or decoding loop (including copying stored blocks).
+	PHASE_IO,										// Waiting for reads and writes. Mapped input is read by whichever phase touches it.
+	PHASE_OTHER,									// Everything else: opening files, headers, choosing block types, and waiting for other threads.
+	STATS_PHASES
+};
+
+static const char* const STATS_PHASE_NAMES[STATS_PHASES] = { "frequency", "tree", "code_tables", "coding", "io", "other" };
+
+#if defined(HUFF_NO_STATS)
+static const bool STATS_AVAILABLE = false;			// Whether the timers were compiled in.
+#else
+static const bool STATS_AVAILABLE = true;
+#endif
+
+struct HuffmanStats
+{
+	/*	The totals of the counters, as returned by Huffman::stats(). The phase times of threads working
+		in parallel are added together, so with more than one thread they can add up to more than the
+		time the work took.
+	*/
+	uint64_t phase_nanoseconds[STATS_PHASES] = {};
+	uint64_t operations = 0;						// The number of files (or buffers) encoded, decoded or trained from.
+	uint64_t bytes_in = 0;
+	uint64_t bytes_out = 0;
+	uint64_t symbols = 0;							// The bytes that were coded (stored blocks aren't).
+	uint64_t code_bits = 0;							// The bits of code for them: without headers, but with the padding at the end of each stream when decoding.
+
+	double averageCodeLength() const;				// The average number of bits per coded symbol.
+	double seconds(StatsPhase phase) const { return phase_nanoseconds[phase] / 1e9; }
+	double totalSeconds() const;					// The time of every phase together.
+	void add(const HuffmanStats &other);			// Adds the counts of other (from another Huffman) to these.
+	string json() const;							// The counters as a single line of JSON.
+};
+
+class StatsCounters
+{
+	/*	The counters a Huffman adds to while it works. They are atomic, since the blocks of a
+		file are worked on by many threads at once.
+	*/
+public:
+	void addTime(StatsPhase phase, uint64_t nanoseconds) { phase_nanoseconds[phase] += nanoseconds; }
+	void addCoded(uint64_t symbol_count, uint64_t bit_count) { symbols += symbol_count; code_bits += bit_count; }
+	void addOperation(uint64_t input_bytes, uint64_t output_bytes) { operations++; bytes_in += input_bytes; bytes_out += output_bytes; }
+	HuffmanStats snapshot() const;					// The counters as they are now.
+	void reset();									// Sets every counter back to 0.
+
+private:
+	atomic<uint64_t> phase_nanoseconds[STATS_PHASES] = {};
+	atomic<uint64_t> operations{ 0 };
+	atomic<uint64_t> bytes_in{ 0 };
+	atomic<uint64_t> bytes_out{ 0 };
+	atomic<uint64_t> symbols{ 0 };
+	atomic<uint64_t> code_bits{ 0 };
+};
+
+#if defined(HUFF_NO_STATS)
+class PhaseTimer
+{
+	/*	Does nothing, so every timer disappears when the statistics are compiled out. */
+public:
+	PhaseTimer(StatsCounters*, StatsPhase) {}
+	explicit PhaseTimer(StatsPhase) {}
+};
+#else
+class PhaseTimer
+{
+	/*	Times a phase for as long as it is in scope. While it runs, the phase it interrupted on the same
+		thread is paused, and picks up again when it ends. Timers made with no counters do nothing, so the
+		cost of leaving the statistics off is a single test.
+	*/
+public:
+	PhaseTimer(StatsCounters* counters, StatsPhase phase) { if (counters != NULL) start(counters, phase); }	// Times the phase into counters (if there are any).
+	explicit PhaseTimer(StatsPhase phase);			// Times the phase into the counters of the phase running on this thread (if any). For code, like the file layer, that has no counters of its own.
+	~PhaseTimer() { if (counters != NULL) stop(); }
+	PhaseTimer(const PhaseTimer&) = delete;
+	PhaseTimer &operator=(const PhaseTimer&) = delete;
+
+private:
+	StatsCounters* counters = NULL;
+	StatsPhase phase = PHASE_OTHER;
+	PhaseTimer* outer = NULL;						// The timer that was running on this thread when this one started.
+	chrono::steady_clock::time_point started;		// When the phase started, or last picked up again.
+	void start(StatsCounters* phase_counters, StatsPhase timed_phase);
+	void stop();
+};
+#endif
@@ -0,0 +1,92 @@
+//	File:			avx2_encode.cpp
+//	Description:	The AVX2 encoding kernel (see avx2_encode.h). It is compiled for AVX2 on its own (with a target
+//					attribute, or by MSVC as it is), and only called once the processor has been checked for it, so
+//					the rest of HUFFBENCH still runs on any x86 processor.
+
+#include "avx2_encode.h"
+#include "../HUFF/encode_kernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define AVX2_ENCODE_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
+
+bool hasAVX2()
+{
+	/*	Whether the processor has AVX2, and the operating system saves the AVX registers.
+	*/
+#if defined(AVX2_ENCODE_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) return false;	// OSXSAVE, and the XMM and YMM state enabled.
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif defined(AVX2_ENCODE_X86)
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+#if defined(AVX2_ENCODE_X86)
+AVX2_FUNCTION void encodeGroupedAVX2(const uint64_t packed_codes[256], unsigned int group_size, const unsigned char* data, size_t size, BitWriter &writer)
+{
+	/*	Looks up the bits and the lengths of the codes of 8 bytes with two 32-bit gathers. A suffix sum
+		of the lengths within each group gives how far each code is from the end of its group, and each
+		code is shifted there in a 64-bit lane, so ORing the lanes of a group merges it. Groups of 4 that
+		fit in one putBits together are added with one, which halves the writer's serial work when most
+		codes are short. The rest is finished by encodeGrouped.
+	*/
+	const int* table = (const int*)packed_codes;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		__m256i indexes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(data + i)));
+		__m256i bits = _mm256_i32gather_epi32(table, indexes, 8);
+		__m256i lengths = _mm256_i32gather_epi32(table + 1, indexes, 8);
+		__m256i after;										// The lengths of the codes after each one in its group.
+		if (group_size == 4) after = _mm256_add_epi32(_mm256_add_epi32(_mm256_srli_si256(lengths, 4), _mm256_srli_si256(lengths, 8)), _mm256_srli_si256(lengths, 12));
+		else after = _mm256_srli_epi64(lengths, 32);
+		__m256i totals = _mm256_add_epi32(after, lengths);		// The length of each group, in its first lane.
+		__m256i first_four = _mm256_sllv_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(bits)), _mm256_cvtepu32_epi64(_mm256_castsi256_si128(after)));		// Bytes 0, 1, 2, 3
+		__m256i second_four = _mm256_sllv_epi64(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(bits, 1)), _mm256_cvtepu32_epi64(_mm256_extracti128_si256(after, 1)));	// Bytes 4, 5, 6, 7
+		__m256i pairs = _mm256_or_si256(_mm256_unpacklo_epi64(first_four, second_four), _mm256_unpackhi_epi64(first_four, second_four));	// Pairs 0-1, 4-5, 2-3, 6-7
+
+		if (group_size == 4)
+		{
+			__m128i groups = _mm_or_si128(_mm256_castsi256_si128(pairs), _mm256_extracti128_si256(pairs, 1));
+			uint64_t first = (uint64_t)_mm_cvtsi128_si64(groups), second = (uint64_t)_mm_extract_epi64(groups, 1);
+			unsigned int first_length = (unsigned int)_mm256_cvtsi256_si32(totals), second_length = (unsigned int)_mm256_extract_epi32(totals, 4);
+			if (first_length + second_length <= BitWriter::MAX_CODE_LENGTH) writer.putBits((first << second_length) | second, first_length + second_length);
+			else
+			{
+				writer.putBits(first, first_length);
+				writer.putBits(second, second_length);
+			}
+		}
+		else
+		{
+			writer.putBits((uint64_t)_mm256_extract_epi64(pairs, 0), (unsigned int)_mm256_extract_epi32(totals, 0));
+			writer.putBits((uint64_t)_mm256_extract_epi64(pairs, 2), (unsigned int)_mm256_extract_epi32(totals, 2));
+			writer.putBits((uint64_t)_mm256_extract_epi64(pairs, 1), (unsigned int)_mm256_extract_epi32(totals, 4));
+			writer.putBits((uint64_t)_mm256_extract_epi64(pairs, 3), (unsigned int)_mm256_extract_epi32(totals, 6));
+		}
+	}
+	encodeGrouped(packed_codes, group_size, data + i, size - i, writer);
+}
+#else
+void encodeGroupedAVX2(const uint64_t packed_codes[256], unsigned int group_size, const unsigned char* data, size_t size, BitWriter &writer)
+{
+	/*	Never called without x86 (hasAVX2 is false), but kept so HUFFBENCH builds everywhere.
+	*/
+	encodeGrouped(packed_codes, group_size, data, size, writer);
+}
+#endif
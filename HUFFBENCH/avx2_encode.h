@@ -0,0 +1,16 @@
+//	File:			avx2_encode.h
+//	Description:	An AVX2 version of the grouped encoding kernel (see encode_kernels.h in HUFF), for HUFFBENCH encode to
+//					time against it. The codes of 8 bytes are looked up with gathers, a prefix sum of their lengths gives
+//					each code's place in its group, and vector shifts merge them. It writes exactly the same bits as the
+//					grouped kernel, but its gathers make it slower than the grouped kernel's plain loads on some
+//					processors, so HUFF doesn't use it.
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "../HUFF/bitio.h"
+
+bool hasAVX2();										// Whether the processor has AVX2, and the operating system saves the AVX registers.
+
+// Packs the codes of a range of bytes into the writer, as encodeGrouped does. Only call it when hasAVX2().
+void encodeGroupedAVX2(const uint64_t packed_codes[256], unsigned int group_size, const unsigned char* data, size_t size, BitWriter &writer);
@@ -0,0 +1,739 @@
+//	File:			bench.cpp
+//	Description:	Microbenchmarks for the parts of the Huffman coder that are too small to time from the command line.
+//					Each benchmark also checks its results against the reference implementation it replaces, and
+//					exits with an error if they differ.
+//
+//					HUFFBENCH tree [iterations]		Times building trees with createTree against the original scan.
+//					HUFFBENCH tables [iterations]		Times loading a tree's cached tables against building them from its header.
+//					HUFFBENCH encode [size]			Times each encoding kernel (see encode_kernels.h), and the AVX2 one (avx2_encode.h), checking they write the same bits.
+//					HUFFBENCH range [size]			Times decoding 4K ranges (DecodeFileRange) against decoding whole files, checking each range.
+//					HUFFBENCH speculative [size] [threads]	Times the speculative parallel decode of single stream files against the serial decode, checking they match.
+//					HUFFBENCH frozen [size]			Times the codec generated for frozen_text.h (HUFF -g) against HuffmanCode with the same tree, checking they match.
+//					HUFFBENCH checksum [size]		Times CRC-32C, and encoding and decoding blocks with and without checksums, checking damage is caught.
+//					HUFFBENCH context [size]		Compares the size and speed of blocks coded with order-1 context models against order-0 trees.
+//					HUFFBENCH corpus <dir> [max size]	Generates the benchmark corpus (see corpus.h) into a directory.
+//					HUFFBENCH suite <dir> [max size]	Times encoding, decoding and tree building over the corpus (see suite.cpp).
+
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include "../HUFF/huffman_tree.h"
+#include "../HUFF/huffman.h"
+#include "../HUFF/encode_kernels.h"
+#include "../HUFF/crc32c.h"
+#include "avx2_encode.h"
+#include "bench.h"
+#include "corpus.h"
+#include "frozen_text.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+volatile unsigned int result_sink;
+
+double secondsSince(chrono::steady_clock::time_point begin)
+{
+	/*	The time since begin, in seconds.
+	*/
+	return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+
+void resetPeakMemory()
+{
+	/*	Linux lets the peak resident size (VmHWM) be reset by writing 5 to clear_refs, so each
+		benchmark can report its own peak. Elsewhere the peak is for the whole run so far.
+	*/
+#if defined(__linux__)
+	ofstream clear_refs("/proc/self/clear_refs");
+	if (clear_refs) clear_refs << "5";
+#endif
+}
+
+uint64_t peakMemoryKB()
+{
+	/*	The peak resident (working set) size of the process, in kilobytes.
+	*/
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return counters.PeakWorkingSetSize >> 10;
+#else
+#if defined(__linux__)
+	ifstream status("/proc/self/status");			// VmHWM follows resetPeakMemory, where ru_maxrss doesn't.
+	string line;
+	while (getline(status, line))
+	{
+		if (line.compare(0, 6, "VmHWM:") == 0) return strtoull(line.c_str() + 6, NULL, 10);
+	}
+#endif
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+	return uint64_t(usage.ru_maxrss) >> 10;			// macOS gives bytes, not kilobytes.
+#else
+	return uint64_t(usage.ru_maxrss);
+#endif
+#endif
+}
+
+static void makeWeights(mt19937_64 &random, int kind, uint64_t counts[256])
+{
+	/*	Fills counts with one of the kinds of weights trees are built from:
+		0 - a small block of text (most byte values never appear, lots of ties)
+		1 - a large block of random bytes (every value appears, about equally)
+		2 - every weight the same
+		3 - a steep (Fibonacci like) distribution that makes the deepest trees
+	*/
+	memset(counts, 0, 256 * sizeof(uint64_t));
+	switch (kind)
+	{
+	case 0:
+		for (int i = 0; i < 4096; i++) counts[32 + random() % 64]++;
+		break;
+	case 1:
+		for (int i = 0; i < 256; i++) counts[i] = 1000000 + random() % 10000;
+		break;
+	case 2:
+		for (int i = 0; i < 256; i++) counts[i] = 7;
+		break;
+	default:
+		for (int i = 0; i < 256; i++) counts[i] = i < 40 ? uint64_t(1) << (i / 2) : random() % 3;
+		break;
+	}
+}
+
+int benchTree(size_t iterations)
+{
+	/*	Builds trees for each kind of weights with createTree and with the original scan,
+		checks that the tree_sequences match, and reports the time per tree.
+		The times include making the HuffmanTree, since that is paid for every block.
+	*/
+	mt19937_64 random(2510);
+	const char* kind_names[4] = { "small text", "random", "all equal", "steep" };
+	for (int kind = 0; kind < 4; kind++)
+	{
+		vector<uint64_t> weights(iterations * 256);
+		for (size_t i = 0; i < iterations; i++) makeWeights(random, kind, &weights[i * 256]);
+
+		for (size_t i = 0; i < iterations && i < 1000; i++)	// Check the merge order on a sample of the weights.
+		{
+			HuffmanTree heap_tree, scan_tree;
+			heap_tree.setWeights(&weights[i * 256]);
+			scan_tree.setWeights(&weights[i * 256]);
+			heap_tree.createTree();
+			scan_tree.createTreeByScan();
+			if (memcmp(heap_tree.treeSequence(), scan_tree.treeSequence(), 510) != 0)
+			{
+				fprintf(stderr, "tree: the tree_sequence for %s weights differs from the scan's (set %zu)\n", kind_names[kind], i);
+				return 1;
+			}
+		}
+
+		auto begin = chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++)
+		{
+			HuffmanTree tree;
+			tree.setWeights(&weights[i * 256]);
+			tree.createTree();
+			result_sink = tree.treeSequence()[508];
+		}
+		double heap_seconds = secondsSince(begin);
+
+		begin = chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++)
+		{
+			HuffmanTree tree;
+			tree.setWeights(&weights[i * 256]);
+			tree.createTreeByScan();
+			result_sink = tree.treeSequence()[508];
+		}
+		double scan_seconds = secondsSince(begin);
+
+		printf("tree\t%-10s\theap %8.0f ns/tree\tscan %8.0f ns/tree\tspeedup %.2fx\n", kind_names[kind],
+			heap_seconds * 1e9 / iterations, scan_seconds * 1e9 / iterations, scan_seconds / heap_seconds);
+	}
+	return 0;
+}
+
+int benchTables(size_t iterations)
+{
+	/*	For each kind of weights, saves the tables of a tree (a legacy one, and a canonical one limited to
+		12 bits), then times making a HuffmanCode from its header alone (building the tables) and from its
+		header and saved tables (loading them). Checks that both encode a sample the same way, and that the
+		saved tables are really used.
+	*/
+	mt19937_64 random(2510);
+	const char* kind_names[4] = { "small text", "random", "all equal", "steep" };
+	vector<unsigned char> sample(1 << 16);
+	for (unsigned char &byte : sample) byte = (unsigned char)(random() % 97);
+	for (int test = 0; test < 8; test++)
+	{
+		int kind = test / 2;
+		bool limited = test % 2 != 0;
+		uint64_t weights[256];
+		makeWeights(random, kind, weights);
+		HuffmanTree tree;
+		tree.setWeights(weights);
+		if (limited) tree.createLimitedTree(12);
+		else tree.createTree();
+		vector<unsigned char> header(tree.headerSize());
+		tree.writeHeader(header.data());
+		byte_span header_span = { header.data(), header.size() };
+		vector<unsigned char> tables = HuffmanCode(header_span).tables();
+		byte_span tables_span = { tables.data(), tables.size() };
+
+		HuffmanCode built(header_span), loaded(header_span, tables_span);
+		vector<unsigned char> built_output, loaded_output;
+		built.encode(byte_span{ sample.data(), sample.size() }, built_output);
+		loaded.encode(byte_span{ sample.data(), sample.size() }, loaded_output);
+		if (!loaded.loadedTables() || built_output != loaded_output)
+		{
+			fprintf(stderr, "tables: the loaded tables for %s weights%s don't match the built ones\n", kind_names[kind], limited ? " (limited)" : "");
+			return 1;
+		}
+
+		auto begin = chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++) result_sink = HuffmanCode(header_span).loadedTables();
+		double build_seconds = secondsSince(begin);
+
+		begin = chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++) result_sink = HuffmanCode(header_span, tables_span).loadedTables();
+		double load_seconds = secondsSince(begin);
+
+		printf("tables\t%-10s\t%-7s\t%6zu bytes\tbuild %8.0f ns\tload %8.0f ns\tspeedup %.2fx\n", kind_names[kind], limited ? "limited" : "legacy", tables.size(),
+			build_seconds * 1e9 / iterations, load_seconds * 1e9 / iterations, build_seconds / load_seconds);
+	}
+	return 0;
+}
+
+static double timeEncode(const HuffmanTree &tree, const vector<unsigned char> &data, vector<unsigned char> &output, bool avx2 = false)
+{
+	/*	Encodes data with the tree into output (replacing what was there), and returns the seconds it took.
+		With avx2, codes that can be grouped are packed by the AVX2 kernel instead of encodeBytes.
+	*/
+	output.clear();
+	output.reserve(data.size() + 64);
+	auto begin = chrono::steady_clock::now();
+	VectorSink sink(output);
+	BitWriter writer(sink, 1 << 20);
+	if (avx2 && tree.encodeGroup() > 1) encodeGroupedAVX2(tree.packedCodes(), tree.encodeGroup(), data.data(), data.size(), writer);
+	else tree.encodeBytes(data.data(), data.size(), writer);
+	tree.padFinalByte(writer);
+	writer.finish();
+	return secondsSince(begin);
+}
+
+int benchEncode(size_t size)
+{
+	/*	Encodes size bytes of each kind of corpus data with every kernel (and the AVX2 one, if this
+		processor has AVX2), with a tree of unlimited code length and one limited to 11 bits (which every
+		kernel can group by 4), then once more with the scalar kernel and a pair table (whose building is
+		timed on its own). The output of each must match the scalar kernel's exactly.
+	*/
+	vector<unsigned char> data(size);
+	vector<unsigned char> reference, output;
+	bool avx2 = hasAVX2();
+	for (int kind = 0; kind < CORPUS_KINDS; kind++)
+	{
+		CorpusGenerator generator(kind, 2510);
+		generator.fill(data.data(), data.size());
+		uint64_t counts[256] = { 0 };
+		countBytes(data.data(), data.size(), counts);
+		for (unsigned int max_length : { 0u, 11u })
+		{
+			HuffmanTree tree;
+			tree.setWeights(counts);
+			if (max_length != 0) tree.createLimitedTree(max_length);
+			else tree.createTree();
+			tree.createCodeTable();
+
+			printf("encode\t%-6s\t%-9s", CORPUS_KIND_NAMES[kind], max_length != 0 ? "limit 11" : "unlimited");
+			double scalar_seconds = 0;
+			for (int kernel = ENCODE_KERNEL_SCALAR; kernel < ENCODE_KERNELS; kernel++)
+			{
+				setEncodeKernel(EncodeKernel(kernel));
+				double seconds = timeEncode(tree, data, kernel == ENCODE_KERNEL_SCALAR ? reference : output);
+				if (kernel == ENCODE_KERNEL_SCALAR) scalar_seconds = seconds;
+				else if (output != reference)
+				{
+					fprintf(stderr, "\nencode: the %s kernel's output differs from the scalar kernel's\n", ENCODE_KERNEL_NAMES[kernel]);
+					setEncodeKernel(ENCODE_KERNEL_GROUPED);
+					return 1;
+				}
+				printf("\t%s %7.1f MB/s (%.2fx)", ENCODE_KERNEL_NAMES[kernel], data.size() / seconds / 1e6, scalar_seconds / seconds);
+			}
+			if (avx2)
+			{
+				double seconds = timeEncode(tree, data, output, true);
+				if (output != reference)
+				{
+					fprintf(stderr, "\nencode: the avx2 kernel's output differs from the scalar kernel's\n");
+					setEncodeKernel(ENCODE_KERNEL_GROUPED);
+					return 1;
+				}
+				printf("\tavx2 %7.1f MB/s (%.2fx)", data.size() / seconds / 1e6, scalar_seconds / seconds);
+			}
+
+			setEncodeKernel(ENCODE_KERNEL_SCALAR);
+			auto begin = chrono::steady_clock::now();
+			tree.buildPairTable();
+			double build_seconds = secondsSince(begin);
+			double seconds = timeEncode(tree, data, output);
+			if (output != reference)
+			{
+				fprintf(stderr, "\nencode: the pair table's output differs from the scalar kernel's\n");
+				setEncodeKernel(ENCODE_KERNEL_GROUPED);
+				return 1;
+			}
+			printf("\tpairs %7.1f MB/s (%.2fx, table %.2f ms)\n", data.size() / seconds / 1e6, scalar_seconds / seconds, build_seconds * 1000);
+		}
+	}
+	setEncodeKernel(ENCODE_KERNEL_GROUPED);
+	return 0;
+}
+
+static bool readWholeFile(const string &path, vector<unsigned char> &contents)
+{
+	/*	Reads a whole file into contents. Returns false if it can't be opened.
+	*/
+	InputFile file_input;
+	if (!file_input.open(path)) return false;
+	contents.clear();
+	byte_span block;
+	while (file_input.nextBlock(block)) contents.insert(contents.end(), block.data, block.data + block.size);
+	return true;
+}
+
+int benchRange(size_t size)
+{
+	/*	Encodes size bytes of text in each format (through temporary files in the current directory),
+		then times decoding the whole file against decoding random 4K ranges of it. Every range is
+		checked against the same bytes of the original. The first range of a single stream file also
+		makes its range index, so it is timed on its own.
+	*/
+	const size_t RANGE_LENGTH = 4 << 10;
+	const size_t LOOKUPS = 200;
+	const string input_path = "HUFFBENCH-range.bin", encoded_path = "HUFFBENCH-range.huf", output_path = "HUFFBENCH-range.out";
+	vector<unsigned char> data(size), range_output;
+	CorpusGenerator generator(CORPUS_TEXT, 2510);
+	generator.fill(data.data(), data.size());
+	OutputFile file_output;
+	if (!file_output.open(input_path))
+	{
+		fprintf(stderr, "range: %s could not be written\n", input_path.c_str());
+		return 1;
+	}
+	file_output.write(data.data(), data.size());
+	file_output.close();
+
+	const char* format_names[3] = { "single", "chunked", "adaptive" };
+	mt19937_64 random(2510);
+	int result = 0;
+	for (int format = 0; format < 3 && result == 0; format++)
+	{
+		HuffmanOptions options;
+		options.chunked = format == 1;
+		options.adaptive = options.interleaved = format == 2;
+		Huffman huffman;
+		huffman.setOptions(options);
+		huffman.EncodeFile(input_path, encoded_path);
+		remove((encoded_path + RANGE_INDEX_EXTENSION).c_str());
+
+		auto begin = chrono::steady_clock::now();
+		huffman.DecodeFile(encoded_path, output_path);
+		double whole_seconds = secondsSince(begin);
+		remove(output_path.c_str());				// So the first range doesn't pay to truncate the whole decoded file.
+
+		double first_seconds = 0, range_seconds = 0;
+		for (size_t i = 0; i <= LOOKUPS && result == 0; i++)
+		{
+			uint64_t offset = random() % (size > RANGE_LENGTH ? size - RANGE_LENGTH : 1);
+			begin = chrono::steady_clock::now();
+			huffman.DecodeFileRange(encoded_path, output_path, offset, RANGE_LENGTH);
+			if (i == 0) first_seconds = secondsSince(begin);
+			else range_seconds += secondsSince(begin);
+			size_t expected = size - offset < RANGE_LENGTH ? size_t(size - offset) : RANGE_LENGTH;
+			if (!readWholeFile(output_path, range_output) || range_output.size() != expected || memcmp(range_output.data(), data.data() + offset, expected) != 0)
+			{
+				fprintf(stderr, "range: the %s range at %llu doesn't match the original\n", format_names[format], (unsigned long long)offset);
+				result = 1;
+			}
+		}
+		range_seconds /= LOOKUPS;
+		printf("range\t%-8s\twhole file %8.2f ms\tfirst range %8.2f ms\t4K range %8.3f ms\tspeedup %.0fx\n", format_names[format],
+			whole_seconds * 1e3, first_seconds * 1e3, range_seconds * 1e3, whole_seconds / range_seconds);
+	}
+	remove(input_path.c_str());
+	remove(encoded_path.c_str());
+	remove((encoded_path + RANGE_INDEX_EXTENSION).c_str());
+	remove(output_path.c_str());
+	return result;
+}
+
+int benchSpeculative(size_t size, unsigned int threads)
+{
+	/*	Encodes size bytes of each kind of corpus data as a single stream (with a legacy tree, and a canonical
+		one limited to 11 bits), then decodes it on one thread (the serial decode) and on the given number
+		of threads (the speculative decode). The two outputs must match each other and the original.
+	*/
+	vector<unsigned char> data(size), encoded, serial_output, parallel_output;
+	for (int kind = 0; kind < CORPUS_KINDS; kind++)
+	{
+		CorpusGenerator generator(kind, 2510);
+		generator.fill(data.data(), data.size());
+		for (unsigned int max_length : { 0u, 11u })
+		{
+			HuffmanOptions options;
+			options.max_code_length = max_length;
+			options.threads = 1;
+			Huffman serial;
+			serial.setOptions(options);
+			encoded.clear();
+			serial.compress(byte_span{ data.data(), data.size() }, encoded);
+
+			serial_output.clear();
+			auto begin = chrono::steady_clock::now();
+			serial.decompress(byte_span{ encoded.data(), encoded.size() }, serial_output);
+			double serial_seconds = secondsSince(begin);
+
+			options.threads = threads;
+			Huffman parallel;
+			parallel.setOptions(options);
+			parallel_output.clear();
+			begin = chrono::steady_clock::now();
+			parallel.decompress(byte_span{ encoded.data(), encoded.size() }, parallel_output);
+			double parallel_seconds = secondsSince(begin);
+
+			if (serial_output != data || parallel_output != serial_output)
+			{
+				fprintf(stderr, "speculative: the %s decode of %s data doesn't match the serial decode\n", max_length != 0 ? "canonical" : "legacy", CORPUS_KIND_NAMES[kind]);
+				return 1;
+			}
+			printf("speculative\t%-6s\t%-9s\tserial %8.2f ms\t%u threads %8.2f ms\tspeedup %.2fx\n", CORPUS_KIND_NAMES[kind], max_length != 0 ? "canonical" : "legacy",
+				serial_seconds * 1e3, threads, parallel_seconds * 1e3, serial_seconds / parallel_seconds);
+		}
+	}
+	return 0;
+}
+
+int benchFrozen(size_t size)
+{
+	/*	Encodes and decodes size bytes of text with the codec generated into frozen_text.h (made by HUFF -g
+		from a tree trained on the same generator's text, limited to 11 bits), and with a HuffmanCode loaded
+		from the same tree header. Setting up the HuffmanCode is timed too, as the generated codec has none.
+		Both must encode to the same bits and decode back to the text. Each is timed on the second of two
+		passes, so neither pays for faulting in the output's memory.
+	*/
+	const size_t SETUPS = 200;
+	vector<unsigned char> data(size), code_encoded, frozen_encoded, code_decoded, frozen_decoded;
+	CorpusGenerator generator(CORPUS_TEXT, 2510);
+	generator.fill(data.data(), data.size());
+	byte_span tree_header = { frozen_text::TREE_HEADER, frozen_text::TREE_HEADER_SIZE };
+
+	auto begin = chrono::steady_clock::now();
+	for (size_t i = 0; i < SETUPS; i++)
+	{
+		HuffmanCode setup(tree_header);
+		result_sink += (unsigned int)(setup.header().size());
+	}
+	double setup_seconds = secondsSince(begin) / SETUPS;
+	HuffmanCode code(tree_header);
+
+	double code_encode_seconds = 0, frozen_encode_seconds = 0, code_decode_seconds = 0, frozen_decode_seconds = 0;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		code_encoded.clear();
+		frozen_encoded.clear();
+		code_decoded.clear();
+		frozen_decoded.clear();
+		begin = chrono::steady_clock::now();
+		code.encode(byte_span{ data.data(), data.size() }, code_encoded);
+		code_encode_seconds = secondsSince(begin);
+		begin = chrono::steady_clock::now();
+		frozen_text::encode(data.data(), data.size(), frozen_encoded);
+		frozen_encode_seconds = secondsSince(begin);
+		begin = chrono::steady_clock::now();
+		code.decode(byte_span{ code_encoded.data(), code_encoded.size() }, code_decoded);
+		code_decode_seconds = secondsSince(begin);
+		begin = chrono::steady_clock::now();
+		frozen_text::decode(frozen_encoded.data(), frozen_encoded.size(), frozen_decoded);
+		frozen_decode_seconds = secondsSince(begin);
+	}
+
+	if (frozen_encoded != code_encoded || code_decoded != data || frozen_decoded != data)
+	{
+		fprintf(stderr, "frozen: the generated codec doesn't match HuffmanCode\n");
+		return 1;
+	}
+	printf("frozen\tsetup    \tHuffmanCode %8.3f ms\tgenerated none\n", setup_seconds * 1e3);
+	printf("frozen\tencode   \tHuffmanCode %7.1f MB/s\tgenerated %7.1f MB/s (%.2fx)\n", size / code_encode_seconds / 1e6, size / frozen_encode_seconds / 1e6, code_encode_seconds / frozen_encode_seconds);
+	printf("frozen\tdecode   \tHuffmanCode %7.1f MB/s\tgenerated %7.1f MB/s (%.2fx)\n", size / code_decode_seconds / 1e6, size / frozen_decode_seconds / 1e6, code_decode_seconds / frozen_decode_seconds);
+	return 0;
+}
+
+int benchChecksum(size_t size)
+{
+	/*	Times crc32c (with the crc32 instruction, if the processor has it) against the table version on
+		size bytes, which must agree with each other and with the standard check value. Then encodes and
+		decodes size bytes of each kind of corpus data in blocks on one thread, with and without checksums,
+		so the overhead isn't hidden behind other threads. Each is timed as the fastest of three passes.
+		Every decode must match the original, and a checksummed file with one byte changed must not decode.
+	*/
+	const unsigned char check_input[] = "123456789";
+	vector<unsigned char> data(size), encoded, decoded;
+	CorpusGenerator random_generator(CORPUS_RANDOM, 2510);
+	random_generator.fill(data.data(), data.size());
+	double crc_seconds[2] = { 1e30, 1e30 };
+	uint32_t crcs[2] = { 0, 0 };
+	for (int pass = 0; pass < 3; pass++)
+	{
+		auto begin = chrono::steady_clock::now();
+		crcs[0] = crc32c(0, data.data(), data.size());
+		crc_seconds[0] = min(crc_seconds[0], secondsSince(begin));
+		begin = chrono::steady_clock::now();
+		crcs[1] = crc32cTable(0, data.data(), data.size());
+		crc_seconds[1] = min(crc_seconds[1], secondsSince(begin));
+	}
+	if (crcs[0] != crcs[1] || crc32c(0, check_input, 9) != 0xE3069283 || crc32cTable(0, check_input, 9) != 0xE3069283)
+	{
+		fprintf(stderr, "checksum: crc32c doesn't match the table version, or the check value\n");
+		return 1;
+	}
+	printf("checksum\tcrc32c   \t%s %8.1f MB/s\ttable %8.1f MB/s\n", crc32cHardware() ? "crc32 instruction" : "tables (no SSE4.2)", size / crc_seconds[0] / 1e6, size / crc_seconds[1] / 1e6);
+
+	for (int kind = 0; kind < CORPUS_KINDS; kind++)
+	{
+		CorpusGenerator generator(kind, 2510);
+		generator.fill(data.data(), data.size());
+		double encode_seconds[2] = { 1e30, 1e30 }, decode_seconds[2] = { 1e30, 1e30 };
+		for (int checked = 0; checked < 2; checked++)
+		{
+			HuffmanOptions options;
+			options.chunked = true;
+			options.checksum = checked != 0;
+			options.threads = 1;
+			Huffman huffman;
+			huffman.setOptions(options);
+			for (int pass = 0; pass < 3; pass++)
+			{
+				encoded.clear();
+				decoded.clear();
+				auto begin = chrono::steady_clock::now();
+				huffman.compress(byte_span{ data.data(), data.size() }, encoded);
+				encode_seconds[checked] = min(encode_seconds[checked], secondsSince(begin));
+				begin = chrono::steady_clock::now();
+				huffman.decompress(byte_span{ encoded.data(), encoded.size() }, decoded);
+				decode_seconds[checked] = min(decode_seconds[checked], secondsSince(begin));
+				if (decoded != data)
+				{
+					fprintf(stderr, "checksum: the decode of %s data doesn't match the original\n", CORPUS_KIND_NAMES[kind]);
+					return 1;
+				}
+			}
+			if (!checked) continue;
+
+			encoded[encoded.size() / 2] ^= 0x10;			// Somewhere in the middle of the blocks, far from the index.
+			bool caught = false;
+			try
+			{
+				decoded.clear();
+				huffman.decompress(byte_span{ encoded.data(), encoded.size() }, decoded);
+			}
+			catch (const HuffmanError &)
+			{
+				caught = true;
+			}
+			if (!caught)
+			{
+				fprintf(stderr, "checksum: a damaged file of %s data decoded without an error\n", CORPUS_KIND_NAMES[kind]);
+				return 1;
+			}
+		}
+		printf("checksum\t%-9s\tencode %8.1f MB/s, %8.1f MB/s checked (%+.1f%%)\tdecode %8.1f MB/s, %8.1f MB/s checked (%+.1f%%)\n", CORPUS_KIND_NAMES[kind],
+			size / encode_seconds[0] / 1e6, size / encode_seconds[1] / 1e6, (encode_seconds[1] / encode_seconds[0] - 1) * 100,
+			size / decode_seconds[0] / 1e6, size / decode_seconds[1] / 1e6, (decode_seconds[1] / decode_seconds[0] - 1) * 100);
+	}
+	return 0;
+}
+
+int benchContext(size_t size)
+{
+	/*	Encodes size bytes of each kind of corpus data in blocks on one thread, with order-0 trees (limited
+		to 11 bits, as the context models are) and with the context option, which codes each block with its
+		context model where that is smaller. Reports both sizes, and the encode and decode speeds, each the
+		fastest of three passes. Both decodes must match the original.
+	*/
+	vector<unsigned char> data(size), encoded, decoded;
+	for (int kind = 0; kind < CORPUS_KINDS; kind++)
+	{
+		CorpusGenerator generator(kind, 2510);
+		generator.fill(data.data(), data.size());
+		size_t encoded_sizes[2] = { 0, 0 };
+		double encode_seconds[2] = { 1e30, 1e30 }, decode_seconds[2] = { 1e30, 1e30 };
+		for (int context = 0; context < 2; context++)
+		{
+			HuffmanOptions options;
+			options.chunked = true;
+			options.context = context != 0;
+			options.max_code_length = ContextModel::MAXIMUM_CODE_LENGTH;
+			options.threads = 1;
+			Huffman huffman;
+			huffman.setOptions(options);
+			for (int pass = 0; pass < 3; pass++)
+			{
+				encoded.clear();
+				decoded.clear();
+				auto begin = chrono::steady_clock::now();
+				huffman.compress(byte_span{ data.data(), data.size() }, encoded);
+				encode_seconds[context] = min(encode_seconds[context], secondsSince(begin));
+				begin = chrono::steady_clock::now();
+				huffman.decompress(byte_span{ encoded.data(), encoded.size() }, decoded);
+				decode_seconds[context] = min(decode_seconds[context], secondsSince(begin));
+				if (decoded != data)
+				{
+					fprintf(stderr, "context: the %s decode of %s data doesn't match the original\n", context ? "order-1" : "order-0", CORPUS_KIND_NAMES[kind]);
+					return 1;
+				}
+			}
+			encoded_sizes[context] = encoded.size();
+		}
+		printf("context\t%-9s\tsize %10zu, %10zu order-1 (%+.1f%%)\tencode %7.1f MB/s, %7.1f MB/s order-1\tdecode %7.1f MB/s, %7.1f MB/s order-1 (%.2fx the time)\n", CORPUS_KIND_NAMES[kind],
+			encoded_sizes[0], encoded_sizes[1], (double(encoded_sizes[1]) / encoded_sizes[0] - 1) * 100, size / encode_seconds[0] / 1e6, size / encode_seconds[1] / 1e6,
+			size / decode_seconds[0] / 1e6, size / decode_seconds[1] / 1e6, decode_seconds[1] / decode_seconds[0]);
+	}
+	return 0;
+}
+
+int benchEstimate(size_t size)
+{
+	/*	Estimates the encoded size of size bytes of each kind of corpus data, and of its first 1M (which is
+		counted in full), then encodes it, as a single stream, in blocks, and in blocks with the context option.
+		Reports the predicted and real sizes, the estimate's confidence, and how much faster it was than the
+		encode (each the fastest of three passes). An estimate that says it is exact must match the size.
+	*/
+	static const char* const MODE_NAMES[3] = { "stream", "chunked", "context" };
+	vector<unsigned char> data(size), encoded;
+	for (int kind = 0; kind < CORPUS_KINDS; kind++)
+	{
+		CorpusGenerator generator(kind, 2510);
+		generator.fill(data.data(), data.size());
+		for (int mode = 0; mode < 3; mode++)
+		{
+			HuffmanOptions options;
+			options.chunked = mode > 0;
+			options.context = mode == 2;
+			Huffman huffman;
+			huffman.setOptions(options);
+			size_t sizes[2] = { min(size, size_t(1) << 20), size };
+			for (size_t full_size : sizes)
+			{
+				byte_span input = { data.data(), full_size };
+				HuffmanEstimate estimate;
+				double estimate_seconds = 1e30, encode_seconds = 1e30;
+				for (int pass = 0; pass < 3; pass++)
+				{
+					auto begin = chrono::steady_clock::now();
+					estimate = huffman.estimate(input);
+					estimate_seconds = min(estimate_seconds, secondsSince(begin));
+					encoded.clear();
+					begin = chrono::steady_clock::now();
+					huffman.compress(input, encoded);
+					encode_seconds = min(encode_seconds, secondsSince(begin));
+				}
+				if (estimate.exact && estimate.encoded_bytes != encoded.size())
+				{
+					fprintf(stderr, "estimate: the exact %s estimate of %zu bytes of %s data is %llu bytes, but %zu were written\n", MODE_NAMES[mode], full_size, CORPUS_KIND_NAMES[kind],
+						(unsigned long long)estimate.encoded_bytes, encoded.size());
+					return 1;
+				}
+				double real_ratio = double(encoded.size()) / full_size;
+				printf("estimate\t%-9s\t%-7s %10zu bytes\tratio %.4f, %.4f real (%+.4f)\terror %.4f, confidence %.3f%s\t%8.1fx faster than encoding\n", CORPUS_KIND_NAMES[kind], MODE_NAMES[mode], full_size,
+					estimate.ratio, real_ratio, estimate.ratio - real_ratio, estimate.standard_error, estimate.confidence, estimate.exact ? " (exact)" : "", encode_seconds / estimate_seconds);
+			}
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: HUFFBENCH tree [iterations]\n"
+			"       HUFFBENCH tables [iterations]\n"
+			"       HUFFBENCH encode [size]\n"
+			"       HUFFBENCH range [size]\n"
+			"       HUFFBENCH speculative [size] [threads]\n"
+			"       HUFFBENCH frozen [size]\n"
+			"       HUFFBENCH checksum [size]\n"
+			"       HUFFBENCH context [size]\n"
+			"       HUFFBENCH estimate [size]\n"
+			"       HUFFBENCH corpus <directory> [max size]\n"
+			"       HUFFBENCH suite <directory> [max size] [--chunked] [--interleaved] [--adaptive] [--checksum] [--context] [--threads=N] [--max-length=N] [--label=NAME]\n");
+		return 1;
+	}
+	string benchmark = argv[1];
+	if (benchmark == "tree") return benchTree(argc > 2 ? strtoul(argv[2], NULL, 10) : 20000);
+	if (benchmark == "tables") return benchTables(argc > 2 ? strtoul(argv[2], NULL, 10) : 2000);
+	if (benchmark == "encode")
+	{
+		uint64_t size = 64 << 20;
+		if (argc > 2 && !parseSize(argv[2], size)) return 1;
+		return benchEncode(size_t(size));
+	}
+	if (benchmark == "range")
+	{
+		uint64_t size = 64 << 20;
+		if (argc > 2 && !parseSize(argv[2], size)) return 1;
+		return benchRange(size_t(size));
+	}
+	if (benchmark == "speculative")
+	{
+		uint64_t size = 64 << 20;
+		if (argc > 2 && !parseSize(argv[2], size)) return 1;
+		unsigned int threads = argc > 3 ? (unsigned int)strtoul(argv[3], NULL, 10) : defaultThreadCount();
+		return benchSpeculative(size_t(size), threads > 1 ? threads : 2);
+	}
+	if (benchmark == "frozen")
+	{
+		uint64_t size = 64 << 20;
+		if (argc > 2 && !parseSize(argv[2], size)) return 1;
+		return benchFrozen(size_t(size));
+	}
+	if (benchmark == "checksum")
+	{
+		uint64_t size = 64 << 20;
+		if (argc > 2 && !parseSize(argv[2], size)) return 1;
+		return benchChecksum(size_t(size));
+	}
+	if (benchmark == "context")
+	{
+		uint64_t size = 64 << 20;
+		if (argc > 2 && !parseSize(argv[2], size)) return 1;
+		return benchContext(size_t(size));
+	}
+	if (benchmark == "estimate")
+	{
+		uint64_t size = 64 << 20;
+		if (argc > 2 && !parseSize(argv[2], size)) return 1;
+		return benchEstimate(size_t(size));
+	}
+	if (benchmark == "corpus") return benchCorpus(argc - 2, argv + 2);
+	if (benchmark == "suite") return benchSuite(argc - 2, argv + 2);
+
+	fprintf(stderr, "Unknown benchmark %s.\n", argv[1]);
+	return 1;
+}
@@ -0,0 +1,26 @@
+//	File:			bench.h
+//	Description:	The helpers shared by the benchmarks: timing, peak memory, and the entry point of each benchmark.
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+using namespace std;
+
+extern volatile unsigned int result_sink;				// Results are stored here so the work can't be optimized away.
+
+double secondsSince(chrono::steady_clock::time_point begin);	// The time since begin, in seconds.
+void resetPeakMemory();									// Starts measuring the peak memory again from the current use (where the system allows it).
+uint64_t peakMemoryKB();								// The most memory the process has had resident since resetPeakMemory, in kilobytes.
+
+int benchTree(size_t iterations);						// HUFFBENCH tree [iterations]
+int benchTables(size_t iterations);						// HUFFBENCH tables [iterations]
+int benchEncode(size_t size);							// HUFFBENCH encode [size]
+int benchRange(size_t size);							// HUFFBENCH range [size]
+int benchSpeculative(size_t size, unsigned int threads);	// HUFFBENCH speculative [size] [threads]
+int benchFrozen(size_t size);							// HUFFBENCH frozen [size]
+int benchChecksum(size_t size);							// HUFFBENCH checksum [size]
+int benchContext(size_t size);							// HUFFBENCH context [size]
+int benchEstimate(size_t size);							// HUFFBENCH estimate [size]
+int benchCorpus(int argc, char* argv[]);				// HUFFBENCH corpus <directory> [max size]
+int benchSuite(int argc, char* argv[]);					// HUFFBENCH suite <directory> [max size] [options]
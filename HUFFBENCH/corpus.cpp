@@ -0,0 +1,201 @@
+//	File:			corpus.cpp
+//	Description:	Generates the benchmark corpus described in corpus.h, writing each file a buffer at a time
+//					so files far larger than memory can be made.
+
+#include "corpus.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include "../HUFF/fileio.h"
+
+const char* const CORPUS_KIND_NAMES[CORPUS_KINDS] = { "random", "zipf", "text", "single" };
+
+static void fillZipfTable(size_t symbols, double exponent, mt19937_64 &random, vector<size_t> &table)
+{
+	/*	Fills a 64K entry table with symbol numbers, each taking a share of the entries in proportion to
+		1 / rank^exponent. The ranks are shuffled, so the most common symbols aren't simply the lowest.
+		Every symbol gets at least one entry.
+	*/
+	vector<size_t> ranks(symbols);
+	for (size_t i = 0; i < symbols; i++) ranks[i] = i;
+	shuffle(ranks.begin(), ranks.end(), random);
+
+	double total = 0;
+	for (size_t i = 0; i < symbols; i++) total += 1 / pow(double(i + 1), exponent);
+	size_t spare = 65536 - symbols;						// Entries left after every symbol has its one.
+	table.clear();
+	for (size_t i = 0; i < symbols; i++)
+	{
+		size_t share = 1 + size_t(spare / pow(double(i + 1), exponent) / total);
+		table.insert(table.end(), share, ranks[i]);
+	}
+	table.resize(65536, ranks[0]);						// Rounding leaves a few entries, which go to the most common symbol.
+}
+
+CorpusGenerator::CorpusGenerator(int kind, uint64_t seed) : kind(kind), random(seed)
+{
+	/*	Sets up the tables for the kind of data. */
+	vector<size_t> table;
+	if (kind == CORPUS_ZIPF)
+	{
+		fillZipfTable(256, 1.2, random, table);
+		zipf_table.assign(table.begin(), table.end());
+	}
+	else if (kind == CORPUS_TEXT)
+	{
+		const char letters[] = "eeeeeeeeeeeetttttttttaaaaaaaaoooooooiiiiiiinnnnnnnsssssshhhhhhrrrrrrddddllllcccuuummmwwffggyyppbbvkjxqz";
+		words.resize(4096);
+		for (size_t i = 0; i < words.size(); i++)		// Short words are the common ones, as in real text.
+		{
+			size_t length = 1 + (i < 64 ? random() % 3 : random() % 9);
+			for (size_t j = 0; j < length; j++) words[i] += letters[random() % (sizeof(letters) - 1)];
+		}
+		fillZipfTable(words.size(), 1.0, random, table);
+		sort(table.begin(), table.end());				// Undo the shuffle so the common words are the short ones.
+		word_table.assign(table.begin(), table.end());
+	}
+}
+
+void CorpusGenerator::makeText()
+{
+	/*	Adds one sentence to pending: a capitalized run of words, some commas,
+		a full stop, and a line break once the line is long enough.
+	*/
+	pending.erase(0, pending_used);
+	pending_used = 0;
+	size_t word_count = 3 + random() % 15;
+	for (size_t i = 0; i < word_count; i++)
+	{
+		uint64_t bits = random();
+		string word = words[word_table[bits & 0xFFFF]];
+		if (i == 0) word[0] = char(word[0] - 'a' + 'A');
+		pending += word;
+		line_length += word.size() + 1;
+		if (i + 1 == word_count) pending += '.';
+		else if ((bits >> 16) % 10 == 0) pending += ',';
+		if (line_length > 72)
+		{
+			pending += '\n';
+			line_length = 0;
+		}
+		else pending += ' ';
+	}
+}
+
+void CorpusGenerator::fill(unsigned char* buffer, size_t size)
+{
+	/*	Fills the buffer with the next size bytes of the data. */
+	size_t filled = 0;
+	switch (kind)
+	{
+	case CORPUS_RANDOM:
+		while (filled < size)
+		{
+			uint64_t bits = random();
+			size_t count = size - filled < 8 ? size - filled : 8;
+			memcpy(buffer + filled, &bits, count);
+			filled += count;
+		}
+		break;
+	case CORPUS_ZIPF:
+		while (filled < size)
+		{
+			uint64_t bits = random();					// Four bytes from each 64 bit random number.
+			for (int i = 0; i < 4 && filled < size; i++, bits >>= 16) buffer[filled++] = zipf_table[bits & 0xFFFF];
+		}
+		break;
+	case CORPUS_TEXT:
+		while (filled < size)
+		{
+			if (pending_used == pending.size()) makeText();
+			size_t count = pending.size() - pending_used;
+			if (count > size - filled) count = size - filled;
+			memcpy(buffer + filled, pending.data() + pending_used, count);
+			pending_used += count;
+			filled += count;
+		}
+		break;
+	default:
+		memset(buffer, 'A', size);
+		break;
+	}
+}
+
+bool parseSize(const char* text, uint64_t &size)
+{
+	/*	Reads a number of bytes, optionally followed by K, M or G. */
+	char* suffix;
+	size = strtoull(text, &suffix, 10);
+	if (suffix == text) return false;
+	if (*suffix == 'K' || *suffix == 'k') size <<= 10, suffix++;
+	else if (*suffix == 'M' || *suffix == 'm') size <<= 20, suffix++;
+	else if (*suffix == 'G' || *suffix == 'g') size <<= 30, suffix++;
+	return *suffix == '\0';
+}
+
+vector<uint64_t> corpusSizes(uint64_t max_size)
+{
+	/*	The sizes go up by 16 times from empty and single byte files, then from 1G by 4 times,
+		so small files (where the header and setup cost the most) are covered as well as huge ones.
+	*/
+	vector<uint64_t> sizes;
+	sizes.push_back(0);
+	for (uint64_t size = 1; size <= max_size; size *= size < (uint64_t(1) << 28) ? 16 : 4)
+	{
+		sizes.push_back(size);
+	}
+	return sizes;
+}
+
+string corpusPath(const string &directory, int kind, uint64_t size)
+{
+	/*	Files are named by kind and size, such as text-1048576.bin. */
+	char name[64];
+	snprintf(name, sizeof(name), "/%s-%llu.bin", CORPUS_KIND_NAMES[kind], (unsigned long long)size);
+	return directory + name;
+}
+
+bool makeCorpusFile(const string &path, int kind, uint64_t size)
+{
+	/*	Writes the file a megabyte at a time from a generator seeded by the kind and size,
+		unless a file of the right size is already there.
+	*/
+	ifstream existing(path, ios::binary | ios::ate);
+	if (existing && uint64_t(existing.tellg()) == size) return true;
+	existing.close();
+
+	OutputFile file_output;
+	if (!file_output.open(path)) return false;
+	CorpusGenerator generator(kind, size * CORPUS_KINDS + kind);
+	vector<unsigned char> buffer(size < OutputFile::BUFFER_SIZE ? size_t(size) : OutputFile::BUFFER_SIZE);
+	for (uint64_t written = 0; written < size; written += buffer.size())
+	{
+		if (size - written < buffer.size()) buffer.resize(size_t(size - written));
+		generator.fill(buffer.data(), buffer.size());
+		file_output.write(buffer.data(), buffer.size());
+	}
+	file_output.close();
+	return true;
+}
+
+bool makeCorpus(const string &directory, uint64_t max_size)
+{
+	/*	Makes every kind of file at every size. Errors go to stderr, leaving stdout for the benchmark results.
+	*/
+	for (uint64_t size : corpusSizes(max_size))
+	{
+		for (int kind = 0; kind < CORPUS_KINDS; kind++)
+		{
+			string path = corpusPath(directory, kind, size);
+			if (!makeCorpusFile(path, kind, size))
+			{
+				fprintf(stderr, "corpus: could not write %s\n", path.c_str());
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,48 @@
+//	File:			corpus.h
+//	Description:	The generated corpus the benchmark suite runs over. Each kind of data is made at a range of
+//					sizes, from empty and tiny files up to a chosen maximum (which can be several gigabytes).
+//					The data comes from a fixed seed for each kind and size, so every run (and every commit)
+//					times exactly the same files, and files that already exist don't have to be made again.
+
+#pragma once
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+enum CorpusKind
+{
+	CORPUS_RANDOM,										// Uniformly random bytes, which can't be compressed.
+	CORPUS_ZIPF,										// Bytes with a skewed (Zipf) distribution over all 256 values.
+	CORPUS_TEXT,										// English-like words, spaces, punctuation and lines.
+	CORPUS_SINGLE,										// One byte value repeated, the smallest possible tree.
+	CORPUS_KINDS
+};
+
+extern const char* const CORPUS_KIND_NAMES[CORPUS_KINDS];
+
+class CorpusGenerator
+{
+	/*	Makes the bytes of one kind of corpus data, a buffer at a time. */
+public:
+	CorpusGenerator(int kind, uint64_t seed);
+	void fill(unsigned char* buffer, size_t size);		// Fills the buffer with the next bytes of the data.
+
+private:
+	int kind;
+	mt19937_64 random;
+	vector<unsigned char> zipf_table;					// 64K byte values in proportion to their Zipf weights, so a byte is one lookup.
+	vector<string> words;								// The vocabulary of the text kind.
+	vector<uint16_t> word_table;						// 64K word indices in proportion to their Zipf weights.
+	string pending;										// Text that was made but didn't fit in the last buffer.
+	size_t pending_used = 0;
+	size_t line_length = 0;
+	void makeText();									// Adds a sentence of text to pending.
+};
+
+bool parseSize(const char* text, uint64_t &size);		// Reads a size with an optional K, M or G suffix. Returns false if it isn't one.
+vector<uint64_t> corpusSizes(uint64_t max_size);		// The sizes each kind is made at, up to max_size.
+string corpusPath(const string &directory, int kind, uint64_t size);	// The path of the file for a kind and size.
+bool makeCorpusFile(const string &path, int kind, uint64_t size);		// Makes the file unless it already exists with the right size. Returns false if it can't be written.
+bool makeCorpus(const string &directory, uint64_t max_size);			// Makes every file of the corpus in the directory (which must exist).
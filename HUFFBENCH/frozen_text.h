@@ -0,0 +1,467 @@
+//	File:			frozen_text.h
+//	Description:	A codec for the tree in frozen_text.htree, generated by HUFF -g. Its tables are constexpr and its
+//					loops are written for this tree's codes, so there is nothing to build before it is used. encode and
+//					decode match HuffmanCode's, and a .huf file is TREE_HEADER followed by encode's bits. Generate it
+//					again whenever the tree file changes.
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "bitio.h"
+
+namespace frozen_text
+{
+	constexpr size_t TREE_HEADER_SIZE = 132;
+	constexpr unsigned int LONGEST_CODE = 11;
+	constexpr unsigned char TREE_HEADER[TREE_HEADER_SIZE] = {	// The header of the tree file, which also starts every .huf file encoded with the tree.
+		254, 72, 85, 67, 187, 187, 187, 187, 187, 107, 187, 187, 187, 187, 187, 187,
+		187, 187, 187, 187, 59, 187, 187, 187, 187, 187, 107, 107, 187, 187, 187, 187,
+		187, 187, 187, 187, 186, 187, 184, 187, 187, 187, 187, 170, 187, 186, 155, 187,
+		187, 187, 187, 187, 180, 102, 83, 103, 85, 119, 85, 85, 120, 69, 70, 118,
+		134, 123, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187,
+		187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187,
+		187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187,
+		187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187, 187,
+		187, 187, 187, 187
+	};
+	constexpr uint64_t CODES[256] = {	// The bits of each byte value's code, right aligned.
+		0x724, 0x725, 0x726, 0x727, 0x728, 0x729, 0x72a, 0x72b,
+		0x72c, 0x72d, 0x2c, 0x72e, 0x72f, 0x730, 0x731, 0x732,
+		0x733, 0x734, 0x735, 0x736, 0x737, 0x738, 0x739, 0x73a,
+		0x73b, 0x73c, 0x73d, 0x73e, 0x73f, 0x740, 0x741, 0x742,
+		0x0, 0x743, 0x744, 0x745, 0x746, 0x747, 0x748, 0x749,
+		0x74a, 0x74b, 0x74c, 0x74d, 0x2d, 0x74e, 0x2e, 0x74f,
+		0x750, 0x751, 0x752, 0x753, 0x754, 0x755, 0x756, 0x757,
+		0x758, 0x759, 0x75a, 0x75b, 0x75c, 0x75d, 0x75e, 0x75f,
+		0x760, 0x38e, 0x761, 0x762, 0x763, 0xe0, 0x764, 0x765,
+		0x766, 0x767, 0x768, 0x769, 0x76a, 0x76b, 0x38f, 0x390,
+		0x76c, 0x76d, 0x76e, 0x391, 0x1c6, 0x76f, 0x770, 0x771,
+		0x772, 0x773, 0x774, 0x775, 0x776, 0x777, 0x778, 0x779,
+		0x77a, 0x4, 0x2f, 0x30, 0xe, 0x1, 0x31, 0x6a,
+		0xf, 0x10, 0x6b, 0x6c, 0x11, 0x12, 0x13, 0x14,
+		0x6d, 0xe1, 0x5, 0x15, 0x6, 0x32, 0x6e, 0x33,
+		0xe2, 0x34, 0x6f, 0x77b, 0x77c, 0x77d, 0x77e, 0x77f,
+		0x780, 0x781, 0x782, 0x783, 0x784, 0x785, 0x786, 0x787,
+		0x788, 0x789, 0x78a, 0x78b, 0x78c, 0x78d, 0x78e, 0x78f,
+		0x790, 0x791, 0x792, 0x793, 0x794, 0x795, 0x796, 0x797,
+		0x798, 0x799, 0x79a, 0x79b, 0x79c, 0x79d, 0x79e, 0x79f,
+		0x7a0, 0x7a1, 0x7a2, 0x7a3, 0x7a4, 0x7a5, 0x7a6, 0x7a7,
+		0x7a8, 0x7a9, 0x7aa, 0x7ab, 0x7ac, 0x7ad, 0x7ae, 0x7af,
+		0x7b0, 0x7b1, 0x7b2, 0x7b3, 0x7b4, 0x7b5, 0x7b6, 0x7b7,
+		0x7b8, 0x7b9, 0x7ba, 0x7bb, 0x7bc, 0x7bd, 0x7be, 0x7bf,
+		0x7c0, 0x7c1, 0x7c2, 0x7c3, 0x7c4, 0x7c5, 0x7c6, 0x7c7,
+		0x7c8, 0x7c9, 0x7ca, 0x7cb, 0x7cc, 0x7cd, 0x7ce, 0x7cf,
+		0x7d0, 0x7d1, 0x7d2, 0x7d3, 0x7d4, 0x7d5, 0x7d6, 0x7d7,
+		0x7d8, 0x7d9, 0x7da, 0x7db, 0x7dc, 0x7dd, 0x7de, 0x7df,
+		0x7e0, 0x7e1, 0x7e2, 0x7e3, 0x7e4, 0x7e5, 0x7e6, 0x7e7,
+		0x7e8, 0x7e9, 0x7ea, 0x7eb, 0x7ec, 0x7ed, 0x7ee, 0x7ef,
+		0x7f0, 0x7f1, 0x7f2, 0x7f3, 0x7f4, 0x7f5, 0x7f6, 0x7f7,
+		0x7f8, 0x7f9, 0x7fa, 0x7fb, 0x7fc, 0x7fd, 0x7fe, 0x7ff
+	};
+	constexpr unsigned char LENGTHS[256] = {
+		11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 6, 11, 11, 11, 11, 11,
+		11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+		3, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 6, 11, 6, 11,
+		11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+		11, 10, 11, 11, 11, 8, 11, 11, 11, 11, 11, 11, 11, 11, 10, 10,
+		11, 11, 11, 10, 9, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+		11, 4, 6, 6, 5, 3, 6, 7, 5, 5, 7, 7, 5, 5, 5, 5,
+		7, 8, 4, 5, 4, 6, 7, 6, 8, 6, 7, 11, 11, 11, 11, 11,
+		11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+		11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+		11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+		11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+		11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+		11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+		11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+		11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11
+	};
+	constexpr uint64_t PADDING[8] = {	// The bits that fill out the last byte once 1 to 7 of its bits are used.
+		0x0, 0x72, 0x39, 0x1c, 0xe, 0x7, 0x3, 0x1
+	};
+	constexpr uint32_t DECODE_TABLE[2048] = {	// The 11 bit primary table (laid out as in HuffmanTree::buildDecodeTable).
+		0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020,
+		0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020,
+		0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020,
+		0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020, 0x2062020,
+		0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520,
+		0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520,
+		0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520,
+		0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520, 0x2066520,
+		0x2076120, 0x2076120, 0x2076120, 0x2076120, 0x2076120, 0x2076120, 0x2076120, 0x2076120,
+		0x2076120, 0x2076120, 0x2076120, 0x2076120, 0x2076120, 0x2076120, 0x2076120, 0x2076120,
+		0x2077220, 0x2077220, 0x2077220, 0x2077220, 0x2077220, 0x2077220, 0x2077220, 0x2077220,
+		0x2077220, 0x2077220, 0x2077220, 0x2077220, 0x2077220, 0x2077220, 0x2077220, 0x2077220,
+		0x2077420, 0x2077420, 0x2077420, 0x2077420, 0x2077420, 0x2077420, 0x2077420, 0x2077420,
+		0x2077420, 0x2077420, 0x2077420, 0x2077420, 0x2077420, 0x2077420, 0x2077420, 0x2077420,
+		0x2086420, 0x2086420, 0x2086420, 0x2086420, 0x2086420, 0x2086420, 0x2086420, 0x2086420,
+		0x2086820, 0x2086820, 0x2086820, 0x2086820, 0x2086820, 0x2086820, 0x2086820, 0x2086820,
+		0x2086920, 0x2086920, 0x2086920, 0x2086920, 0x2086920, 0x2086920, 0x2086920, 0x2086920,
+		0x2086c20, 0x2086c20, 0x2086c20, 0x2086c20, 0x2086c20, 0x2086c20, 0x2086c20, 0x2086c20,
+		0x2086d20, 0x2086d20, 0x2086d20, 0x2086d20, 0x2086d20, 0x2086d20, 0x2086d20, 0x2086d20,
+		0x2086e20, 0x2086e20, 0x2086e20, 0x2086e20, 0x2086e20, 0x2086e20, 0x2086e20, 0x2086e20,
+		0x2086f20, 0x2086f20, 0x2086f20, 0x2086f20, 0x2086f20, 0x2086f20, 0x2086f20, 0x2086f20,
+		0x2087320, 0x2087320, 0x2087320, 0x2087320, 0x2087320, 0x2087320, 0x2087320, 0x2087320,
+		0x2090a20, 0x2090a20, 0x2090a20, 0x2090a20, 0x2092c20, 0x2092c20, 0x2092c20, 0x2092c20,
+		0x2092e20, 0x2092e20, 0x2092e20, 0x2092e20, 0x2096220, 0x2096220, 0x2096220, 0x2096220,
+		0x2096320, 0x2096320, 0x2096320, 0x2096320, 0x2096620, 0x2096620, 0x2096620, 0x2096620,
+		0x2097520, 0x2097520, 0x2097520, 0x2097520, 0x2097720, 0x2097720, 0x2097720, 0x2097720,
+		0x2097920, 0x2097920, 0x2097920, 0x2097920, 0x20a6720, 0x20a6720, 0x20a6a20, 0x20a6a20,
+		0x20a6b20, 0x20a6b20, 0x20a7020, 0x20a7020, 0x20a7620, 0x20a7620, 0x20a7a20, 0x20a7a20,
+		0x20b4520, 0x20b7120, 0x20b7820, 0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020,
+		0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020,
+		0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020,
+		0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020, 0x1030020,
+		0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065,
+		0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065,
+		0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065,
+		0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065, 0x2062065,
+		0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565,
+		0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565,
+		0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565,
+		0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565, 0x2066565,
+		0x2076165, 0x2076165, 0x2076165, 0x2076165, 0x2076165, 0x2076165, 0x2076165, 0x2076165,
+		0x2076165, 0x2076165, 0x2076165, 0x2076165, 0x2076165, 0x2076165, 0x2076165, 0x2076165,
+		0x2077265, 0x2077265, 0x2077265, 0x2077265, 0x2077265, 0x2077265, 0x2077265, 0x2077265,
+		0x2077265, 0x2077265, 0x2077265, 0x2077265, 0x2077265, 0x2077265, 0x2077265, 0x2077265,
+		0x2077465, 0x2077465, 0x2077465, 0x2077465, 0x2077465, 0x2077465, 0x2077465, 0x2077465,
+		0x2077465, 0x2077465, 0x2077465, 0x2077465, 0x2077465, 0x2077465, 0x2077465, 0x2077465,
+		0x2086465, 0x2086465, 0x2086465, 0x2086465, 0x2086465, 0x2086465, 0x2086465, 0x2086465,
+		0x2086865, 0x2086865, 0x2086865, 0x2086865, 0x2086865, 0x2086865, 0x2086865, 0x2086865,
+		0x2086965, 0x2086965, 0x2086965, 0x2086965, 0x2086965, 0x2086965, 0x2086965, 0x2086965,
+		0x2086c65, 0x2086c65, 0x2086c65, 0x2086c65, 0x2086c65, 0x2086c65, 0x2086c65, 0x2086c65,
+		0x2086d65, 0x2086d65, 0x2086d65, 0x2086d65, 0x2086d65, 0x2086d65, 0x2086d65, 0x2086d65,
+		0x2086e65, 0x2086e65, 0x2086e65, 0x2086e65, 0x2086e65, 0x2086e65, 0x2086e65, 0x2086e65,
+		0x2086f65, 0x2086f65, 0x2086f65, 0x2086f65, 0x2086f65, 0x2086f65, 0x2086f65, 0x2086f65,
+		0x2087365, 0x2087365, 0x2087365, 0x2087365, 0x2087365, 0x2087365, 0x2087365, 0x2087365,
+		0x2090a65, 0x2090a65, 0x2090a65, 0x2090a65, 0x2092c65, 0x2092c65, 0x2092c65, 0x2092c65,
+		0x2092e65, 0x2092e65, 0x2092e65, 0x2092e65, 0x2096265, 0x2096265, 0x2096265, 0x2096265,
+		0x2096365, 0x2096365, 0x2096365, 0x2096365, 0x2096665, 0x2096665, 0x2096665, 0x2096665,
+		0x2097565, 0x2097565, 0x2097565, 0x2097565, 0x2097765, 0x2097765, 0x2097765, 0x2097765,
+		0x2097965, 0x2097965, 0x2097965, 0x2097965, 0x20a6765, 0x20a6765, 0x20a6a65, 0x20a6a65,
+		0x20a6b65, 0x20a6b65, 0x20a7065, 0x20a7065, 0x20a7665, 0x20a7665, 0x20a7a65, 0x20a7a65,
+		0x20b4565, 0x20b7165, 0x20b7865, 0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065,
+		0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065,
+		0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065,
+		0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065, 0x1030065,
+		0x2072061, 0x2072061, 0x2072061, 0x2072061, 0x2072061, 0x2072061, 0x2072061, 0x2072061,
+		0x2072061, 0x2072061, 0x2072061, 0x2072061, 0x2072061, 0x2072061, 0x2072061, 0x2072061,
+		0x2076561, 0x2076561, 0x2076561, 0x2076561, 0x2076561, 0x2076561, 0x2076561, 0x2076561,
+		0x2076561, 0x2076561, 0x2076561, 0x2076561, 0x2076561, 0x2076561, 0x2076561, 0x2076561,
+		0x2086161, 0x2086161, 0x2086161, 0x2086161, 0x2086161, 0x2086161, 0x2086161, 0x2086161,
+		0x2087261, 0x2087261, 0x2087261, 0x2087261, 0x2087261, 0x2087261, 0x2087261, 0x2087261,
+		0x2087461, 0x2087461, 0x2087461, 0x2087461, 0x2087461, 0x2087461, 0x2087461, 0x2087461,
+		0x2096461, 0x2096461, 0x2096461, 0x2096461, 0x2096861, 0x2096861, 0x2096861, 0x2096861,
+		0x2096961, 0x2096961, 0x2096961, 0x2096961, 0x2096c61, 0x2096c61, 0x2096c61, 0x2096c61,
+		0x2096d61, 0x2096d61, 0x2096d61, 0x2096d61, 0x2096e61, 0x2096e61, 0x2096e61, 0x2096e61,
+		0x2096f61, 0x2096f61, 0x2096f61, 0x2096f61, 0x2097361, 0x2097361, 0x2097361, 0x2097361,
+		0x20a0a61, 0x20a0a61, 0x20a2c61, 0x20a2c61, 0x20a2e61, 0x20a2e61, 0x20a6261, 0x20a6261,
+		0x20a6361, 0x20a6361, 0x20a6661, 0x20a6661, 0x20a7561, 0x20a7561, 0x20a7761, 0x20a7761,
+		0x20a7961, 0x20a7961, 0x20b6761, 0x20b6a61, 0x20b6b61, 0x20b7061, 0x20b7661, 0x20b7a61,
+		0x1040061, 0x1040061, 0x1040061, 0x1040061, 0x1040061, 0x1040061, 0x1040061, 0x1040061,
+		0x1040061, 0x1040061, 0x1040061, 0x1040061, 0x1040061, 0x1040061, 0x1040061, 0x1040061,
+		0x2072072, 0x2072072, 0x2072072, 0x2072072, 0x2072072, 0x2072072, 0x2072072, 0x2072072,
+		0x2072072, 0x2072072, 0x2072072, 0x2072072, 0x2072072, 0x2072072, 0x2072072, 0x2072072,
+		0x2076572, 0x2076572, 0x2076572, 0x2076572, 0x2076572, 0x2076572, 0x2076572, 0x2076572,
+		0x2076572, 0x2076572, 0x2076572, 0x2076572, 0x2076572, 0x2076572, 0x2076572, 0x2076572,
+		0x2086172, 0x2086172, 0x2086172, 0x2086172, 0x2086172, 0x2086172, 0x2086172, 0x2086172,
+		0x2087272, 0x2087272, 0x2087272, 0x2087272, 0x2087272, 0x2087272, 0x2087272, 0x2087272,
+		0x2087472, 0x2087472, 0x2087472, 0x2087472, 0x2087472, 0x2087472, 0x2087472, 0x2087472,
+		0x2096472, 0x2096472, 0x2096472, 0x2096472, 0x2096872, 0x2096872, 0x2096872, 0x2096872,
+		0x2096972, 0x2096972, 0x2096972, 0x2096972, 0x2096c72, 0x2096c72, 0x2096c72, 0x2096c72,
+		0x2096d72, 0x2096d72, 0x2096d72, 0x2096d72, 0x2096e72, 0x2096e72, 0x2096e72, 0x2096e72,
+		0x2096f72, 0x2096f72, 0x2096f72, 0x2096f72, 0x2097372, 0x2097372, 0x2097372, 0x2097372,
+		0x20a0a72, 0x20a0a72, 0x20a2c72, 0x20a2c72, 0x20a2e72, 0x20a2e72, 0x20a6272, 0x20a6272,
+		0x20a6372, 0x20a6372, 0x20a6672, 0x20a6672, 0x20a7572, 0x20a7572, 0x20a7772, 0x20a7772,
+		0x20a7972, 0x20a7972, 0x20b6772, 0x20b6a72, 0x20b6b72, 0x20b7072, 0x20b7672, 0x20b7a72,
+		0x1040072, 0x1040072, 0x1040072, 0x1040072, 0x1040072, 0x1040072, 0x1040072, 0x1040072,
+		0x1040072, 0x1040072, 0x1040072, 0x1040072, 0x1040072, 0x1040072, 0x1040072, 0x1040072,
+		0x2072074, 0x2072074, 0x2072074, 0x2072074, 0x2072074, 0x2072074, 0x2072074, 0x2072074,
+		0x2072074, 0x2072074, 0x2072074, 0x2072074, 0x2072074, 0x2072074, 0x2072074, 0x2072074,
+		0x2076574, 0x2076574, 0x2076574, 0x2076574, 0x2076574, 0x2076574, 0x2076574, 0x2076574,
+		0x2076574, 0x2076574, 0x2076574, 0x2076574, 0x2076574, 0x2076574, 0x2076574, 0x2076574,
+		0x2086174, 0x2086174, 0x2086174, 0x2086174, 0x2086174, 0x2086174, 0x2086174, 0x2086174,
+		0x2087274, 0x2087274, 0x2087274, 0x2087274, 0x2087274, 0x2087274, 0x2087274, 0x2087274,
+		0x2087474, 0x2087474, 0x2087474, 0x2087474, 0x2087474, 0x2087474, 0x2087474, 0x2087474,
+		0x2096474, 0x2096474, 0x2096474, 0x2096474, 0x2096874, 0x2096874, 0x2096874, 0x2096874,
+		0x2096974, 0x2096974, 0x2096974, 0x2096974, 0x2096c74, 0x2096c74, 0x2096c74, 0x2096c74,
+		0x2096d74, 0x2096d74, 0x2096d74, 0x2096d74, 0x2096e74, 0x2096e74, 0x2096e74, 0x2096e74,
+		0x2096f74, 0x2096f74, 0x2096f74, 0x2096f74, 0x2097374, 0x2097374, 0x2097374, 0x2097374,
+		0x20a0a74, 0x20a0a74, 0x20a2c74, 0x20a2c74, 0x20a2e74, 0x20a2e74, 0x20a6274, 0x20a6274,
+		0x20a6374, 0x20a6374, 0x20a6674, 0x20a6674, 0x20a7574, 0x20a7574, 0x20a7774, 0x20a7774,
+		0x20a7974, 0x20a7974, 0x20b6774, 0x20b6a74, 0x20b6b74, 0x20b7074, 0x20b7674, 0x20b7a74,
+		0x1040074, 0x1040074, 0x1040074, 0x1040074, 0x1040074, 0x1040074, 0x1040074, 0x1040074,
+		0x1040074, 0x1040074, 0x1040074, 0x1040074, 0x1040074, 0x1040074, 0x1040074, 0x1040074,
+		0x2082064, 0x2082064, 0x2082064, 0x2082064, 0x2082064, 0x2082064, 0x2082064, 0x2082064,
+		0x2086564, 0x2086564, 0x2086564, 0x2086564, 0x2086564, 0x2086564, 0x2086564, 0x2086564,
+		0x2096164, 0x2096164, 0x2096164, 0x2096164, 0x2097264, 0x2097264, 0x2097264, 0x2097264,
+		0x2097464, 0x2097464, 0x2097464, 0x2097464, 0x20a6464, 0x20a6464, 0x20a6864, 0x20a6864,
+		0x20a6964, 0x20a6964, 0x20a6c64, 0x20a6c64, 0x20a6d64, 0x20a6d64, 0x20a6e64, 0x20a6e64,
+		0x20a6f64, 0x20a6f64, 0x20a7364, 0x20a7364, 0x20b0a64, 0x20b2c64, 0x20b2e64, 0x20b6264,
+		0x20b6364, 0x20b6664, 0x20b7564, 0x20b7764, 0x20b7964, 0x1050064, 0x1050064, 0x1050064,
+		0x1050064, 0x1050064, 0x1050064, 0x1050064, 0x1050064, 0x1050064, 0x1050064, 0x1050064,
+		0x2082068, 0x2082068, 0x2082068, 0x2082068, 0x2082068, 0x2082068, 0x2082068, 0x2082068,
+		0x2086568, 0x2086568, 0x2086568, 0x2086568, 0x2086568, 0x2086568, 0x2086568, 0x2086568,
+		0x2096168, 0x2096168, 0x2096168, 0x2096168, 0x2097268, 0x2097268, 0x2097268, 0x2097268,
+		0x2097468, 0x2097468, 0x2097468, 0x2097468, 0x20a6468, 0x20a6468, 0x20a6868, 0x20a6868,
+		0x20a6968, 0x20a6968, 0x20a6c68, 0x20a6c68, 0x20a6d68, 0x20a6d68, 0x20a6e68, 0x20a6e68,
+		0x20a6f68, 0x20a6f68, 0x20a7368, 0x20a7368, 0x20b0a68, 0x20b2c68, 0x20b2e68, 0x20b6268,
+		0x20b6368, 0x20b6668, 0x20b7568, 0x20b7768, 0x20b7968, 0x1050068, 0x1050068, 0x1050068,
+		0x1050068, 0x1050068, 0x1050068, 0x1050068, 0x1050068, 0x1050068, 0x1050068, 0x1050068,
+		0x2082069, 0x2082069, 0x2082069, 0x2082069, 0x2082069, 0x2082069, 0x2082069, 0x2082069,
+		0x2086569, 0x2086569, 0x2086569, 0x2086569, 0x2086569, 0x2086569, 0x2086569, 0x2086569,
+		0x2096169, 0x2096169, 0x2096169, 0x2096169, 0x2097269, 0x2097269, 0x2097269, 0x2097269,
+		0x2097469, 0x2097469, 0x2097469, 0x2097469, 0x20a6469, 0x20a6469, 0x20a6869, 0x20a6869,
+		0x20a6969, 0x20a6969, 0x20a6c69, 0x20a6c69, 0x20a6d69, 0x20a6d69, 0x20a6e69, 0x20a6e69,
+		0x20a6f69, 0x20a6f69, 0x20a7369, 0x20a7369, 0x20b0a69, 0x20b2c69, 0x20b2e69, 0x20b6269,
+		0x20b6369, 0x20b6669, 0x20b7569, 0x20b7769, 0x20b7969, 0x1050069, 0x1050069, 0x1050069,
+		0x1050069, 0x1050069, 0x1050069, 0x1050069, 0x1050069, 0x1050069, 0x1050069, 0x1050069,
+		0x208206c, 0x208206c, 0x208206c, 0x208206c, 0x208206c, 0x208206c, 0x208206c, 0x208206c,
+		0x208656c, 0x208656c, 0x208656c, 0x208656c, 0x208656c, 0x208656c, 0x208656c, 0x208656c,
+		0x209616c, 0x209616c, 0x209616c, 0x209616c, 0x209726c, 0x209726c, 0x209726c, 0x209726c,
+		0x209746c, 0x209746c, 0x209746c, 0x209746c, 0x20a646c, 0x20a646c, 0x20a686c, 0x20a686c,
+		0x20a696c, 0x20a696c, 0x20a6c6c, 0x20a6c6c, 0x20a6d6c, 0x20a6d6c, 0x20a6e6c, 0x20a6e6c,
+		0x20a6f6c, 0x20a6f6c, 0x20a736c, 0x20a736c, 0x20b0a6c, 0x20b2c6c, 0x20b2e6c, 0x20b626c,
+		0x20b636c, 0x20b666c, 0x20b756c, 0x20b776c, 0x20b796c, 0x105006c, 0x105006c, 0x105006c,
+		0x105006c, 0x105006c, 0x105006c, 0x105006c, 0x105006c, 0x105006c, 0x105006c, 0x105006c,
+		0x208206d, 0x208206d, 0x208206d, 0x208206d, 0x208206d, 0x208206d, 0x208206d, 0x208206d,
+		0x208656d, 0x208656d, 0x208656d, 0x208656d, 0x208656d, 0x208656d, 0x208656d, 0x208656d,
+		0x209616d, 0x209616d, 0x209616d, 0x209616d, 0x209726d, 0x209726d, 0x209726d, 0x209726d,
+		0x209746d, 0x209746d, 0x209746d, 0x209746d, 0x20a646d, 0x20a646d, 0x20a686d, 0x20a686d,
+		0x20a696d, 0x20a696d, 0x20a6c6d, 0x20a6c6d, 0x20a6d6d, 0x20a6d6d, 0x20a6e6d, 0x20a6e6d,
+		0x20a6f6d, 0x20a6f6d, 0x20a736d, 0x20a736d, 0x20b0a6d, 0x20b2c6d, 0x20b2e6d, 0x20b626d,
+		0x20b636d, 0x20b666d, 0x20b756d, 0x20b776d, 0x20b796d, 0x105006d, 0x105006d, 0x105006d,
+		0x105006d, 0x105006d, 0x105006d, 0x105006d, 0x105006d, 0x105006d, 0x105006d, 0x105006d,
+		0x208206e, 0x208206e, 0x208206e, 0x208206e, 0x208206e, 0x208206e, 0x208206e, 0x208206e,
+		0x208656e, 0x208656e, 0x208656e, 0x208656e, 0x208656e, 0x208656e, 0x208656e, 0x208656e,
+		0x209616e, 0x209616e, 0x209616e, 0x209616e, 0x209726e, 0x209726e, 0x209726e, 0x209726e,
+		0x209746e, 0x209746e, 0x209746e, 0x209746e, 0x20a646e, 0x20a646e, 0x20a686e, 0x20a686e,
+		0x20a696e, 0x20a696e, 0x20a6c6e, 0x20a6c6e, 0x20a6d6e, 0x20a6d6e, 0x20a6e6e, 0x20a6e6e,
+		0x20a6f6e, 0x20a6f6e, 0x20a736e, 0x20a736e, 0x20b0a6e, 0x20b2c6e, 0x20b2e6e, 0x20b626e,
+		0x20b636e, 0x20b666e, 0x20b756e, 0x20b776e, 0x20b796e, 0x105006e, 0x105006e, 0x105006e,
+		0x105006e, 0x105006e, 0x105006e, 0x105006e, 0x105006e, 0x105006e, 0x105006e, 0x105006e,
+		0x208206f, 0x208206f, 0x208206f, 0x208206f, 0x208206f, 0x208206f, 0x208206f, 0x208206f,
+		0x208656f, 0x208656f, 0x208656f, 0x208656f, 0x208656f, 0x208656f, 0x208656f, 0x208656f,
+		0x209616f, 0x209616f, 0x209616f, 0x209616f, 0x209726f, 0x209726f, 0x209726f, 0x209726f,
+		0x209746f, 0x209746f, 0x209746f, 0x209746f, 0x20a646f, 0x20a646f, 0x20a686f, 0x20a686f,
+		0x20a696f, 0x20a696f, 0x20a6c6f, 0x20a6c6f, 0x20a6d6f, 0x20a6d6f, 0x20a6e6f, 0x20a6e6f,
+		0x20a6f6f, 0x20a6f6f, 0x20a736f, 0x20a736f, 0x20b0a6f, 0x20b2c6f, 0x20b2e6f, 0x20b626f,
+		0x20b636f, 0x20b666f, 0x20b756f, 0x20b776f, 0x20b796f, 0x105006f, 0x105006f, 0x105006f,
+		0x105006f, 0x105006f, 0x105006f, 0x105006f, 0x105006f, 0x105006f, 0x105006f, 0x105006f,
+		0x2082073, 0x2082073, 0x2082073, 0x2082073, 0x2082073, 0x2082073, 0x2082073, 0x2082073,
+		0x2086573, 0x2086573, 0x2086573, 0x2086573, 0x2086573, 0x2086573, 0x2086573, 0x2086573,
+		0x2096173, 0x2096173, 0x2096173, 0x2096173, 0x2097273, 0x2097273, 0x2097273, 0x2097273,
+		0x2097473, 0x2097473, 0x2097473, 0x2097473, 0x20a6473, 0x20a6473, 0x20a6873, 0x20a6873,
+		0x20a6973, 0x20a6973, 0x20a6c73, 0x20a6c73, 0x20a6d73, 0x20a6d73, 0x20a6e73, 0x20a6e73,
+		0x20a6f73, 0x20a6f73, 0x20a7373, 0x20a7373, 0x20b0a73, 0x20b2c73, 0x20b2e73, 0x20b6273,
+		0x20b6373, 0x20b6673, 0x20b7573, 0x20b7773, 0x20b7973, 0x1050073, 0x1050073, 0x1050073,
+		0x1050073, 0x1050073, 0x1050073, 0x1050073, 0x1050073, 0x1050073, 0x1050073, 0x1050073,
+		0x209200a, 0x209200a, 0x209200a, 0x209200a, 0x209650a, 0x209650a, 0x209650a, 0x209650a,
+		0x20a610a, 0x20a610a, 0x20a720a, 0x20a720a, 0x20a740a, 0x20a740a, 0x20b640a, 0x20b680a,
+		0x20b690a, 0x20b6c0a, 0x20b6d0a, 0x20b6e0a, 0x20b6f0a, 0x20b730a, 0x106000a, 0x106000a,
+		0x106000a, 0x106000a, 0x106000a, 0x106000a, 0x106000a, 0x106000a, 0x106000a, 0x106000a,
+		0x209202c, 0x209202c, 0x209202c, 0x209202c, 0x209652c, 0x209652c, 0x209652c, 0x209652c,
+		0x20a612c, 0x20a612c, 0x20a722c, 0x20a722c, 0x20a742c, 0x20a742c, 0x20b642c, 0x20b682c,
+		0x20b692c, 0x20b6c2c, 0x20b6d2c, 0x20b6e2c, 0x20b6f2c, 0x20b732c, 0x106002c, 0x106002c,
+		0x106002c, 0x106002c, 0x106002c, 0x106002c, 0x106002c, 0x106002c, 0x106002c, 0x106002c,
+		0x209202e, 0x209202e, 0x209202e, 0x209202e, 0x209652e, 0x209652e, 0x209652e, 0x209652e,
+		0x20a612e, 0x20a612e, 0x20a722e, 0x20a722e, 0x20a742e, 0x20a742e, 0x20b642e, 0x20b682e,
+		0x20b692e, 0x20b6c2e, 0x20b6d2e, 0x20b6e2e, 0x20b6f2e, 0x20b732e, 0x106002e, 0x106002e,
+		0x106002e, 0x106002e, 0x106002e, 0x106002e, 0x106002e, 0x106002e, 0x106002e, 0x106002e,
+		0x2092062, 0x2092062, 0x2092062, 0x2092062, 0x2096562, 0x2096562, 0x2096562, 0x2096562,
+		0x20a6162, 0x20a6162, 0x20a7262, 0x20a7262, 0x20a7462, 0x20a7462, 0x20b6462, 0x20b6862,
+		0x20b6962, 0x20b6c62, 0x20b6d62, 0x20b6e62, 0x20b6f62, 0x20b7362, 0x1060062, 0x1060062,
+		0x1060062, 0x1060062, 0x1060062, 0x1060062, 0x1060062, 0x1060062, 0x1060062, 0x1060062,
+		0x2092063, 0x2092063, 0x2092063, 0x2092063, 0x2096563, 0x2096563, 0x2096563, 0x2096563,
+		0x20a6163, 0x20a6163, 0x20a7263, 0x20a7263, 0x20a7463, 0x20a7463, 0x20b6463, 0x20b6863,
+		0x20b6963, 0x20b6c63, 0x20b6d63, 0x20b6e63, 0x20b6f63, 0x20b7363, 0x1060063, 0x1060063,
+		0x1060063, 0x1060063, 0x1060063, 0x1060063, 0x1060063, 0x1060063, 0x1060063, 0x1060063,
+		0x2092066, 0x2092066, 0x2092066, 0x2092066, 0x2096566, 0x2096566, 0x2096566, 0x2096566,
+		0x20a6166, 0x20a6166, 0x20a7266, 0x20a7266, 0x20a7466, 0x20a7466, 0x20b6466, 0x20b6866,
+		0x20b6966, 0x20b6c66, 0x20b6d66, 0x20b6e66, 0x20b6f66, 0x20b7366, 0x1060066, 0x1060066,
+		0x1060066, 0x1060066, 0x1060066, 0x1060066, 0x1060066, 0x1060066, 0x1060066, 0x1060066,
+		0x2092075, 0x2092075, 0x2092075, 0x2092075, 0x2096575, 0x2096575, 0x2096575, 0x2096575,
+		0x20a6175, 0x20a6175, 0x20a7275, 0x20a7275, 0x20a7475, 0x20a7475, 0x20b6475, 0x20b6875,
+		0x20b6975, 0x20b6c75, 0x20b6d75, 0x20b6e75, 0x20b6f75, 0x20b7375, 0x1060075, 0x1060075,
+		0x1060075, 0x1060075, 0x1060075, 0x1060075, 0x1060075, 0x1060075, 0x1060075, 0x1060075,
+		0x2092077, 0x2092077, 0x2092077, 0x2092077, 0x2096577, 0x2096577, 0x2096577, 0x2096577,
+		0x20a6177, 0x20a6177, 0x20a7277, 0x20a7277, 0x20a7477, 0x20a7477, 0x20b6477, 0x20b6877,
+		0x20b6977, 0x20b6c77, 0x20b6d77, 0x20b6e77, 0x20b6f77, 0x20b7377, 0x1060077, 0x1060077,
+		0x1060077, 0x1060077, 0x1060077, 0x1060077, 0x1060077, 0x1060077, 0x1060077, 0x1060077,
+		0x2092079, 0x2092079, 0x2092079, 0x2092079, 0x2096579, 0x2096579, 0x2096579, 0x2096579,
+		0x20a6179, 0x20a6179, 0x20a7279, 0x20a7279, 0x20a7479, 0x20a7479, 0x20b6479, 0x20b6879,
+		0x20b6979, 0x20b6c79, 0x20b6d79, 0x20b6e79, 0x20b6f79, 0x20b7379, 0x1060079, 0x1060079,
+		0x1060079, 0x1060079, 0x1060079, 0x1060079, 0x1060079, 0x1060079, 0x1060079, 0x1060079,
+		0x20a2067, 0x20a2067, 0x20a6567, 0x20a6567, 0x20b6167, 0x20b7267, 0x20b7467, 0x1070067,
+		0x1070067, 0x1070067, 0x1070067, 0x1070067, 0x1070067, 0x1070067, 0x1070067, 0x1070067,
+		0x20a206a, 0x20a206a, 0x20a656a, 0x20a656a, 0x20b616a, 0x20b726a, 0x20b746a, 0x107006a,
+		0x107006a, 0x107006a, 0x107006a, 0x107006a, 0x107006a, 0x107006a, 0x107006a, 0x107006a,
+		0x20a206b, 0x20a206b, 0x20a656b, 0x20a656b, 0x20b616b, 0x20b726b, 0x20b746b, 0x107006b,
+		0x107006b, 0x107006b, 0x107006b, 0x107006b, 0x107006b, 0x107006b, 0x107006b, 0x107006b,
+		0x20a2070, 0x20a2070, 0x20a6570, 0x20a6570, 0x20b6170, 0x20b7270, 0x20b7470, 0x1070070,
+		0x1070070, 0x1070070, 0x1070070, 0x1070070, 0x1070070, 0x1070070, 0x1070070, 0x1070070,
+		0x20a2076, 0x20a2076, 0x20a6576, 0x20a6576, 0x20b6176, 0x20b7276, 0x20b7476, 0x1070076,
+		0x1070076, 0x1070076, 0x1070076, 0x1070076, 0x1070076, 0x1070076, 0x1070076, 0x1070076,
+		0x20a207a, 0x20a207a, 0x20a657a, 0x20a657a, 0x20b617a, 0x20b727a, 0x20b747a, 0x107007a,
+		0x107007a, 0x107007a, 0x107007a, 0x107007a, 0x107007a, 0x107007a, 0x107007a, 0x107007a,
+		0x20b2045, 0x20b6545, 0x1080045, 0x1080045, 0x1080045, 0x1080045, 0x1080045, 0x1080045,
+		0x20b2071, 0x20b6571, 0x1080071, 0x1080071, 0x1080071, 0x1080071, 0x1080071, 0x1080071,
+		0x20b2078, 0x20b6578, 0x1080078, 0x1080078, 0x1080078, 0x1080078, 0x1080078, 0x1080078,
+		0x1090054, 0x1090054, 0x1090054, 0x1090054, 0x10a0041, 0x10a0041, 0x10a004e, 0x10a004e,
+		0x10a004f, 0x10a004f, 0x10a0053, 0x10a0053, 0x10b0000, 0x10b0001, 0x10b0002, 0x10b0003,
+		0x10b0004, 0x10b0005, 0x10b0006, 0x10b0007, 0x10b0008, 0x10b0009, 0x10b000b, 0x10b000c,
+		0x10b000d, 0x10b000e, 0x10b000f, 0x10b0010, 0x10b0011, 0x10b0012, 0x10b0013, 0x10b0014,
+		0x10b0015, 0x10b0016, 0x10b0017, 0x10b0018, 0x10b0019, 0x10b001a, 0x10b001b, 0x10b001c,
+		0x10b001d, 0x10b001e, 0x10b001f, 0x10b0021, 0x10b0022, 0x10b0023, 0x10b0024, 0x10b0025,
+		0x10b0026, 0x10b0027, 0x10b0028, 0x10b0029, 0x10b002a, 0x10b002b, 0x10b002d, 0x10b002f,
+		0x10b0030, 0x10b0031, 0x10b0032, 0x10b0033, 0x10b0034, 0x10b0035, 0x10b0036, 0x10b0037,
+		0x10b0038, 0x10b0039, 0x10b003a, 0x10b003b, 0x10b003c, 0x10b003d, 0x10b003e, 0x10b003f,
+		0x10b0040, 0x10b0042, 0x10b0043, 0x10b0044, 0x10b0046, 0x10b0047, 0x10b0048, 0x10b0049,
+		0x10b004a, 0x10b004b, 0x10b004c, 0x10b004d, 0x10b0050, 0x10b0051, 0x10b0052, 0x10b0055,
+		0x10b0056, 0x10b0057, 0x10b0058, 0x10b0059, 0x10b005a, 0x10b005b, 0x10b005c, 0x10b005d,
+		0x10b005e, 0x10b005f, 0x10b0060, 0x10b007b, 0x10b007c, 0x10b007d, 0x10b007e, 0x10b007f,
+		0x10b0080, 0x10b0081, 0x10b0082, 0x10b0083, 0x10b0084, 0x10b0085, 0x10b0086, 0x10b0087,
+		0x10b0088, 0x10b0089, 0x10b008a, 0x10b008b, 0x10b008c, 0x10b008d, 0x10b008e, 0x10b008f,
+		0x10b0090, 0x10b0091, 0x10b0092, 0x10b0093, 0x10b0094, 0x10b0095, 0x10b0096, 0x10b0097,
+		0x10b0098, 0x10b0099, 0x10b009a, 0x10b009b, 0x10b009c, 0x10b009d, 0x10b009e, 0x10b009f,
+		0x10b00a0, 0x10b00a1, 0x10b00a2, 0x10b00a3, 0x10b00a4, 0x10b00a5, 0x10b00a6, 0x10b00a7,
+		0x10b00a8, 0x10b00a9, 0x10b00aa, 0x10b00ab, 0x10b00ac, 0x10b00ad, 0x10b00ae, 0x10b00af,
+		0x10b00b0, 0x10b00b1, 0x10b00b2, 0x10b00b3, 0x10b00b4, 0x10b00b5, 0x10b00b6, 0x10b00b7,
+		0x10b00b8, 0x10b00b9, 0x10b00ba, 0x10b00bb, 0x10b00bc, 0x10b00bd, 0x10b00be, 0x10b00bf,
+		0x10b00c0, 0x10b00c1, 0x10b00c2, 0x10b00c3, 0x10b00c4, 0x10b00c5, 0x10b00c6, 0x10b00c7,
+		0x10b00c8, 0x10b00c9, 0x10b00ca, 0x10b00cb, 0x10b00cc, 0x10b00cd, 0x10b00ce, 0x10b00cf,
+		0x10b00d0, 0x10b00d1, 0x10b00d2, 0x10b00d3, 0x10b00d4, 0x10b00d5, 0x10b00d6, 0x10b00d7,
+		0x10b00d8, 0x10b00d9, 0x10b00da, 0x10b00db, 0x10b00dc, 0x10b00dd, 0x10b00de, 0x10b00df,
+		0x10b00e0, 0x10b00e1, 0x10b00e2, 0x10b00e3, 0x10b00e4, 0x10b00e5, 0x10b00e6, 0x10b00e7,
+		0x10b00e8, 0x10b00e9, 0x10b00ea, 0x10b00eb, 0x10b00ec, 0x10b00ed, 0x10b00ee, 0x10b00ef,
+		0x10b00f0, 0x10b00f1, 0x10b00f2, 0x10b00f3, 0x10b00f4, 0x10b00f5, 0x10b00f6, 0x10b00f7,
+		0x10b00f8, 0x10b00f9, 0x10b00fa, 0x10b00fb, 0x10b00fc, 0x10b00fd, 0x10b00fe, 0x10b00ff
+	};
+	constexpr uint16_t ROOT = 256;
+	constexpr uint16_t CHILDREN[255][2] = {	// The left and right child of each node after the 256 leaves, for the last few codes.
+		257, 263, 258, 259, 32, 101, 260, 261, 97, 114, 116, 262, 100, 104, 264, 273,
+		265, 268, 266, 267, 105, 108, 109, 110, 269, 270, 111, 115, 271, 272, 10, 44,
+		46, 98, 274, 284, 275, 278, 276, 277, 99, 102, 117, 119, 279, 281, 121, 280,
+		103, 106, 282, 283, 107, 112, 118, 122, 285, 384, 286, 321, 287, 292, 288, 289,
+		69, 113, 120, 290, 84, 291, 65, 78, 293, 306, 294, 299, 295, 296, 79, 83,
+		297, 298, 0, 1, 2, 3, 300, 303, 301, 302, 4, 5, 6, 7, 304, 305,
+		8, 9, 11, 12, 307, 314, 308, 311, 309, 310, 13, 14, 15, 16, 312, 313,
+		17, 18, 19, 20, 315, 318, 316, 317, 21, 22, 23, 24, 319, 320, 25, 26,
+		27, 28, 322, 353, 323, 338, 324, 331, 325, 328, 326, 327, 29, 30, 31, 33,
+		329, 330, 34, 35, 36, 37, 332, 335, 333, 334, 38, 39, 40, 41, 336, 337,
+		42, 43, 45, 47, 339, 346, 340, 343, 341, 342, 48, 49, 50, 51, 344, 345,
+		52, 53, 54, 55, 347, 350, 348, 349, 56, 57, 58, 59, 351, 352, 60, 61,
+		62, 63, 354, 369, 355, 362, 356, 359, 357, 358, 64, 66, 67, 68, 360, 361,
+		70, 71, 72, 73, 363, 366, 364, 365, 74, 75, 76, 77, 367, 368, 80, 81,
+		82, 85, 370, 377, 371, 374, 372, 373, 86, 87, 88, 89, 375, 376, 90, 91,
+		92, 93, 378, 381, 379, 380, 94, 95, 96, 123, 382, 383, 124, 125, 126, 127,
+		385, 448, 386, 417, 387, 402, 388, 395, 389, 392, 390, 391, 128, 129, 130, 131,
+		393, 394, 132, 133, 134, 135, 396, 399, 397, 398, 136, 137, 138, 139, 400, 401,
+		140, 141, 142, 143, 403, 410, 404, 407, 405, 406, 144, 145, 146, 147, 408, 409,
+		148, 149, 150, 151, 411, 414, 412, 413, 152, 153, 154, 155, 415, 416, 156, 157,
+		158, 159, 418, 433, 419, 426, 420, 423, 421, 422, 160, 161, 162, 163, 424, 425,
+		164, 165, 166, 167, 427, 430, 428, 429, 168, 169, 170, 171, 431, 432, 172, 173,
+		174, 175, 434, 441, 435, 438, 436, 437, 176, 177, 178, 179, 439, 440, 180, 181,
+		182, 183, 442, 445, 443, 444, 184, 185, 186, 187, 446, 447, 188, 189, 190, 191,
+		449, 480, 450, 465, 451, 458, 452, 455, 453, 454, 192, 193, 194, 195, 456, 457,
+		196, 197, 198, 199, 459, 462, 460, 461, 200, 201, 202, 203, 463, 464, 204, 205,
+		206, 207, 466, 473, 467, 470, 468, 469, 208, 209, 210, 211, 471, 472, 212, 213,
+		214, 215, 474, 477, 475, 476, 216, 217, 218, 219, 478, 479, 220, 221, 222, 223,
+		481, 496, 482, 489, 483, 486, 484, 485, 224, 225, 226, 227, 487, 488, 228, 229,
+		230, 231, 490, 493, 491, 492, 232, 233, 234, 235, 494, 495, 236, 237, 238, 239,
+		497, 504, 498, 501, 499, 500, 240, 241, 242, 243, 502, 503, 244, 245, 246, 247,
+		505, 508, 506, 507, 248, 249, 250, 251, 509, 510, 252, 253, 254, 255
+	};
+
+	inline void encode(const unsigned char* data, size_t size, vector<unsigned char> &output)
+	{
+		/*	Adds the codes of the bytes to the end of output, padding the last byte. The codes of 5 bytes
+			always fit in one putBits, so they are merged first.
+		*/
+		VectorSink sink(output);
+		BitWriter writer(sink, 64 << 10);
+		size_t i = 0;
+		for (; i + 5 <= size; i += 5) writer.putBits(((((CODES[data[i]] << LENGTHS[data[i + 1]] | CODES[data[i + 1]]) << LENGTHS[data[i + 2]] | CODES[data[i + 2]]) << LENGTHS[data[i + 3]] | CODES[data[i + 3]]) << LENGTHS[data[i + 4]] | CODES[data[i + 4]]), LENGTHS[data[i]] + LENGTHS[data[i + 1]] + LENGTHS[data[i + 2]] + LENGTHS[data[i + 3]] + LENGTHS[data[i + 4]]);
+		for (; i < size; i++) writer.putBits(CODES[data[i]], LENGTHS[data[i]]);
+		if (writer.pendingBits() != 0) writer.putBits(PADDING[writer.pendingBits()], 8 - writer.pendingBits());
+		writer.finish();
+	}
+
+	inline void decode(const unsigned char* encoded, size_t size, vector<unsigned char> &output)
+	{
+		/*	Adds the bytes decoded from encode's bits to the end of output, dropping the padding. Each refill
+			of the bit buffer is followed by 5 lookups of the primary table, which is as many as it always covers.
+			The last bytes of input are decoded by walking the tree, as HuffmanTree::decodeBits does.
+		*/
+		const size_t BLOCK_SIZE = 64 << 10;
+		const unsigned char* input = encoded;
+		const unsigned char* input_limit = size > 48 ? encoded + size - 48 : encoded;
+		unsigned char block[BLOCK_SIZE + 10];
+		unsigned char* next = block;
+		uint64_t bit_buffer = 0;
+		unsigned int bit_count = 0;
+		while (input < input_limit)
+		{
+			if (next - block >= ptrdiff_t(BLOCK_SIZE))
+			{
+				output.insert(output.end(), block, next);
+				next = block;
+			}
+			bit_buffer |= loadBigEndian64(input) >> bit_count;
+			input += (63 - bit_count) >> 3;
+			bit_count |= 56;
+			uint32_t entry;
+
+			entry = DECODE_TABLE[bit_buffer >> 53];
+			next[0] = (unsigned char)(entry);
+			next[1] = (unsigned char)(entry >> 8);
+			next += (entry >> 24) & 3;
+			bit_buffer <<= (entry >> 16) & 0xFF;
+			bit_count -= (entry >> 16) & 0xFF;
+
+			entry = DECODE_TABLE[bit_buffer >> 53];
+			next[0] = (unsigned char)(entry);
+			next[1] = (unsigned char)(entry >> 8);
+			next += (entry >> 24) & 3;
+			bit_buffer <<= (entry >> 16) & 0xFF;
+			bit_count -= (entry >> 16) & 0xFF;
+
+			entry = DECODE_TABLE[bit_buffer >> 53];
+			next[0] = (unsigned char)(entry);
+			next[1] = (unsigned char)(entry >> 8);
+			next += (entry >> 24) & 3;
+			bit_buffer <<= (entry >> 16) & 0xFF;
+			bit_count -= (entry >> 16) & 0xFF;
+
+			entry = DECODE_TABLE[bit_buffer >> 53];
+			next[0] = (unsigned char)(entry);
+			next[1] = (unsigned char)(entry >> 8);
+			next += (entry >> 24) & 3;
+			bit_buffer <<= (entry >> 16) & 0xFF;
+			bit_count -= (entry >> 16) & 0xFF;
+
+			entry = DECODE_TABLE[bit_buffer >> 53];
+			next[0] = (unsigned char)(entry);
+			next[1] = (unsigned char)(entry >> 8);
+			next += (entry >> 24) & 3;
+			bit_buffer <<= (entry >> 16) & 0xFF;
+			bit_count -= (entry >> 16) & 0xFF;
+		}
+
+		size_t bit_position = size_t(input - encoded) * 8 - bit_count;
+		uint16_t node = ROOT;
+		for (size_t end_position = size * 8; bit_position < end_position; bit_position++)
+		{
+			node = CHILDREN[node - 256][(encoded[bit_position >> 3] >> (7 - (bit_position & 7))) & 1];
+			if (node >= 256) continue;
+			*next++ = (unsigned char)(node);
+			node = ROOT;
+			if (next - block >= ptrdiff_t(BLOCK_SIZE))
+			{
+				output.insert(output.end(), block, next);
+				next = block;
+			}
+		}
+		output.insert(output.end(), block, next);
+	}
+}
@@ -0,0 +1,242 @@
+//	File:			suite.cpp
+//	Description:	The benchmark suite: times EncodeFile, DecodeFile, building trees from byte counts and rebuilding
+//					them from headers, over every file of the generated corpus. Each result is one JSON object per
+//					line on stdout (sizes in bytes, times in seconds, peak memory in kilobytes), so the output of
+//					two commits can be saved and compared line by line. Every decoded file is checked against the
+//					original, and the suite stops with an error if they differ.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include "../HUFF/huffman.h"
+#include "corpus.h"
+#include "bench.h"
+
+using namespace std;
+
+static const double MINIMUM_SECONDS = 0.5;				// Each measurement repeats until it has run for this long...
+static const size_t MAXIMUM_REPEATS = 50;				// ...or this many times, and the fastest run is kept.
+static const size_t TREE_ITERATIONS = 2000;				// The number of trees built (or rebuilt) per measurement.
+
+struct SuiteResult
+{
+	/*	One line of the suite's output. */
+
+	const char* benchmark;
+	int kind;
+	uint64_t size;										// The size of the original file.
+	uint64_t output_size;								// The size of the encoded file (0 if nothing was encoded).
+	double seconds;										// The fastest time for one run (or one tree).
+	size_t repeats;
+	uint64_t peak_kb;
+};
+
+static string label = "";								// Copied into every line, to tell runs apart (such as by commit).
+
+static uint64_t fileSize(const string &path)
+{
+	ifstream file(path, ios::binary | ios::ate);
+	return file ? uint64_t(file.tellg()) : 0;
+}
+
+static void printResult(const SuiteResult &result)
+{
+	/*	Prints a result as a line of JSON. Rates that have no meaning (for empty files,
+		or trees, which aren't measured per byte) are null.
+	*/
+	printf("{\"label\":\"%s\",\"benchmark\":\"%s\",\"kind\":\"%s\",\"size\":%llu", label.c_str(), result.benchmark,
+		CORPUS_KIND_NAMES[result.kind], (unsigned long long)result.size);
+	if (result.output_size > 0) printf(",\"output_size\":%llu", (unsigned long long)result.output_size);
+	printf(",\"seconds\":%.9f,\"repeats\":%zu", result.seconds, result.repeats);
+	bool per_byte = result.size > 0 && result.output_size > 0;
+	if (per_byte) printf(",\"mb_per_s\":%.3f,\"ns_per_byte\":%.4f,\"ratio\":%.6f",
+		result.size / result.seconds / 1e6, result.seconds * 1e9 / result.size, double(result.output_size) / result.size);
+	else printf(",\"mb_per_s\":null,\"ns_per_byte\":null,\"ratio\":null");
+	printf(",\"peak_rss_kb\":%llu}\n", (unsigned long long)result.peak_kb);
+	fflush(stdout);
+}
+
+template <class Operation> static void timeRepeats(SuiteResult &result, Operation operation)
+{
+	/*	Runs the operation until MINIMUM_SECONDS have passed (at least once, at most MAXIMUM_REPEATS times),
+		keeping the fastest time and the peak memory it reached.
+	*/
+	resetPeakMemory();
+	result.repeats = 0;
+	result.seconds = 0;
+	auto begin = chrono::steady_clock::now();
+	do
+	{
+		auto run_begin = chrono::steady_clock::now();
+		operation();
+		double seconds = secondsSince(run_begin);
+		if (result.repeats == 0 || seconds < result.seconds) result.seconds = seconds;
+		result.repeats++;
+	} while (result.repeats < MAXIMUM_REPEATS && secondsSince(begin) < MINIMUM_SECONDS);
+	result.peak_kb = peakMemoryKB();
+}
+
+static bool sameContents(const string &first_path, const string &second_path)
+{
+	/*	Compares two files a block at a time. */
+	InputFile first, second;
+	if (!first.open(first_path) || !second.open(second_path) || first.size() != second.size()) return false;
+	vector<unsigned char> first_buffer, second_buffer;
+	while (true)
+	{
+		byte_span first_block, second_block;
+		size_t size = first.nextBlock(first_block, InputFile::BLOCK_SIZE, first_buffer);
+		if (second.nextBlock(second_block, InputFile::BLOCK_SIZE, second_buffer) != size) return false;
+		if (size == 0) return true;
+		if (memcmp(first_block.data, second_block.data, size) != 0) return false;
+	}
+}
+
+static void benchTrees(const string &path, int kind, uint64_t size, const HuffmanOptions &options)
+{
+	/*	Times making a tree from the file's byte counts (the way createTree does, limited or not),
+		and rebuilding it from its header (the way rebuildTree does before decoding).
+	*/
+	InputFile file_input;
+	if (!file_input.open(path)) return;
+	uint64_t counts[256] = { 0 };
+	vector<unsigned char> buffer;
+	byte_span block;
+	while (file_input.nextBlock(block, InputFile::BLOCK_SIZE, buffer) > 0) buildHistogram(block.data, block.size, counts, defaultThreadCount());
+
+	SuiteResult result = { "createTree", kind, size, 0, 0, 0, 0 };
+	vector<unsigned char> header;
+	timeRepeats(result, [&]()
+	{
+		for (size_t i = 0; i < TREE_ITERATIONS; i++)
+		{
+			HuffmanTree tree;
+			tree.setWeights(counts);
+			if (options.max_code_length > 0) tree.createLimitedTree(options.max_code_length);
+			else tree.createTree();
+			result_sink = tree.headerSize();
+			if (i == 0 && header.empty())
+			{
+				header.resize(tree.headerSize());
+				tree.writeHeader(header.data());
+			}
+		}
+	});
+	result.seconds /= TREE_ITERATIONS;
+	printResult(result);
+
+	result.benchmark = "rebuildTree";
+	timeRepeats(result, [&]()
+	{
+		HuffmanTree tree;
+		for (size_t i = 0; i < TREE_ITERATIONS; i++)
+		{
+			tree.readHeader(header.data(), header.size());
+			tree.buildDecodeTable();
+			result_sink = tree.headerSize();
+		}
+	});
+	result.seconds /= TREE_ITERATIONS;
+	printResult(result);
+}
+
+static bool benchFile(const string &directory, int kind, uint64_t size, const HuffmanOptions &options)
+{
+	/*	Times encoding and decoding one corpus file (through temporary files in the corpus
+		directory), checks that it decodes to the original, then times its trees.
+	*/
+	string path = corpusPath(directory, kind, size);
+	string encoded_path = directory + "/suite-encoded.huf";
+	string decoded_path = directory + "/suite-decoded.bin";
+	Huffman huffman;
+	huffman.setOptions(options);
+
+	SuiteResult result = { "EncodeFile", kind, size, 0, 0, 0, 0 };
+	timeRepeats(result, [&]() { huffman.EncodeFile(path, encoded_path); });
+	result.output_size = fileSize(encoded_path);
+	printResult(result);
+
+	result.benchmark = "DecodeFile";
+	timeRepeats(result, [&]() { huffman.DecodeFile(encoded_path, decoded_path); });
+	printResult(result);
+
+	bool same = sameContents(path, decoded_path);
+	remove(encoded_path.c_str());
+	remove(decoded_path.c_str());
+	if (!same)
+	{
+		fprintf(stderr, "suite: %s did not decode to the original\n", path.c_str());
+		return false;
+	}
+	if (size > 0) benchTrees(path, kind, size, options);
+	return true;
+}
+
+static bool parseArguments(int argc, char* argv[], string &directory, uint64_t &max_size, HuffmanOptions &options)
+{
+	/*	Reads the directory, the optional maximum size, and the options that are passed on to the coder. */
+	int position = 0;
+	for (int i = 0; i < argc; i++)
+	{
+		string argument = argv[i];
+		if (argument == "--chunked") options.chunked = true;
+		else if (argument == "--interleaved") options.interleaved = true;
+		else if (argument == "--adaptive") options.adaptive = true;
+		else if (argument == "--checksum") options.checksum = true;
+		else if (argument == "--context") options.context = true;
+		else if (argument.compare(0, 10, "--threads=") == 0) options.threads = (unsigned int)strtoul(argv[i] + 10, NULL, 10);
+		else if (argument.compare(0, 13, "--max-length=") == 0) options.max_code_length = (unsigned int)strtoul(argv[i] + 13, NULL, 10);
+		else if (argument.compare(0, 8, "--label=") == 0) label = argument.substr(8);
+		else if (argument.compare(0, 2, "--") == 0) return false;
+		else if (position == 0) directory = argument, position++;
+		else if (position == 1 && parseSize(argv[i], max_size)) position++;
+		else return false;
+	}
+	return position > 0;
+}
+
+int benchCorpus(int argc, char* argv[])
+{
+	/*	Makes the corpus without timing anything (the suite also makes it, as needed). */
+	string directory;
+	uint64_t max_size = 16 << 20;
+	HuffmanOptions options;
+	if (!parseArguments(argc, argv, directory, max_size, options))
+	{
+		fprintf(stderr, "Usage: HUFFBENCH corpus <directory> [max size, such as 16M or 4G]\n");
+		return 1;
+	}
+	return makeCorpus(directory, max_size) ? 0 : 1;
+}
+
+int benchSuite(int argc, char* argv[])
+{
+	/*	Makes the corpus (up to 16M unless told otherwise), then times every file of it, smallest first. */
+	string directory;
+	uint64_t max_size = 16 << 20;
+	HuffmanOptions options;
+	if (!parseArguments(argc, argv, directory, max_size, options))
+	{
+		fprintf(stderr, "Usage: HUFFBENCH suite <directory> [max size] [--chunked] [--interleaved] [--adaptive] [--checksum] [--context] [--threads=N] [--max-length=N] [--label=NAME]\n");
+		return 1;
+	}
+	if (!makeCorpus(directory, max_size)) return 1;
+
+	try
+	{
+		for (uint64_t size : corpusSizes(max_size))
+		{
+			for (int kind = 0; kind < CORPUS_KINDS; kind++)
+			{
+				if (!benchFile(directory, kind, size, options)) return 1;
+			}
+		}
+	}
+	catch (const HuffmanError &error)
+	{
+		fprintf(stderr, "suite: %s\n", error.what());
+		return 1;
+	}
+	return 0;
+}